@@ -0,0 +1,73 @@
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <log_surgeon/BufferParser.hpp>
+#include <log_surgeon/Constants.hpp>
+#include <log_surgeon/Lexer.hpp>
+#include <log_surgeon/Schema.hpp>
+
+using namespace std;
+using namespace log_surgeon;
+
+namespace {
+/**
+ * Parses the entire input.
+ * @param parser
+ * @param input
+ * @return The number of bytes the lexer scanned per input byte.
+ */
+auto get_scanned_bytes_per_input_byte(BufferParser& parser, string& input) -> double {
+    parser.reset();
+    size_t offset{0};
+    while (false == parser.done()) {
+        if (ErrorCode::Success != parser.parse_next_event(input.data(), input.size(), offset, true))
+        {
+            throw runtime_error("Parsing Failed.");
+        }
+    }
+    return static_cast<double>(parser.get_log_parser().get_num_scanned_bytes())
+           / static_cast<double>(input.size());
+}
+}  // namespace
+
+/**
+ * Prints how many bytes the lexer scans per input byte in each lexing mode, on inputs of growing
+ * size for which every failed match attempt runs to the end of the input.
+ */
+auto main() -> int {
+    Schema schema;
+    schema.add_delimiters(R"(delimiters: \n\r\[:,)");
+    schema.add_variable("list:x( x)*y", -1);
+    BufferParser parser{std::move(schema.release_schema_ast_ptr())};
+
+    vector<pair<string, LexingMode>> const modes{
+            {"incremental", LexingMode::Incremental},
+            {"linear", LexingMode::Linear}
+    };
+
+    cout << "# Bytes scanned per input byte for \" x x ... x\" with \"list:x( x)*y\"" << endl;
+    cout << setw(12) << "input size";
+    for (auto const& [name, mode] : modes) {
+        cout << setw(14) << name;
+    }
+    cout << endl;
+    for (uint32_t num_repetitions{1000}; num_repetitions <= 16'000; num_repetitions *= 2) {
+        string input;
+        for (uint32_t i{0}; i < num_repetitions; ++i) {
+            input += " x";
+        }
+        cout << setw(12) << input.size();
+        for (auto const& [name, mode] : modes) {
+            parser.set_lexing_mode(mode);
+            cout << setw(14) << fixed << setprecision(2)
+                 << get_scanned_bytes_per_input_byte(parser, input);
+        }
+        cout << endl;
+    }
+    return 0;
+}
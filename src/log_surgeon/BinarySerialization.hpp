@@ -0,0 +1,243 @@
+#ifndef LOG_SURGEON_BINARY_SERIALIZATION_HPP
+#define LOG_SURGEON_BINARY_SERIALIZATION_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fmt/core.h>
+
+namespace log_surgeon {
+/**
+ * Appends values to a binary buffer in the host's byte order.
+ *
+ * Trivially copyable values are copied as is, and vectors and strings are prefixed with their
+ * size. Since the byte order and the layout of the values are the host's, a buffer can only be read
+ * back on hosts like the one that wrote it, which `seal_binary_blob` guards against.
+ */
+class BinaryWriter {
+public:
+    template <typename T>
+    requires std::is_trivially_copyable_v<T>
+    auto write(T const& value) -> void {
+        auto const* bytes{reinterpret_cast<uint8_t const*>(&value)};
+        m_bytes.insert(m_bytes.end(), bytes, bytes + sizeof(T));
+    }
+
+    template <typename T>
+    requires std::is_trivially_copyable_v<T>
+    auto write_vector(std::vector<T> const& values) -> void {
+        write(static_cast<uint64_t>(values.size()));
+        auto const* bytes{reinterpret_cast<uint8_t const*>(values.data())};
+        m_bytes.insert(m_bytes.end(), bytes, bytes + values.size() * sizeof(T));
+    }
+
+    auto write_string(std::string_view const value) -> void {
+        write(static_cast<uint64_t>(value.size()));
+        m_bytes.insert(m_bytes.end(), value.begin(), value.end());
+    }
+
+    /**
+     * Writes a sequence of values aligned for `T`, relative to the start of the buffer, so that
+     * `BinaryReader::read_aligned_span` can return it in place.
+     * @param values
+     */
+    template <typename T>
+    requires std::is_trivially_copyable_v<T>
+    auto write_aligned_span(std::span<T const> const values) -> void {
+        write(static_cast<uint64_t>(values.size()));
+        m_bytes.resize((m_bytes.size() + alignof(T) - 1) / alignof(T) * alignof(T), 0);
+        auto const* bytes{reinterpret_cast<uint8_t const*>(values.data())};
+        m_bytes.insert(m_bytes.end(), bytes, bytes + values.size() * sizeof(T));
+    }
+
+    [[nodiscard]] auto get_bytes() const -> std::vector<uint8_t> const& { return m_bytes; }
+
+    [[nodiscard]] auto release_bytes() -> std::vector<uint8_t> { return std::move(m_bytes); }
+
+private:
+    std::vector<uint8_t> m_bytes;
+};
+
+/**
+ * Reads back the values appended by a `BinaryWriter`, in the same order.
+ */
+class BinaryReader {
+public:
+    /**
+     * @param bytes The buffer to read, which must outlive the reader.
+     */
+    explicit BinaryReader(std::span<uint8_t const> const bytes) : m_bytes{bytes} {}
+
+    /**
+     * @return The next value.
+     * @throw std::runtime_error if the buffer ends before the value.
+     */
+    template <typename T>
+    requires std::is_trivially_copyable_v<T>
+    auto read() -> T {
+        T value;
+        std::memcpy(&value, consume(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    /**
+     * @return The next vector.
+     * @throw std::runtime_error if the buffer ends before the vector.
+     */
+    template <typename T>
+    requires std::is_trivially_copyable_v<T>
+    auto read_vector() -> std::vector<T> {
+        auto const size{read_size(sizeof(T))};
+        std::vector<T> values(size);
+        if (0 != size) {
+            std::memcpy(values.data(), consume(size * sizeof(T)), size * sizeof(T));
+        }
+        return values;
+    }
+
+    /**
+     * @return The next string.
+     * @throw std::runtime_error if the buffer ends before the string.
+     */
+    auto read_string() -> std::string {
+        auto const size{read_size(1)};
+        auto const* bytes{reinterpret_cast<char const*>(consume(size))};
+        return {bytes, size};
+    }
+
+    /**
+     * @return The next sequence written by `BinaryWriter::write_aligned_span`, in place. It is only
+     * valid while the buffer is.
+     * @throw std::runtime_error if the buffer ends before the sequence, or if the buffer isn't
+     * aligned like the one that was written.
+     */
+    template <typename T>
+    requires std::is_trivially_copyable_v<T>
+    auto read_aligned_span() -> std::span<T const> {
+        auto const size{read<uint64_t>()};
+        auto const padding{(alignof(T) - m_pos % alignof(T)) % alignof(T)};
+        consume(std::min(padding, m_bytes.size() - m_pos));
+        if (size > (m_bytes.size() - m_pos) / sizeof(T)) {
+            throw std::runtime_error("Binary data is truncated.");
+        }
+        auto const* values{consume(static_cast<size_t>(size) * sizeof(T))};
+        if (0 != reinterpret_cast<uintptr_t>(values) % alignof(T)) {
+            throw std::runtime_error("Binary data is misaligned.");
+        }
+        return {reinterpret_cast<T const*>(values), static_cast<size_t>(size)};
+    }
+
+    /**
+     * Reads the number of elements in a sequence that follows.
+     * @param element_size
+     * @return The size.
+     * @throw std::runtime_error if the elements can't fit in the rest of the buffer.
+     */
+    auto read_size(size_t const element_size) -> size_t {
+        auto const size{read<uint64_t>()};
+        if (size > (m_bytes.size() - m_pos) / element_size) {
+            throw std::runtime_error("Binary data is truncated.");
+        }
+        return static_cast<size_t>(size);
+    }
+
+    [[nodiscard]] auto is_done() const -> bool { return m_bytes.size() == m_pos; }
+
+private:
+    /**
+     * @param num_bytes
+     * @return A pointer to the next `num_bytes` bytes, which are consumed.
+     * @throw std::runtime_error if fewer than `num_bytes` bytes are left.
+     */
+    auto consume(size_t const num_bytes) -> uint8_t const* {
+        if (num_bytes > m_bytes.size() - m_pos) {
+            throw std::runtime_error("Binary data is truncated.");
+        }
+        auto const* bytes{m_bytes.data() + m_pos};
+        m_pos += num_bytes;
+        return bytes;
+    }
+
+    std::span<uint8_t const> m_bytes;
+    size_t m_pos{0};
+};
+
+/**
+ * @param bytes
+ * @return The 64-bit FNV-1a hash of `bytes`.
+ */
+[[nodiscard]] inline auto get_binary_checksum(std::span<uint8_t const> const bytes) -> uint64_t {
+    constexpr uint64_t cOffsetBasis{0xcbf2'9ce4'8422'2325};
+    constexpr uint64_t cPrime{0x100'0000'01b3};
+    auto hash{cOffsetBasis};
+    for (auto const byte : bytes) {
+        hash = (hash ^ byte) * cPrime;
+    }
+    return hash;
+}
+
+/**
+ * Prefixes a payload with a header identifying its format, so that `unseal_binary_blob` can reject
+ * blobs of another format, another version of the format, or corrupted blobs.
+ * @param magic Identifies the format.
+ * @param version The version of the format.
+ * @param payload
+ * @return The blob.
+ */
+[[nodiscard]] inline auto
+seal_binary_blob(uint32_t const magic, uint32_t const version, std::span<uint8_t const> payload)
+        -> std::vector<uint8_t> {
+    BinaryWriter writer;
+    writer.write(magic);
+    writer.write(version);
+    writer.write(get_binary_checksum(payload));
+    auto blob{writer.release_bytes()};
+    blob.insert(blob.end(), payload.begin(), payload.end());
+    return blob;
+}
+
+/**
+ * @param magic The format the blob must have.
+ * @param version The version of the format the blob must have.
+ * @param blob A blob returned by `seal_binary_blob`.
+ * @return The blob's payload.
+ * @throw std::runtime_error if the blob isn't of the given format and version, or if its payload
+ * doesn't match its checksum. Since the magic is written in the host's byte order, a blob written
+ * on a host with a different byte order is rejected as being of another format.
+ */
+[[nodiscard]] inline auto unseal_binary_blob(
+        uint32_t const magic,
+        uint32_t const version,
+        std::span<uint8_t const> const blob
+) -> std::span<uint8_t const> {
+    BinaryReader reader{blob};
+    if (magic != reader.read<uint32_t>()) {
+        throw std::runtime_error("Binary data is not in the expected format.");
+    }
+    if (auto const blob_version{reader.read<uint32_t>()}; version != blob_version) {
+        throw std::runtime_error(fmt::format(
+                "Binary data has version {}, but only version {} is supported.",
+                blob_version,
+                version
+        ));
+    }
+    auto const checksum{reader.read<uint64_t>()};
+    constexpr size_t cHeaderSize{sizeof(uint32_t) * 2 + sizeof(uint64_t)};
+    auto const payload{blob.subspan(cHeaderSize)};
+    if (checksum != get_binary_checksum(payload)) {
+        throw std::runtime_error("Binary data doesn't match its checksum.");
+    }
+    return payload;
+}
+}  // namespace log_surgeon
+
+#endif  // LOG_SURGEON_BINARY_SERIALIZATION_HPP
@@ -20,8 +20,10 @@ namespace log_surgeon {
  * valid until reset() is called and the buffer returns to using the underlying
  * static buffer. The base class does not grow the buffer itself, the child
  * class is responsible for doing this.
+ * @tparam Item
+ * @tparam cStaticSize The number of items in the static buffer.
  */
-template <typename Item>
+template <typename Item, uint32_t cStaticSize = cStaticByteBuffSize>
 class Buffer {
 public:
     auto set_curr_value(Item const& value) -> void { m_active_storage[m_pos] = value; }
@@ -50,7 +52,7 @@ public:
         m_active_size *= 2;
     }
 
-    [[nodiscard]] auto static_size() const -> uint32_t { return cStaticByteBuffSize; }
+    [[nodiscard]] auto static_size() const -> uint32_t { return cStaticSize; }
 
     [[nodiscard]] auto size() const -> uint32_t { return m_active_size; }
 
@@ -58,7 +60,7 @@ public:
         m_pos = 0;
         m_dynamic_storages.clear();
         m_active_storage = m_static_storage;
-        m_active_size = cStaticByteBuffSize;
+        m_active_size = cStaticSize;
     }
 
     auto set_active_buffer(Item* storage, uint32_t size, uint32_t pos) -> void {
@@ -86,9 +88,9 @@ public:
 
 private:
     uint32_t m_pos{0};
-    uint32_t m_active_size{cStaticByteBuffSize};
+    uint32_t m_active_size{cStaticSize};
     std::vector<std::vector<Item>> m_dynamic_storages;
-    Item m_static_storage[cStaticByteBuffSize];
+    Item m_static_storage[cStaticSize];
     Item* m_active_storage{m_static_storage};
 };
 }  // namespace log_surgeon
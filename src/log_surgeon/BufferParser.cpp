@@ -1,9 +1,14 @@
 #include "BufferParser.hpp"
 
+#include <cstdint>
+#include <memory>
+#include <span>
 #include <string>
+#include <utility>
 
 #include <log_surgeon/Constants.hpp>
 #include <log_surgeon/LogEvent.hpp>
+#include <log_surgeon/MappedFile.hpp>
 #include <log_surgeon/Schema.hpp>
 
 namespace log_surgeon {
@@ -13,9 +18,16 @@ BufferParser::BufferParser(std::unique_ptr<log_surgeon::SchemaAST> schema_ast)
 BufferParser::BufferParser(std::string const& schema_file_path)
         : m_log_parser(LogParser(schema_file_path)) {}
 
+BufferParser::BufferParser(std::span<uint8_t const> serialized_lexer)
+        : m_log_parser(serialized_lexer) {}
+
+BufferParser::BufferParser(std::shared_ptr<MappedFile const> lexer_image)
+        : m_log_parser(std::move(lexer_image)) {}
+
 auto BufferParser::reset() -> void {
     m_log_parser.reset();
     m_done = false;
+    m_last_buf = nullptr;
 }
 
 auto
@@ -25,7 +37,16 @@ BufferParser::parse_next_event(char* buf, size_t size, size_t& offset, bool fini
     // TODO in order to allow logs/tokens to wrap user buffers this function
     // will need more parameters or the input buffer may need to be exposed to
     // the user
-    m_log_parser.set_input_buffer(buf, size, offset, finished_reading_input);
+    if (m_input_unchanged_between_events && buf == m_last_buf && size == m_last_size
+        && finished_reading_input == m_last_finished_reading_input)
+    {
+        m_log_parser.set_pos_in_unchanged_input_buffer(offset);
+    } else {
+        m_log_parser.set_input_buffer(buf, size, offset, finished_reading_input);
+        m_last_buf = buf;
+        m_last_size = size;
+        m_last_finished_reading_input = finished_reading_input;
+    }
     LogParser::ParsingAction parsing_action{LogParser::ParsingAction::None};
     ErrorCode error_code = m_log_parser.parse_and_generate_metadata(parsing_action);
     if (ErrorCode::Success != error_code) {
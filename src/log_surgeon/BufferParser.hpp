@@ -1,11 +1,15 @@
 #ifndef LOG_SURGEON_BUFFER_PARSER_HPP
 #define LOG_SURGEON_BUFFER_PARSER_HPP
 
+#include <cstdint>
+#include <memory>
 #include <optional>
+#include <span>
 #include <string>
 
 #include <log_surgeon/LogEvent.hpp>
 #include <log_surgeon/LogParser.hpp>
+#include <log_surgeon/MappedFile.hpp>
 #include <log_surgeon/Schema.hpp>
 
 namespace log_surgeon {
@@ -34,6 +38,21 @@ public:
      */
     explicit BufferParser(std::unique_ptr<log_surgeon::SchemaAST> schema_ast);
 
+    /**
+     * Constructs the parser using a lexer serialized by LogParser::serialize_lexer.
+     * @param serialized_lexer
+     * @throw std::runtime_error from LogParser if the serialized lexer is
+     * invalid.
+     */
+    explicit BufferParser(std::span<uint8_t const> serialized_lexer);
+
+    /**
+     * Constructs the parser using a lexer image written by LogParser::serialize_lexer_image.
+     * @param lexer_image A mapping of the image, which the parser keeps alive.
+     * @throw std::runtime_error from LogParser if the image is invalid.
+     */
+    explicit BufferParser(std::shared_ptr<MappedFile const> lexer_image);
+
     /**
      * Clears the internal state of the log parser (lexer and input buffer) so
      * that the next call to parse_next_event will begin parsing from
@@ -75,6 +94,37 @@ public:
      */
     auto get_log_parser() const -> LogParser const& { return m_log_parser; }
 
+    /**
+     * Sets how the lexer finds tokens. All modes produce the same tokens.
+     * @param lexing_mode
+     */
+    auto set_lexing_mode(LexingMode lexing_mode) -> void {
+        m_log_parser.set_lexing_mode(lexing_mode);
+    }
+
+    /**
+     * Sets whether the captures of a token are only located when they're read. Either way, the
+     * parser produces the same tokens and captures.
+     * @param lazy_captures
+     */
+    auto set_lazy_captures(bool lazy_captures) -> void {
+        m_log_parser.set_lazy_captures(lazy_captures);
+    }
+
+    /**
+     * Sets whether the caller promises not to change the contents of the
+     * buffer passed to parse_next_event between calls with the same buffer,
+     * size and finished_reading_input, unless reset is called in between. The
+     * lexer can then reuse what it computed over the buffer for previous
+     * events, e.g., the delimiters marked by LexingMode::Linear, instead
+     * of recomputing it for every event. Disabled by default, since buffers are
+     * commonly refilled in place.
+     * @param input_unchanged_between_events
+     */
+    auto set_input_unchanged_between_events(bool input_unchanged_between_events) -> void {
+        m_input_unchanged_between_events = input_unchanged_between_events;
+    }
+
     /**
      * @param var The name of the variable as provided in the schema file or
      * when building the LogParser's Schema object.
@@ -96,6 +146,11 @@ public:
 private:
     LogParser m_log_parser;
     bool m_done{false};
+    bool m_input_unchanged_between_events{false};
+    // The arguments of the last call to parse_next_event since the last reset
+    char const* m_last_buf{nullptr};
+    size_t m_last_size{0};
+    bool m_last_finished_reading_input{false};
 };
 }  // namespace log_surgeon
 
@@ -0,0 +1,458 @@
+#include "ByteSet.hpp"
+
+#include <array>
+#include <bit>
+#include <cstdint>
+
+#include <log_surgeon/Constants.hpp>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    #define LOG_SURGEON_BYTE_SET_X86_KERNELS
+    #include <immintrin.h>
+#endif
+
+namespace log_surgeon {
+namespace {
+constexpr uint32_t cNibbleMask{0x0F};
+constexpr int cBitsPerWord{64};
+
+/**
+ * @param begin
+ * @param end
+ * @param is_member
+ * @return A pointer to the first member of the set in [begin, end), or `end` if there is none.
+ */
+auto find_first_scalar(
+        char const* begin,
+        char const* end,
+        std::array<bool, cSizeOfByte> const& is_member
+) -> char const*;
+
+/**
+ * Marks the members of the set in [begin, end), which must have a size of at most 64, in `word`.
+ * @param begin
+ * @param end
+ * @param is_member
+ * @param word Returns with bit `i` set if `begin[i]` is a member.
+ */
+auto find_all_scalar(
+        char const* begin,
+        char const* end,
+        std::array<bool, cSizeOfByte> const& is_member,
+        uint64_t& word
+) -> void;
+
+#ifdef LOG_SURGEON_BYTE_SET_X86_KERNELS
+/**
+ * Shuffle tables shared by every block searched with the SSE4.2 kernel.
+ */
+struct Sse42Tables {
+    __m128i m_low_table;
+    __m128i m_high_table;
+    __m128i m_high_nibble_bits;
+    __m128i m_nibble_mask;
+};
+
+/**
+ * Shuffle tables shared by every block searched with the AVX2 kernel.
+ */
+struct Avx2Tables {
+    __m256i m_low_table;
+    __m256i m_high_table;
+    __m256i m_high_nibble_bits;
+    __m256i m_nibble_mask;
+};
+
+/**
+ * @param low_half_table
+ * @param high_half_table
+ * @return The SSE4.2 shuffle tables of the set.
+ */
+__attribute__((target("sse4.2"))) auto
+load_sse42_tables(uint8_t const* low_half_table, uint8_t const* high_half_table) -> Sse42Tables;
+
+/**
+ * @param low_half_table
+ * @param high_half_table
+ * @return The AVX2 shuffle tables of the set.
+ */
+__attribute__((target("avx2"))) auto
+load_avx2_tables(uint8_t const* low_half_table, uint8_t const* high_half_table) -> Avx2Tables;
+
+/**
+ * @param pos A pointer to a block of 16 bytes.
+ * @param tables
+ * @return A mask with bit `i` set if `pos[i]` is a member of the set.
+ */
+__attribute__((target("sse4.2"))) auto
+get_members_sse42(char const* pos, Sse42Tables const& tables) -> uint32_t;
+
+/**
+ * @param pos A pointer to a block of 32 bytes.
+ * @param tables
+ * @return A mask with bit `i` set if `pos[i]` is a member of the set.
+ */
+__attribute__((target("avx2"))) auto
+get_members_avx2(char const* pos, Avx2Tables const& tables) -> uint32_t;
+
+/**
+ * @param begin
+ * @param end
+ * @param low_half_table
+ * @param high_half_table
+ * @param is_member
+ * @return A pointer to the first member of the set in [begin, end), or `end` if there is none.
+ */
+__attribute__((target("sse4.2"))) auto find_first_sse42(
+        char const* begin,
+        char const* end,
+        uint8_t const* low_half_table,
+        uint8_t const* high_half_table,
+        std::array<bool, cSizeOfByte> const& is_member
+) -> char const*;
+
+/**
+ * @param begin
+ * @param end
+ * @param low_half_table
+ * @param high_half_table
+ * @param is_member
+ * @return A pointer to the first member of the set in [begin, end), or `end` if there is none.
+ */
+__attribute__((target("avx2"))) auto find_first_avx2(
+        char const* begin,
+        char const* end,
+        uint8_t const* low_half_table,
+        uint8_t const* high_half_table,
+        std::array<bool, cSizeOfByte> const& is_member
+) -> char const*;
+
+/**
+ * Marks the members of the set in [begin, end) in `bitmap`.
+ * @param begin
+ * @param end
+ * @param low_half_table
+ * @param high_half_table
+ * @param is_member
+ * @param bitmap
+ */
+__attribute__((target("sse4.2"))) auto find_all_sse42(
+        char const* begin,
+        char const* end,
+        uint8_t const* low_half_table,
+        uint8_t const* high_half_table,
+        std::array<bool, cSizeOfByte> const& is_member,
+        uint64_t* bitmap
+) -> void;
+
+/**
+ * Marks the members of the set in [begin, end) in `bitmap`.
+ * @param begin
+ * @param end
+ * @param low_half_table
+ * @param high_half_table
+ * @param is_member
+ * @param bitmap
+ */
+__attribute__((target("avx2"))) auto find_all_avx2(
+        char const* begin,
+        char const* end,
+        uint8_t const* low_half_table,
+        uint8_t const* high_half_table,
+        std::array<bool, cSizeOfByte> const& is_member,
+        uint64_t* bitmap
+) -> void;
+#endif
+
+auto find_first_scalar(
+        char const* begin,
+        char const* end,
+        std::array<bool, cSizeOfByte> const& is_member
+) -> char const* {
+    for (auto const* pos{begin}; pos < end; ++pos) {
+        if (is_member[static_cast<uint8_t>(*pos)]) {
+            return pos;
+        }
+    }
+    return end;
+}
+
+auto find_all_scalar(
+        char const* begin,
+        char const* end,
+        std::array<bool, cSizeOfByte> const& is_member,
+        uint64_t& word
+) -> void {
+    word = 0;
+    for (auto const* pos{begin}; pos < end; ++pos) {
+        if (is_member[static_cast<uint8_t>(*pos)]) {
+            word |= uint64_t{1} << static_cast<uint32_t>(pos - begin);
+        }
+    }
+}
+
+#ifdef LOG_SURGEON_BYTE_SET_X86_KERNELS
+__attribute__((target("sse4.2"))) auto
+load_sse42_tables(uint8_t const* low_half_table, uint8_t const* high_half_table) -> Sse42Tables {
+    return {
+            _mm_load_si128(reinterpret_cast<__m128i const*>(low_half_table)),
+            _mm_load_si128(reinterpret_cast<__m128i const*>(high_half_table)),
+            // Maps a high nibble `h` to the bit `h % 8` of its table entry
+            _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128),
+            _mm_set1_epi8(static_cast<char>(cNibbleMask))
+    };
+}
+
+__attribute__((target("avx2"))) auto
+load_avx2_tables(uint8_t const* low_half_table, uint8_t const* high_half_table) -> Avx2Tables {
+    return {
+            _mm256_broadcastsi128_si256(
+                    _mm_load_si128(reinterpret_cast<__m128i const*>(low_half_table))
+            ),
+            _mm256_broadcastsi128_si256(
+                    _mm_load_si128(reinterpret_cast<__m128i const*>(high_half_table))
+            ),
+            // Maps a high nibble `h` to the bit `h % 8` of its table entry
+            _mm256_broadcastsi128_si256(
+                    _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128)
+            ),
+            _mm256_set1_epi8(static_cast<char>(cNibbleMask))
+    };
+}
+
+__attribute__((target("sse4.2"))) auto
+get_members_sse42(char const* pos, Sse42Tables const& tables) -> uint32_t {
+    constexpr uint32_t cAllLanes{0xFFFF};
+    auto const bytes{_mm_loadu_si128(reinterpret_cast<__m128i const*>(pos))};
+    auto const low_nibbles{_mm_and_si128(bytes, tables.m_nibble_mask)};
+    auto const high_nibbles{_mm_and_si128(_mm_srli_epi16(bytes, 4), tables.m_nibble_mask)};
+    // `blendv` selects on the most significant bit of each byte, which picks the table
+    auto const rows{_mm_blendv_epi8(
+            _mm_shuffle_epi8(tables.m_low_table, low_nibbles),
+            _mm_shuffle_epi8(tables.m_high_table, low_nibbles),
+            bytes
+    )};
+    auto const bits{_mm_shuffle_epi8(tables.m_high_nibble_bits, high_nibbles)};
+    auto const non_members{_mm_cmpeq_epi8(_mm_and_si128(rows, bits), _mm_setzero_si128())};
+    return static_cast<uint32_t>(_mm_movemask_epi8(non_members)) ^ cAllLanes;
+}
+
+__attribute__((target("avx2"))) auto
+get_members_avx2(char const* pos, Avx2Tables const& tables) -> uint32_t {
+    auto const bytes{_mm256_loadu_si256(reinterpret_cast<__m256i const*>(pos))};
+    auto const low_nibbles{_mm256_and_si256(bytes, tables.m_nibble_mask)};
+    auto const high_nibbles{_mm256_and_si256(_mm256_srli_epi16(bytes, 4), tables.m_nibble_mask)};
+    auto const rows{_mm256_blendv_epi8(
+            _mm256_shuffle_epi8(tables.m_low_table, low_nibbles),
+            _mm256_shuffle_epi8(tables.m_high_table, low_nibbles),
+            bytes
+    )};
+    auto const bits{_mm256_shuffle_epi8(tables.m_high_nibble_bits, high_nibbles)};
+    auto const non_members{
+            _mm256_cmpeq_epi8(_mm256_and_si256(rows, bits), _mm256_setzero_si256())
+    };
+    return ~static_cast<uint32_t>(_mm256_movemask_epi8(non_members));
+}
+
+__attribute__((target("sse4.2"))) auto find_first_sse42(
+        char const* begin,
+        char const* end,
+        uint8_t const* low_half_table,
+        uint8_t const* high_half_table,
+        std::array<bool, cSizeOfByte> const& is_member
+) -> char const* {
+    constexpr int cBlockSize{16};
+    auto const tables{load_sse42_tables(low_half_table, high_half_table)};
+    auto const* pos{begin};
+    for (; end - pos >= cBlockSize; pos += cBlockSize) {
+        if (auto const members{get_members_sse42(pos, tables)}; 0 != members) {
+            return pos + std::countr_zero(members);
+        }
+    }
+    return find_first_scalar(pos, end, is_member);
+}
+
+__attribute__((target("avx2"))) auto find_first_avx2(
+        char const* begin,
+        char const* end,
+        uint8_t const* low_half_table,
+        uint8_t const* high_half_table,
+        std::array<bool, cSizeOfByte> const& is_member
+) -> char const* {
+    constexpr int cBlockSize{32};
+    auto const tables{load_avx2_tables(low_half_table, high_half_table)};
+    auto const* pos{begin};
+    for (; end - pos >= cBlockSize; pos += cBlockSize) {
+        if (auto const members{get_members_avx2(pos, tables)}; 0 != members) {
+            return pos + std::countr_zero(members);
+        }
+    }
+    // Any CPU with AVX2 also supports SSE4.2, which handles a remaining half block
+    return find_first_sse42(pos, end, low_half_table, high_half_table, is_member);
+}
+
+__attribute__((target("sse4.2"))) auto find_all_sse42(
+        char const* begin,
+        char const* end,
+        uint8_t const* low_half_table,
+        uint8_t const* high_half_table,
+        std::array<bool, cSizeOfByte> const& is_member,
+        uint64_t* bitmap
+) -> void {
+    constexpr int cBlockSize{16};
+    auto const tables{load_sse42_tables(low_half_table, high_half_table)};
+    auto const* pos{begin};
+    for (; end - pos >= cBitsPerWord; pos += cBitsPerWord) {
+        uint64_t word{0};
+        for (int offset{0}; offset < cBitsPerWord; offset += cBlockSize) {
+            word |= static_cast<uint64_t>(get_members_sse42(pos + offset, tables)) << offset;
+        }
+        *bitmap++ = word;
+    }
+    if (pos < end) {
+        find_all_scalar(pos, end, is_member, *bitmap);
+    }
+}
+
+__attribute__((target("avx2"))) auto find_all_avx2(
+        char const* begin,
+        char const* end,
+        uint8_t const* low_half_table,
+        uint8_t const* high_half_table,
+        std::array<bool, cSizeOfByte> const& is_member,
+        uint64_t* bitmap
+) -> void {
+    constexpr int cBlockSize{32};
+    auto const tables{load_avx2_tables(low_half_table, high_half_table)};
+    auto const* pos{begin};
+    for (; end - pos >= cBitsPerWord; pos += cBitsPerWord) {
+        *bitmap++ = static_cast<uint64_t>(get_members_avx2(pos, tables))
+                    | static_cast<uint64_t>(get_members_avx2(pos + cBlockSize, tables))
+                              << cBlockSize;
+    }
+    if (pos < end) {
+        find_all_scalar(pos, end, is_member, *bitmap);
+    }
+}
+#endif
+}  // namespace
+
+ByteSet::ByteSet(std::array<bool, cSizeOfByte> const& is_member) {
+    for (uint32_t byte{0}; byte < cSizeOfByte; ++byte) {
+        if (is_member[byte]) {
+            add(static_cast<uint8_t>(byte));
+        }
+    }
+}
+
+auto ByteSet::get_best_kernel() -> Kernel {
+    static Kernel const cBestKernel{[] {
+        if (is_kernel_supported(Kernel::Avx2)) {
+            return Kernel::Avx2;
+        }
+        if (is_kernel_supported(Kernel::Sse42)) {
+            return Kernel::Sse42;
+        }
+        return Kernel::Scalar;
+    }()};
+    return cBestKernel;
+}
+
+auto ByteSet::is_kernel_supported(Kernel const kernel) -> bool {
+    switch (kernel) {
+#ifdef LOG_SURGEON_BYTE_SET_X86_KERNELS
+        case Kernel::Avx2:
+            return 0 != __builtin_cpu_supports("avx2");
+        case Kernel::Sse42:
+            return 0 != __builtin_cpu_supports("sse4.2");
+#endif
+        case Kernel::Scalar:
+            return true;
+        default:
+            return false;
+    }
+}
+
+auto ByteSet::add(uint8_t const byte) -> void {
+    if (m_is_member[byte]) {
+        return;
+    }
+    m_is_member[byte] = true;
+    ++m_size;
+    uint32_t const low_nibble{byte & cNibbleMask};
+    uint32_t const high_nibble{static_cast<uint32_t>(byte) >> 4U};
+    auto& table{high_nibble < 8 ? m_low_half_table : m_high_half_table};
+    table[low_nibble] |= static_cast<uint8_t>(1U << (high_nibble % 8));
+}
+
+auto ByteSet::find_first(char const* begin, char const* end) const -> char const* {
+    return find_first(begin, end, get_best_kernel());
+}
+
+auto ByteSet::find_first(char const* begin, char const* end, Kernel const kernel) const
+        -> char const* {
+    switch (kernel) {
+#ifdef LOG_SURGEON_BYTE_SET_X86_KERNELS
+        case Kernel::Avx2:
+            return find_first_avx2(
+                    begin,
+                    end,
+                    m_low_half_table.data(),
+                    m_high_half_table.data(),
+                    m_is_member
+            );
+        case Kernel::Sse42:
+            return find_first_sse42(
+                    begin,
+                    end,
+                    m_low_half_table.data(),
+                    m_high_half_table.data(),
+                    m_is_member
+            );
+#endif
+        default:
+            return find_first_scalar(begin, end, m_is_member);
+    }
+}
+
+auto ByteSet::find_all(char const* begin, char const* end, uint64_t* bitmap) const -> void {
+    find_all(begin, end, bitmap, get_best_kernel());
+}
+
+auto ByteSet::find_all(char const* begin, char const* end, uint64_t* bitmap, Kernel const kernel)
+        const -> void {
+    switch (kernel) {
+#ifdef LOG_SURGEON_BYTE_SET_X86_KERNELS
+        case Kernel::Avx2:
+            find_all_avx2(
+                    begin,
+                    end,
+                    m_low_half_table.data(),
+                    m_high_half_table.data(),
+                    m_is_member,
+                    bitmap
+            );
+            return;
+        case Kernel::Sse42:
+            find_all_sse42(
+                    begin,
+                    end,
+                    m_low_half_table.data(),
+                    m_high_half_table.data(),
+                    m_is_member,
+                    bitmap
+            );
+            return;
+#endif
+        default:
+            for (auto const* pos{begin}; pos < end; pos += cBitsPerWord) {
+                find_all_scalar(
+                        pos,
+                        end - pos < cBitsPerWord ? end : pos + cBitsPerWord,
+                        m_is_member,
+                        *bitmap++
+                );
+            }
+    }
+}
+}  // namespace log_surgeon
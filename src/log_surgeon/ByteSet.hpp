@@ -0,0 +1,102 @@
+#ifndef LOG_SURGEON_BYTE_SET_HPP
+#define LOG_SURGEON_BYTE_SET_HPP
+
+#include <array>
+#include <cstdint>
+
+#include <log_surgeon/Constants.hpp>
+
+namespace log_surgeon {
+/**
+ * A set of bytes that can search a range of characters for the first member of the set, or mark
+ * all members of the set in a bitmap.
+ *
+ * On x86-64 the search tests 16 (SSE4.2) or 32 (AVX2) bytes at a time using the nibble-shuffle
+ * technique: the low nibble of each byte selects an entry of a 16-entry table, which holds a bitmask
+ * of the high nibbles that form a member of the set together with that low nibble. Since a mask
+ * only has 8 bits, there is one table for bytes below 0x80 and one for the rest. The best kernel
+ * supported by the CPU is selected once at runtime, with a scalar lookup as the fallback.
+ */
+class ByteSet {
+public:
+    enum class Kernel : uint8_t {
+        Scalar,
+        Sse42,
+        Avx2
+    };
+
+    ByteSet() = default;
+
+    /**
+     * @param is_member Whether each byte is in the set.
+     */
+    explicit ByteSet(std::array<bool, cSizeOfByte> const& is_member);
+
+    /**
+     * @return The fastest kernel supported by the CPU.
+     */
+    [[nodiscard]] static auto get_best_kernel() -> Kernel;
+
+    /**
+     * @param kernel
+     * @return Whether `kernel` is supported by the CPU.
+     */
+    [[nodiscard]] static auto is_kernel_supported(Kernel kernel) -> bool;
+
+    auto add(uint8_t byte) -> void;
+
+    [[nodiscard]] auto contains(uint8_t const byte) const -> bool { return m_is_member[byte]; }
+
+    [[nodiscard]] auto empty() const -> bool { return 0 == m_size; }
+
+    [[nodiscard]] auto size() const -> uint32_t { return m_size; }
+
+    /**
+     * Finds the first member of the set in [begin, end) using the best supported kernel.
+     * @param begin
+     * @param end
+     * @return A pointer to the first member of the set, or `end` if there is none.
+     */
+    [[nodiscard]] auto find_first(char const* begin, char const* end) const -> char const*;
+
+    /**
+     * Finds the first member of the set in [begin, end) using the given kernel.
+     * @param begin
+     * @param end
+     * @param kernel A kernel supported by the CPU.
+     * @return A pointer to the first member of the set, or `end` if there is none.
+     */
+    [[nodiscard]] auto find_first(char const* begin, char const* end, Kernel kernel) const
+            -> char const*;
+
+    /**
+     * Marks every member of the set in [begin, end) in a bitmap using the best supported kernel.
+     * @param begin
+     * @param end
+     * @param bitmap Returns with bit `i % 64` of word `i / 64` set if `begin[i]` is a member. Must
+     * hold at least `ceil((end - begin) / 64)` words.
+     */
+    auto find_all(char const* begin, char const* end, uint64_t* bitmap) const -> void;
+
+    /**
+     * Marks every member of the set in [begin, end) in a bitmap using the given kernel.
+     * @param begin
+     * @param end
+     * @param bitmap Returns with bit `i % 64` of word `i / 64` set if `begin[i]` is a member. Must
+     * hold at least `ceil((end - begin) / 64)` words.
+     * @param kernel A kernel supported by the CPU.
+     */
+    auto find_all(char const* begin, char const* end, uint64_t* bitmap, Kernel kernel) const
+            -> void;
+
+private:
+    std::array<bool, cSizeOfByte> m_is_member{};
+    // Indexed by the low nibble; bit `h` is set if byte `h << 4 | low` is a member
+    alignas(16) std::array<uint8_t, 16> m_low_half_table{};
+    // Indexed by the low nibble; bit `h` is set if byte `(h + 8) << 4 | low` is a member
+    alignas(16) std::array<uint8_t, 16> m_high_half_table{};
+    uint32_t m_size{0};
+};
+}  // namespace log_surgeon
+
+#endif  // LOG_SURGEON_BYTE_SET_HPP
@@ -5,6 +5,7 @@
 #include <utility>
 
 namespace log_surgeon {
+constexpr uint32_t cAsciiMax = 0x7F;
 constexpr uint32_t cUnicodeMax = 0x10'FFFF;
 constexpr uint32_t cSizeOfUnicode = cUnicodeMax + 1;
 constexpr uint32_t cSizeOfByte = 256;
@@ -47,6 +48,9 @@ constexpr char cTokenFirstTimestamp[] = "firstTimestamp";
 constexpr char cTokenNewlineTimestamp[] = "newLineTimestamp";
 constexpr char cTokenNewline[] = "newLine";
 constexpr uint32_t cStaticByteBuffSize = 48'000;
+// Small, since every parser and log event holds a static buffer of this many tokens, and tokens
+// beyond it only cost a dynamic buffer
+constexpr uint32_t cStaticTokenBuffSize = 256;
 
 namespace utf8 {
 // 0xC0, 0xC1, 0xF5, 0xF6, 0xF7, 0xF8, 0xF9, 0xFA, 0xFB, 0xFC, 0xFD, 0xFE,
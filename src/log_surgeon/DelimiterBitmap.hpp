@@ -0,0 +1,83 @@
+#ifndef LOG_SURGEON_DELIMITER_BITMAP_HPP
+#define LOG_SURGEON_DELIMITER_BITMAP_HPP
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <log_surgeon/ByteSet.hpp>
+
+namespace log_surgeon {
+/**
+ * The positions of delimiters in a contiguous block of input, one bit per byte.
+ *
+ * The bitmap is built in a single vectorized pass over the block (see `ByteSet::find_all`), after
+ * which the next delimiter at or after any position in the block is found by scanning words rather
+ * than bytes.
+ */
+class DelimiterBitmap {
+public:
+    static constexpr uint32_t cBitsPerWord{64};
+
+    /**
+     * Marks the delimiters in [begin, end), unless the bitmap was already built for a block of the
+     * same generation that contains [begin, end) and also ends at `end`.
+     * @param delimiters
+     * @param begin
+     * @param end
+     * @param generation The generation of the block's contents, which must change whenever they
+     * may have changed, e.g., `ParserInputBuffer::get_generation`.
+     * @return Whether the bitmap was rebuilt.
+     */
+    auto build(ByteSet const& delimiters, char const* begin, char const* end, uint64_t generation)
+            -> bool {
+        if (nullptr != m_begin && generation == m_generation && m_begin <= begin && end == m_end) {
+            return false;
+        }
+        auto const size{static_cast<size_t>(end - begin)};
+        m_words.resize((size + cBitsPerWord - 1) / cBitsPerWord);
+        delimiters.find_all(begin, end, m_words.data());
+        m_begin = begin;
+        m_end = end;
+        m_generation = generation;
+        return true;
+    }
+
+    /**
+     * Forgets the block the bitmap was built for, e.g., because its contents may have changed.
+     */
+    auto clear() -> void {
+        m_begin = nullptr;
+        m_end = nullptr;
+    }
+
+    /**
+     * @param pos A pointer into the block, or its end.
+     * @return A pointer to the first delimiter in [pos, end), or `end` if there is none.
+     */
+    [[nodiscard]] auto find_next(char const* pos) const -> char const* {
+        auto const offset{static_cast<size_t>(pos - m_begin)};
+        auto word_idx{offset / cBitsPerWord};
+        if (word_idx >= m_words.size()) {
+            return m_end;
+        }
+        auto word{m_words[word_idx] & (~uint64_t{0} << (offset % cBitsPerWord))};
+        while (0 == word) {
+            if (++word_idx == m_words.size()) {
+                return m_end;
+            }
+            word = m_words[word_idx];
+        }
+        return m_begin + word_idx * cBitsPerWord + std::countr_zero(word);
+    }
+
+private:
+    std::vector<uint64_t> m_words;
+    char const* m_begin{nullptr};
+    char const* m_end{nullptr};
+    uint64_t m_generation{0};
+};
+}  // namespace log_surgeon
+
+#endif  // LOG_SURGEON_DELIMITER_BITMAP_HPP
@@ -656,6 +656,7 @@ auto Lalr1Parser<TypedNfaState, TypedDfaState>::reset() -> void {
         m_parse_stack_matches.pop();
     }
     m_input_buffer.reset();
+    // Also releases the side storage of the tokens scanned by the previous parse
     m_lexer.reset();
 }
 
@@ -2,27 +2,53 @@
 #define LOG_SURGEON_LEXER_HPP
 
 #include <array>
+#include <cstddef>
 #include <cstdint>
 #include <map>
 #include <memory>
 #include <optional>
 #include <set>
+#include <span>
 #include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include <log_surgeon/BinarySerialization.hpp>
+#include <log_surgeon/ByteSet.hpp>
 #include <log_surgeon/Constants.hpp>
+#include <log_surgeon/DelimiterBitmap.hpp>
 #include <log_surgeon/finite_automata/Dfa.hpp>
 #include <log_surgeon/finite_automata/DfaState.hpp>
+#include <log_surgeon/finite_automata/LazyDfa.hpp>
 #include <log_surgeon/finite_automata/NfaState.hpp>
 #include <log_surgeon/finite_automata/RegexAST.hpp>
+#include <log_surgeon/finite_automata/RegisterHandler.hpp>
+#include <log_surgeon/finite_automata/RegisterReplayer.hpp>
+#include <log_surgeon/finite_automata/RuntimeDfa.hpp>
 #include <log_surgeon/LexicalRule.hpp>
 #include <log_surgeon/ParserInputBuffer.hpp>
 #include <log_surgeon/Token.hpp>
+#include <log_surgeon/TokenPrefilter.hpp>
+#include <log_surgeon/TokenSideStorage.hpp>
 #include <log_surgeon/types.hpp>
 
 namespace log_surgeon {
+/**
+ * How `Lexer::scan` finds tokens.
+ */
+enum class LexingMode : uint8_t {
+    // Simulates the DFA one character at a time, checking each character for delimiters.
+    Incremental,
+    // Once the rest of the input is in the buffer, marks all delimiters in it with a vectorized
+    // pass, and then remembers in which DFA states a match attempt fails after each delimiter, so
+    // that later attempts reaching the same state at the same delimiter stop right away instead of
+    // rescanning the bytes that follow. Each byte is then scanned at most a constant number of
+    // times per DFA state, which bounds lexing time linearly in the input size. Produces the same
+    // tokens as `Incremental`, which is used until the rest of the input is in the buffer.
+    Linear
+};
+
 /**
  * Represents a lexer that processes input buffers using a DFA-based approach.
  *
@@ -46,6 +72,19 @@ public:
     static inline std::vector<uint32_t> const cTokenEndTypes = {(uint32_t)SymbolId::TokenEnd};
     static inline std::vector<uint32_t> const cTokenUncaughtStringTypes
             = {(uint32_t)SymbolId::TokenUncaughtString};
+    static constexpr uint64_t cDefaultMaxNumNfaStates{100'000};
+    static constexpr size_t cDefaultMaxNumDfaStates{100'000};
+    static constexpr size_t cDefaultMaxNumLazyDfaStates{
+            finite_automata::LazyDfa<TypedNfaState>::cDefaultMaxNumCachedStates
+    };
+    // Identifies the blobs of `serialize_binary` ("LSLX" in little-endian byte order)
+    static constexpr uint32_t cBinaryMagic{0x584c'534c};
+    // Must be incremented whenever the content of the blobs changes
+    static constexpr uint32_t cBinaryVersion{2};
+    // Identifies the images of `serialize_image` ("LSLI" in little-endian byte order)
+    static constexpr uint32_t cImageMagic{0x494c'534c};
+    // Must be incremented whenever the content of the images changes
+    static constexpr uint32_t cImageVersion{3};
 
     /**
      * Sets a list of delimiter types to the lexer, invalidating any delimiters that were previously
@@ -75,15 +114,81 @@ public:
 
     /**
      * Generates the DFA for the lexer.
+     *
+     * If `set_lazy_dfa` was enabled and none of the rules have captures, the DFA is determinized on
+     * demand while lexing instead (see `finite_automata::LazyDfa`).
      * @throw std::invalid_argument If multiple captures with the same name are found in the rules.
+     * @throw std::invalid_argument If the rules need more than the maximum number of NFA states
+     * (see `set_max_num_nfa_states`), which is checked before the NFA is built.
+     * @throw finite_automata::DfaStateLimitExceeded If the whole DFA is built and determinizing the
+     * rules needs more than the maximum number of DFA states (see `set_max_num_dfa_states`).
      */
     auto generate() -> void;
 
+    /**
+     * Serializes the state built by `generate`: the symbol tables, the captures and their tags, the
+     * delimiters, the DFA (see `Dfa::serialize_binary`), and the token prefilter. Options that only
+     * affect lexing, such as the lexing mode, aren't included.
+     * @return A versioned and checksummed blob, which `load_binary` loads without building an NFA
+     * or determinizing it. The blob can only be loaded on hosts with the same byte order.
+     * @throw std::logic_error if the lexer wasn't generated, or if its DFA is determinized on
+     * demand, which needs the NFA.
+     */
+    [[nodiscard]] auto serialize_binary() const -> std::vector<uint8_t>;
+
+    /**
+     * Loads a lexer serialized by `serialize_binary`, in place of adding rules and calling
+     * `generate`. The rules themselves aren't serialized, so afterwards `get_highest_priority_rule`
+     * returns null and `generate` must not be called.
+     * @param blob
+     * @throw std::runtime_error if `blob` isn't a lexer serialized with the current
+     * `cBinaryVersion`, or if it's corrupted.
+     */
+    auto load_binary(std::span<uint8_t const> blob) -> void;
+
+    /**
+     * Serializes the lexer like `serialize_binary`, except that the DFA is written in its runtime
+     * form (see `finite_automata::RuntimeDfa::serialize_image`), which `load_image` uses in place.
+     * @return A versioned and checksummed image, which can only be loaded on hosts with the same
+     * byte order and layout of the DFA's tables.
+     * @throw std::logic_error if the lexer wasn't generated or loaded, or if its DFA is
+     * determinized on demand.
+     */
+    [[nodiscard]] auto serialize_image() const -> std::vector<uint8_t>;
+
+    /**
+     * Loads a lexer serialized by `serialize_image`, in place of adding rules and calling
+     * `generate`. The DFA's tables aren't copied, but lexed directly from the image, so the image
+     * can be a read-only mapping of a file or shared memory that many lexers, e.g., in different
+     * processes, lex from without each keeping a copy of the DFA. Only the symbol tables, the
+     * token prefilter, and the lists of matching variable IDs are copied.
+     *
+     * Afterwards, `get_dfa` and `get_highest_priority_rule` return null, so neither
+     * `scan_with_wildcard` nor `serialize_binary` can be used, and `generate` must not be called.
+     * @param image An image that must stay valid and unchanged while the lexer uses it, and that
+     * must be aligned to 16 bytes, as mapped memory and the buffers of `std::vector` are.
+     * @throw std::runtime_error if `image` isn't a lexer serialized with the current
+     * `cImageVersion`, or if it's corrupted or misaligned.
+     */
+    auto load_image(std::span<uint8_t const> image) -> void;
+
     /**
      * Reset the lexer to start a new lexing (reset buffers, reset vars tracking positions).
      */
     auto reset() -> void;
 
+    /**
+     * Releases the side storage (see `TokenSideStorage`) of the tokens returned before the previous
+     * call, including their registers, so that it's reused for the tokens returned from now on. A
+     * token's registers therefore stay valid until the second call after it was returned, which
+     * lets a parser call this at the start of every log event and still read the registers of a
+     * token it scanned while parsing the previous event.
+     */
+    auto release_old_token_registers() -> void {
+        std::swap(m_token_side_storages[0], m_token_side_storages[1]);
+        m_token_side_storages[1]->clear();
+    }
+
     /**
      * Set the lexer state as if it had already read a delimiter (used for treating start of file as
      * a delimiter).
@@ -101,25 +206,32 @@ public:
     /**
      * Determine the out-going transition based on the input character. Update the current state
      * and register values based on the transition.
+     * @tparam cTrackTags Whether to apply the transition's register operations.
      * @param next_char The character to transition on.
      * @param curr_pos The current position in the lexing.
      */
-    auto process_char(uint32_t const next_char, uint32_t const curr_pos) -> void {
-        auto const optional_transition{m_state->get_transition(next_char)};
-        if (false == optional_transition.has_value()) {
-            m_state = nullptr;
-            return;
+    template <bool cTrackTags = true>
+    auto process_char(uint32_t const next_char, [[maybe_unused]] uint32_t const curr_pos) -> void {
+        auto const transition_idx{m_runtime_dfa->get_transition_idx(m_state, next_char)};
+        m_state = get_next_state(transition_idx, next_char, m_lazy_dfa_clock);
+        if constexpr (cTrackTags) {
+            m_reg_handler.process_reg_ops(
+                    m_runtime_dfa->get_transition_reg_ops(transition_idx),
+                    curr_pos
+            );
         }
-        m_state = optional_transition.value().get_dest_state();
-
-        auto const reg_ops{optional_transition.value().get_reg_ops()};
-        m_dfa->process_reg_ops(reg_ops, curr_pos);
     }
 
     /**
      * Scans the input buffer and retrieves the next token.
      * If the next token is an uncaught string, the next variable token is already prepped to be
      * returned on the next call.
+     *
+     * The registers and copied values of the returned tokens are kept in side storage until
+     * `release_old_token_registers` is called twice, or the lexer is reset. Callers that scan an
+     * unbounded input must therefore call it periodically, e.g., once per log event like
+     * `LogParser` does, for the side storage not to grow with the input. `Lalr1Parser` resets the
+     * lexer at the start of every parse instead.
      * @param input_buffer The input buffer to scan.
      * @return If lexing is completed, a pair containing:
      * - `ErrorCode::Success`.
@@ -133,7 +245,8 @@ public:
 
     /**
      * Scans the input buffer with wildcards, allowing for more flexible token matching.
-     * This is useful for searching with patterns that include wildcards.
+     * This is useful for searching with patterns that include wildcards. The token's side storage
+     * is kept like that of the tokens returned by `scan`.
      * @param input_buffer The input buffer to scan.
      * @param wildcard The wildcard character used for matching.
      * @param token The token object to be populated with the matched token.
@@ -150,17 +263,115 @@ public:
      */
     auto increase_buffer_capacity(ParserInputBuffer& input_buffer) -> void;
 
+    auto set_lexing_mode(LexingMode const lexing_mode) -> void { m_lexing_mode = lexing_mode; }
+
+    [[nodiscard]] auto get_lexing_mode() const -> LexingMode { return m_lexing_mode; }
+
+    /**
+     * Sets whether `scan` defers locating the captures of a token until they're read. If set, the
+     * DFA is run without its register operations, and the registers of a token are only computed,
+     * by running the DFA again over the token, the first time they're read (see `Token`). This
+     * speeds up lexing if the captures of most tokens are never read.
+     * @param lazy_captures
+     */
+    auto set_lazy_captures(bool const lazy_captures) -> void { m_lazy_captures = lazy_captures; }
+
+    [[nodiscard]] auto get_lazy_captures() const -> bool { return m_lazy_captures; }
+
+    /**
+     * Sets whether `generate` minimizes the DFA (see `Dfa::minimize`). Must be called before
+     * `generate` to take effect.
+     * @param minimize_dfa
+     */
+    auto set_minimize_dfa(bool const minimize_dfa) -> void { m_minimize_dfa = minimize_dfa; }
+
+    /**
+     * Sets whether `generate` removes redundant registers and register operations from the DFA
+     * (see `Dfa::optimize_registers`). Must be called before `generate` to take effect.
+     * @param optimize_registers
+     */
+    auto set_optimize_registers(bool const optimize_registers) -> void {
+        m_optimize_registers = optimize_registers;
+    }
+
+    /**
+     * Sets the maximum number of NFA states `generate` may build for all rules combined. Counted
+     * repetitions (e.g., `.{0,4096}`) are the usual cause of oversized NFAs. Must be called before
+     * `generate` to take effect.
+     * @param max_num_nfa_states
+     */
+    auto set_max_num_nfa_states(uint64_t const max_num_nfa_states) -> void {
+        m_max_num_nfa_states = max_num_nfa_states;
+    }
+
+    /**
+     * Sets the maximum number of DFA states `generate` may build before minimization. Must be
+     * called before `generate` to take effect.
+     * @param max_num_dfa_states
+     */
+    auto set_max_num_dfa_states(size_t const max_num_dfa_states) -> void {
+        m_max_num_dfa_states = max_num_dfa_states;
+    }
+
+    /**
+     * Sets the number of threads `generate` determinizes the DFA with (see `finite_automata::Dfa`).
+     * The DFA is the same for any number of threads. Must be called before `generate` to take
+     * effect.
+     * @param num_dfa_threads
+     */
+    auto set_num_dfa_threads(size_t const num_dfa_threads) -> void {
+        m_num_dfa_threads = num_dfa_threads;
+    }
+
+    /**
+     * Sets whether `generate` skips building the whole DFA and determinizes it on demand while
+     * lexing instead, if none of the rules have captures. Must be called before `generate` to take
+     * effect. Schemas too large to determinize within `set_max_num_dfa_states` need this enabled.
+     * @param lazy_dfa
+     */
+    auto set_lazy_dfa(bool const lazy_dfa) -> void { m_use_lazy_dfa = lazy_dfa; }
+
+    /**
+     * Sets the maximum number of states a DFA determinized on demand keeps cached. Must be called
+     * before `generate` to take effect.
+     * @param max_num_lazy_dfa_states
+     */
+    auto set_max_num_lazy_dfa_states(size_t const max_num_lazy_dfa_states) -> void {
+        m_max_num_lazy_dfa_states = max_num_lazy_dfa_states;
+    }
+
+    /**
+     * @return The number of bytes the lexer has moved past since the last reset, including every
+     * byte scanned again after rewinding the input, and the bytes marked by `LexingMode::Linear`.
+     * Bytes skipped by `LexingMode::Linear` without being scanned aren't counted. The count is derived from the returned tokens and the rewinds, so it isn't updated
+     * for every byte.
+     */
+    [[nodiscard]] auto get_num_scanned_bytes() const -> uint64_t {
+        return m_num_lexed_bytes + m_num_extra_scanned_bytes;
+    }
+
     [[nodiscard]] auto get_has_delimiters() const -> bool const& { return m_has_delimiters; }
 
-    [[nodiscard]] auto is_delimiter(uint8_t byte) const -> bool const& {
-        return m_is_delimiter[byte];
+    [[nodiscard]] auto is_delimiter(uint8_t byte) const -> bool {
+        return 0 != (m_byte_flags[byte] & cDelimiterFlag);
     }
 
+    /**
+     * @return The DFA, or a null pointer if it's determinized on demand or loaded from an image.
+     */
     [[nodiscard]] auto get_dfa() const
             -> std::unique_ptr<finite_automata::Dfa<TypedDfaState, TypedNfaState>> const& {
         return m_dfa;
     }
 
+    /**
+     * @return The DFA determinized on demand, or a null pointer if the DFA was fully built.
+     */
+    [[nodiscard]] auto get_lazy_dfa() const
+            -> std::unique_ptr<finite_automata::LazyDfa<TypedNfaState>> const& {
+        return m_lazy_dfa;
+    }
+
     /**
      * Retrieves a list of capture IDs for a given rule ID.
      * These capture IDs correspond to the captures in the rule that were matched during lexing.
@@ -197,9 +408,8 @@ public:
      */
     [[nodiscard]] auto get_reg_id_from_tag_id(tag_id_t const tag_id) const
             -> std::optional<reg_id_t> {
-        auto const& tag_id_to_final_reg_id{m_dfa->get_tag_id_to_final_reg_id()};
-        if (tag_id_to_final_reg_id.contains(tag_id)) {
-            return tag_id_to_final_reg_id.at(tag_id);
+        if (m_tag_id_to_final_reg_id.contains(tag_id)) {
+            return m_tag_id_to_final_reg_id.at(tag_id);
         }
         return std::nullopt;
     }
@@ -231,33 +441,326 @@ public:
         return std::make_pair(optional_start_reg_id.value(), optional_end_reg_id.value());
     }
 
+    /**
+     * Like `get_capture_ids_from_rule_id` and `get_reg_ids_from_capture_id` combined, but without
+     * copying or looking up anything per capture, to read the captures of tokens with
+     * `Token::get_captures`.
+     * @param rule_id
+     * @return The registers of each capture of the rule that has registers, if the rule has
+     * captures.
+     * @return std::nullopt if the rule has no captures.
+     */
+    [[nodiscard]] auto get_capture_regs_from_rule_id(rule_id_t const rule_id) const
+            -> std::optional<std::span<CaptureRegisters const>> {
+        auto const it{m_rule_id_to_capture_regs.find(rule_id)};
+        if (m_rule_id_to_capture_regs.end() == it) {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+
     std::unordered_map<std::string, rule_id_t> m_symbol_id;
     std::unordered_map<rule_id_t, std::string> m_id_symbol;
 
 private:
+    // Bits of `m_byte_flags`, so that the scan loops classify each byte with a single lookup
+    static constexpr uint8_t cDelimiterFlag{1U << 0U};
+    // Set for delimiters, or for every byte if there are none
+    static constexpr uint8_t cMatchEndFlag{1U << 1U};
+    static constexpr uint8_t cNewlineFlag{1U << 2U};
+    // Set for bytes with a transition out of the root state
+    static constexpr uint8_t cVariableStartFlag{1U << 3U};
+    static constexpr uint8_t cVariableStartDelimiterFlags{cDelimiterFlag | cVariableStartFlag};
+
+    // The state shared by `serialize_binary` and `serialize_image`, besides the DFA
+    struct SymbolTables {
+        std::array<uint8_t, cSizeOfByte> m_byte_flags{};
+        bool m_has_delimiters{false};
+        bool m_has_tags{false};
+        std::unordered_map<rule_id_t, std::string> m_id_symbol;
+        std::unordered_map<std::string, rule_id_t> m_symbol_id;
+        std::unordered_map<rule_id_t, std::vector<capture_id_t>> m_rule_id_to_capture_ids;
+        std::unordered_map<capture_id_t, std::pair<tag_id_t, tag_id_t>>
+                m_capture_id_to_tag_id_pair;
+    };
+
+    /**
+     * Writes the symbol tables in a sorted order, so that the same lexer is always written the
+     * same way.
+     * @param writer
+     */
+    auto serialize_symbol_tables(BinaryWriter& writer) const -> void;
+
+    /**
+     * @param reader
+     * @return The symbol tables written by `serialize_symbol_tables`.
+     * @throw std::runtime_error if the data is truncated.
+     */
+    [[nodiscard]] static auto load_symbol_tables(BinaryReader& reader) -> SymbolTables;
+
+    /**
+     * Replaces the lexer's symbol tables and clears its rules, as done when loading a lexer.
+     * @param symbol_tables
+     */
+    auto set_symbol_tables(SymbolTables symbol_tables) -> void;
+
+    /**
+     * Sets up the registers that track tags while lexing. They're kept by the lexer rather than by
+     * the DFA, so that the DFA's tables are only read while lexing. Must be called after the
+     * captures are set up.
+     * @param multi_valued_regs Whether each register, indexed by ID, is multi-valued.
+     * @param tag_id_to_final_reg_id
+     */
+    auto set_up_registers(
+            std::vector<bool> multi_valued_regs,
+            std::map<tag_id_t, reg_id_t> tag_id_to_final_reg_id
+    ) -> void;
+
+    /**
+     * @param flags
+     * @return Whether each byte has any of `flags` set in `m_byte_flags`.
+     */
+    [[nodiscard]] auto get_bytes_with_any_flag(uint8_t flags) const
+            -> std::array<bool, cSizeOfByte>;
+
+    /**
+     * Derives the byte sets the scan loops stop at from `m_byte_flags`, and accelerates the states
+     * of `m_runtime_dfa` if possible.
+     */
+    auto set_up_scan_tables() -> void;
+
+    /**
+     * @param transition_idx The index of the transition out of `m_state` on `byte`.
+     * @param byte
+     * @param num_scanned_bytes The number of bytes scanned so far.
+     * @return The state the transition leads to, after determinizing the transition if it hasn't
+     * been yet. If that flushes the lazy DFA's cache, `m_state` is updated to the same state in the
+     * flushed cache, which invalidates `transition_idx`.
+     */
+    [[nodiscard]] auto get_next_state(
+            size_t const transition_idx,
+            uint8_t const byte,
+            uint64_t const num_scanned_bytes
+    ) -> finite_automata::RuntimeDfa::state_id_t {
+        auto const next_state{m_runtime_dfa->get_next_state(transition_idx)};
+        if (finite_automata::RuntimeDfa::cUnexploredState != next_state) {
+            return next_state;
+        }
+        return m_lazy_dfa->get_next_state(m_state, byte, num_scanned_bytes);
+    }
+
+    /**
+     * Counts the bytes from `pos` up to the position of `input_buffer` as scanned again, before the
+     * input buffer is rewound to `pos`.
+     * @param input_buffer
+     * @param pos
+     */
+    auto count_rewind(ParserInputBuffer const& input_buffer, uint32_t const pos) -> void {
+        auto const curr_pos{input_buffer.storage().pos()};
+        m_num_extra_scanned_bytes += pos <= curr_pos
+                                             ? curr_pos - pos
+                                             : input_buffer.storage().size() - pos + curr_pos;
+    }
+
     /**
      * @return The nexer character from the input buffer.
      */
     [[nodiscard]] auto get_next_character() -> unsigned char;
 
+    /**
+     * Implements `scan`.
+     * @tparam cTrackTags Whether to track tags in registers. If false, all register bookkeeping is
+     * compiled out, which is only valid if none of the rules contain captures.
+     * @tparam cCountScannedBytes Whether to count the scanned bytes in `m_lazy_dfa_clock`, which
+     * only the lazy DFA needs while scanning incrementally.
+     * @param input_buffer The input buffer to scan.
+     * @return Forwards `scan`'s return values.
+     * @throw runtime_error if the input buffer is about to overflow.
+     */
+    template <bool cTrackTags, bool cCountScannedBytes>
+    auto scan_impl(ParserInputBuffer& input_buffer) -> std::pair<ErrorCode, std::optional<Token>>;
+
+    /**
+     * Implements `scan_with_wildcard`, except for setting the side storage of the token.
+     * @param input_buffer
+     * @param wildcard
+     * @param token
+     * @return Forwards `scan_with_wildcard`'s return values.
+     * @throw runtime_error if the input buffer is about to overflow.
+     */
+    auto scan_with_wildcard_impl(ParserInputBuffer& input_buffer, char wildcard, Token& token)
+            -> ErrorCode;
+
+    /**
+     * Points a returned token to the side storage of the tokens returned since the last call to
+     * `release_old_token_registers`, and adds an entry for it if its value wraps around the end of
+     * the buffer, so that the value is copied at most once for the token and its copies.
+     * @param token
+     */
+    auto set_side_storage(Token& token) -> void;
+
+    /**
+     * Implements `scan` in `LexingMode::Linear`, once `scan_impl` has set up the next token.
+     * Produces the same tokens as `scan_impl`.
+     *
+     * If a run started at a delimiter dies before passing another delimiter or newline, and without
+     * a match, `scan_impl` would emit the text before that delimiter and then repeat the run from
+     * it, which dies at the same character again. Instead, the outcome of the repeated run is set
+     * up directly: the token it would emit is prepared as the next match, or the next call starts
+     * where it would continue from.
+     *
+     * Other runs are skipped once they're repeated: whenever the DFA dies or reaches the end of the
+     * input, every delimiter passed since the last match is recorded in `m_failed_runs`, together
+     * with the DFA state before the delimiter. Reaching the same state at the same delimiter again, the DFA is known to die at
+     * the same position without another match, so it skips there directly. Only the first
+     * delimiter that isn't the start of the last token needs to be found on the way, which the
+     * bitmap provides. Newlines have side effects unless a match was already found, so runs are
+     * only recorded past a newline if they had already found a match, which is part of the key.
+     * Skipping the register operations is safe since final registers are only set on a match.
+     * @tparam cTrackTags Whether to track tags in registers.
+     * @param input_buffer The input buffer to scan, whose readable span must reach the end of the
+     * input.
+     * @return Forwards `scan`'s return values.
+     */
+    template <bool cTrackTags>
+    auto scan_linear(ParserInputBuffer& input_buffer) -> std::pair<ErrorCode, std::optional<Token>>;
+
+    /**
+     * Forgets every run recorded in `m_failed_runs`, and the keys of the states they were in.
+     */
+    auto clear_failed_runs() -> void {
+        m_failed_runs.clear();
+        if (nullptr != m_lazy_dfa) {
+            m_lazy_dfa->clear_state_keys();
+        }
+    }
+
+    /**
+     * @param state
+     * @param pos
+     * @param has_match
+     * @return The key of a failed run in `m_failed_runs`. If the DFA is determinized on demand, its
+     * state is identified by the lazy DFA's key for it, since state IDs change when its cache is
+     * flushed.
+     */
+    [[nodiscard]] auto get_failed_run_key(
+            finite_automata::RuntimeDfa::state_id_t const state,
+            uint32_t const pos,
+            bool const has_match
+    ) -> uint64_t {
+        uint64_t const state_key{
+                nullptr == m_lazy_dfa ? state & finite_automata::RuntimeDfa::cStateIndexMask
+                                      : m_lazy_dfa->get_state_key(state)
+        };
+        return static_cast<uint64_t>(pos) << 32U | state_key << 1U
+               | static_cast<uint64_t>(has_match);
+    }
+
+    /**
+     * @param pos A pointer into the block marked in `m_stop_bitmap`.
+     * @param end The end of the block.
+     * @return A pointer to the first delimiter in [pos, end) that can start a variable, or `end` if
+     * there is none.
+     */
+    [[nodiscard]] auto find_next_variable_start_delimiter(char const* pos, char const* end) const
+            -> char const*;
+
+    /**
+     * Tests the token starting at the current position of `span`, which must be at a delimiter
+     * enabled in the prefilter while in the root state, against the prefilter. If no variable can
+     * match the token, and skipping it produces the same tokens as simulating the DFA, skips to the
+     * delimiter ending the token in the dead state.
+     * @param span The span being scanned.
+     * @param num_consumed Returns the number of characters of `span` consumed.
+     * @param curr_pos Returns the position in the input buffer.
+     * @return Whether the token was skipped.
+     */
+    auto try_skip_rejected_token(
+            std::span<char const> span,
+            uint32_t& num_consumed,
+            uint32_t& curr_pos
+    ) -> bool;
+
+    /**
+     * Sets the registers of the current match's token if any of the matched rules have captures.
+     * If tags are being tracked, the registers are saved in the side storage and then reset for the
+     * next match. Otherwise, the side storage is set up to replay them when they're first read.
+     * Either way, only the registers of the matched rules' captures are kept.
+     * @tparam cTrackTags Whether tags are being tracked in registers.
+     * @param token Returns the token with its registers set.
+     */
+    template <bool cTrackTags>
+    auto set_match_registers(Token& token) -> void;
+
     uint32_t m_match_pos{0};
     uint32_t m_start_pos{0};
+    // The DFA state the current match started in at `m_start_pos`
+    finite_automata::RuntimeDfa::state_id_t m_start_state{finite_automata::RuntimeDfa::cDeadState};
     uint32_t m_match_line{0};
     uint32_t m_last_match_pos{0};
     uint32_t m_last_match_line{0};
     bool m_match{false};
     std::vector<uint32_t> const* m_type_ids{nullptr};
     std::set<uint32_t> m_type_ids_set;
-    std::array<bool, cSizeOfByte> m_is_delimiter{false};
-    std::array<bool, cSizeOfByte> m_is_first_char_of_a_variable{false};
+    std::array<uint8_t, cSizeOfByte> m_byte_flags{};
+    // Delimiters that can start a variable, where scanning resumes after a failed match
+    ByteSet m_variable_start_delimiters;
+    // Delimiters and newlines, which are the only bytes with side effects besides the transition
+    ByteSet m_stop_bytes;
+    DelimiterBitmap m_stop_bitmap;
+    LexingMode m_lexing_mode{LexingMode::Incremental};
+    bool m_lazy_captures{false};
+    bool m_minimize_dfa{false};
+    bool m_optimize_registers{true};
+    uint64_t m_max_num_nfa_states{cDefaultMaxNumNfaStates};
+    size_t m_max_num_dfa_states{cDefaultMaxNumDfaStates};
+    size_t m_num_dfa_threads{1};
+    bool m_use_lazy_dfa{false};
+    size_t m_max_num_lazy_dfa_states{cDefaultMaxNumLazyDfaStates};
+    // Maps a failed run's key (see `get_failed_run_key`) to where the DFA died, or the end of input
+    std::unordered_map<uint64_t, uint32_t> m_failed_runs;
+    uint32_t m_max_failed_run_pos{0};
+    // The keys of the delimiters passed since the last match in the current run
+    std::vector<uint64_t> m_run_keys;
+    // The total length of the returned tokens
+    uint64_t m_num_lexed_bytes{0};
+    // The bytes scanned besides the returned tokens' own, i.e., again after rewinding or to mark
+    // delimiters, less those skipped over in `LexingMode::Linear`. May wrap around while negative.
+    uint64_t m_num_extra_scanned_bytes{0};
+    // The bytes scanned while the DFA may be determinized on demand, by which its cache is flushed
+    uint64_t m_lazy_dfa_clock{0};
+    TokenPrefilter m_token_prefilter;
     std::vector<LexicalRule<TypedNfaState>> m_rules;
     uint32_t m_line{0};
     bool m_has_delimiters{false};
+    bool m_has_tags{false};
     std::unique_ptr<finite_automata::Dfa<TypedDfaState, TypedNfaState>> m_dfa;
+    // May point into an image (see `load_image`), in which case `m_dfa` is null
+    std::unique_ptr<finite_automata::RuntimeDfa> m_runtime_dfa;
+    finite_automata::RegisterHandler m_reg_handler;
+    std::vector<bool> m_multi_valued_regs;
+    // The side storage of the tokens returned before and since the last call to
+    // `release_old_token_registers`, each on the heap so that tokens can point to them
+    std::array<std::unique_ptr<TokenSideStorage>, 2> m_token_side_storages{
+            std::make_unique<TokenSideStorage>(),
+            std::make_unique<TokenSideStorage>()
+    };
+    // Computes the registers of the tokens lexed with `m_lazy_captures`, on the heap so that the
+    // tokens' side storage can point to it
+    std::unique_ptr<finite_automata::RegisterReplayer> m_reg_replayer;
+    std::map<tag_id_t, reg_id_t> m_tag_id_to_final_reg_id;
+    // Derived from the above by `set_up_registers`
+    std::unordered_map<rule_id_t, std::vector<CaptureRegisters>> m_rule_id_to_capture_regs;
+    // The IDs of the registers in `m_rule_id_to_capture_regs`, sorted, for the rules with any
+    std::unordered_map<rule_id_t, std::vector<reg_id_t>> m_rule_id_to_capture_reg_ids;
+    // The registers of the current match's captures, if it matched several rules with captures
+    std::vector<reg_id_t> m_match_capture_reg_ids;
+    // Fills `m_runtime_dfa` on demand if set, in which case `m_dfa` is null
+    std::unique_ptr<finite_automata::LazyDfa<TypedNfaState>> m_lazy_dfa;
     std::optional<uint32_t> m_first_delimiter_pos{std::nullopt};
     bool m_asked_for_more_data{false};
     TypedDfaState const* m_prev_state{nullptr};
-    TypedDfaState const* m_state{nullptr};
+    finite_automata::RuntimeDfa::state_id_t m_state{finite_automata::RuntimeDfa::cDeadState};
     std::unordered_map<rule_id_t, std::vector<capture_id_t>> m_rule_id_to_capture_ids;
     std::unordered_map<capture_id_t, std::pair<tag_id_t, tag_id_t>> m_capture_id_to_tag_id_pair;
 };
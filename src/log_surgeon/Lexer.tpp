@@ -1,17 +1,23 @@
 #ifndef LOG_SURGEON_LEXER_TPP
 #define LOG_SURGEON_LEXER_TPP
 
+#include <algorithm>
 #include <cassert>
+#include <map>
 #include <memory>
+#include <span>
 #include <stack>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <log_surgeon/Constants.hpp>
 #include <log_surgeon/finite_automata/RegexAST.hpp>
 #include <log_surgeon/types.hpp>
 
+#include <fmt/core.h>
+
 /**
  * utf8 format (https://en.wikipedia.org/wiki/UTF-8)
  * 1 byte: 0x0 - 0x80 : 0xxxxxxx
@@ -44,10 +50,39 @@ auto Lexer<TypedNfaState, TypedDfaState>::flip_states(uint32_t old_storage_size)
 template <typename TypedNfaState, typename TypedDfaState>
 auto Lexer<TypedNfaState, TypedDfaState>::scan(ParserInputBuffer& input_buffer)
         -> std::pair<ErrorCode, std::optional<Token>> {
+    std::pair<ErrorCode, std::optional<Token>> result;
+    if (m_has_tags && false == m_lazy_captures) {
+        result = scan_impl<true, false>(input_buffer);
+    } else if (nullptr != m_lazy_dfa) {
+        // Only rules without captures are determinized on demand
+        result = scan_impl<false, true>(input_buffer);
+    } else {
+        result = scan_impl<false, false>(input_buffer);
+    }
+    if (auto& optional_token{result.second}; optional_token.has_value()) {
+        set_side_storage(optional_token.value());
+        m_num_lexed_bytes += optional_token->get_length();
+    }
+    return result;
+}
+
+template <typename TypedNfaState, typename TypedDfaState>
+auto Lexer<TypedNfaState, TypedDfaState>::set_side_storage(Token& token) -> void {
+    token.m_side_storage = m_token_side_storages[1].get();
+    // So that a wrapped value is copied once for all the copies of the token
+    if (token.m_start_pos > token.m_end_pos && Token::cNoSideEntry == token.m_side_entry_idx) {
+        token.m_side_entry_idx = m_token_side_storages[1]->add_empty();
+    }
+}
+
+template <typename TypedNfaState, typename TypedDfaState>
+template <bool cTrackTags, bool cCountScannedBytes>
+auto Lexer<TypedNfaState, TypedDfaState>::scan_impl(ParserInputBuffer& input_buffer)
+        -> std::pair<ErrorCode, std::optional<Token>> {
     if (m_asked_for_more_data) {
         m_asked_for_more_data = false;
     } else {
-        m_state = m_dfa->get_root();
+        m_state = m_runtime_dfa->get_root();
         if (m_match) {
             m_first_delimiter_pos = std::nullopt;
             m_match = false;
@@ -59,54 +94,151 @@ auto Lexer<TypedNfaState, TypedDfaState>::scan(ParserInputBuffer& input_buffer)
                     input_buffer.storage().get_active_buffer(),
                     input_buffer.storage().size(),
                     m_match_line,
-                    m_type_ids,
-                    std::move(m_dfa->release_reg_handler())
+                    m_type_ids
             };
+            set_match_registers<cTrackTags>(token);
             return {ErrorCode::Success, token};
         }
         if (m_first_delimiter_pos.has_value()) {
             input_buffer.set_log_fully_consumed(false);
+            count_rewind(input_buffer, m_first_delimiter_pos.value());
             input_buffer.set_pos(m_first_delimiter_pos.value());
         }
+        m_start_state = m_runtime_dfa->get_root();
+        if constexpr (cTrackTags) {
+            m_reg_handler.reset();
+        }
         m_start_pos = input_buffer.storage().pos();
         m_match_pos = input_buffer.storage().pos();
         m_match_line = m_line;
         m_type_ids = nullptr;
         m_first_delimiter_pos = std::nullopt;
     }
+    if (LexingMode::Linear == m_lexing_mode && m_has_delimiters
+        && input_buffer.readable_span_reaches_end())
+    {
+        return scan_linear<cTrackTags>(input_buffer);
+    }
     while (true) {
+        // Consume the contiguous readable part of the buffer without checking its boundaries for
+        // every character. Newlines and transitions into the dead state are left to the general
+        // path below, which is entered before any of their side effects are applied.
+        auto const span{input_buffer.get_readable_span()};
+        auto curr_pos{input_buffer.storage().pos()};
+        uint32_t num_consumed{0};
+        while (num_consumed < span.size()) {
+            if (m_runtime_dfa->get_root() == m_state
+                && m_token_prefilter.is_enabled(static_cast<uint8_t>(span[num_consumed]))
+                && try_skip_rejected_token(span, num_consumed, curr_pos))
+            {
+                continue;
+            }
+            if (finite_automata::RuntimeDfa::is_accelerated(m_state)) {
+                // Every byte before the next exit byte loops back without any side effects
+                auto const* remaining{span.data() + num_consumed};
+                auto const* span_end{span.data() + span.size()};
+                auto const num_skipped{static_cast<uint32_t>(
+                        m_runtime_dfa->get_exit_bytes(m_state).find_first(remaining, span_end)
+                        - remaining
+                )};
+                num_consumed += num_skipped;
+                curr_pos += num_skipped;
+                if (num_consumed == span.size()) {
+                    break;
+                }
+            }
+            auto const next_char{static_cast<unsigned char>(span[num_consumed])};
+            auto const byte_flags{m_byte_flags[next_char]};
+            auto const transition_idx{m_runtime_dfa->get_transition_idx(m_state, next_char)};
+            auto const next_state{
+                    get_next_state(transition_idx, next_char, m_lazy_dfa_clock + num_consumed)
+            };
+            if (0 != (byte_flags & cNewlineFlag)
+                || finite_automata::RuntimeDfa::cDeadState == next_state)
+            {
+                break;
+            }
+            if (0 != (byte_flags & cDelimiterFlag)) {
+                if (false == m_first_delimiter_pos.has_value() && curr_pos != m_last_match_pos) {
+                    m_first_delimiter_pos = curr_pos;
+                }
+            }
+            if (0 != (byte_flags & cMatchEndFlag)
+                && finite_automata::RuntimeDfa::is_accepting(m_state))
+            {
+                if constexpr (cTrackTags) {
+                    m_reg_handler.process_reg_ops(
+                            m_runtime_dfa->get_accepting_reg_ops(m_state),
+                            curr_pos
+                    );
+                }
+                m_match = true;
+                m_type_ids = &m_runtime_dfa->get_matching_variable_ids(m_state);
+                m_match_pos = curr_pos;
+                m_match_line = m_line;
+            }
+            if constexpr (cTrackTags) {
+                m_reg_handler.process_reg_ops(
+                        m_runtime_dfa->get_transition_reg_ops(transition_idx),
+                        curr_pos
+                );
+            }
+            m_state = next_state;
+            ++curr_pos;
+            ++num_consumed;
+        }
+        input_buffer.advance(num_consumed);
+        if constexpr (cCountScannedBytes) {
+            m_lazy_dfa_clock += num_consumed;
+        }
+        if (num_consumed == span.size() && false == span.empty()) {
+            continue;
+        }
+
         auto prev_byte_buf_pos{input_buffer.storage().pos()};
         auto next_char{utf8::cCharErr};
         if (auto const err{input_buffer.get_next_character(next_char)}; ErrorCode::Success != err) {
             m_asked_for_more_data = true;
             return {err, std::nullopt};
         }
-        if (false == m_first_delimiter_pos.has_value() && m_is_delimiter[next_char]
+        if constexpr (cCountScannedBytes) {
+            ++m_lazy_dfa_clock;
+        }
+        auto const byte_flags{m_byte_flags[next_char]};
+        if (false == m_first_delimiter_pos.has_value() && 0 != (byte_flags & cDelimiterFlag)
             && prev_byte_buf_pos != m_last_match_pos)
         {
             m_first_delimiter_pos = prev_byte_buf_pos;
         }
 
-        if ((m_is_delimiter[next_char] || input_buffer.log_fully_consumed()
-             || false == m_has_delimiters)
-            && m_state->is_accepting())
+        if ((0 != (byte_flags & cMatchEndFlag) || input_buffer.log_fully_consumed())
+            && finite_automata::RuntimeDfa::is_accepting(m_state))
         {
-            m_dfa->process_reg_ops(m_state->get_accepting_reg_ops(), prev_byte_buf_pos);
+            if constexpr (cTrackTags) {
+                m_reg_handler.process_reg_ops(
+                        m_runtime_dfa->get_accepting_reg_ops(m_state),
+                        prev_byte_buf_pos
+                );
+            }
             m_match = true;
-            m_type_ids = &m_state->get_matching_variable_ids();
+            m_type_ids = &m_runtime_dfa->get_matching_variable_ids(m_state);
             m_match_pos = prev_byte_buf_pos;
             m_match_line = m_line;
         }
-        process_char(next_char, prev_byte_buf_pos);
+        process_char<cTrackTags>(next_char, prev_byte_buf_pos);
 
-        if ('\n' == next_char) {
+        if (0 != (byte_flags & cNewlineFlag)) {
             m_line++;
             // The newline character itself needs to be treated as a match for non-timestamped logs.
             if (m_has_delimiters && false == m_match) {
-                m_state = m_dfa->get_root();
-                process_char(next_char, prev_byte_buf_pos);
+                m_state = m_runtime_dfa->get_root();
+                if constexpr (cTrackTags) {
+                    m_reg_handler.reset();
+                }
+                process_char<cTrackTags>(next_char, prev_byte_buf_pos);
                 m_match = true;
-                m_type_ids = &m_state->get_matching_variable_ids();
+                m_type_ids = &m_runtime_dfa->get_matching_variable_ids(m_state);
+                m_start_state = m_runtime_dfa->get_root();
                 m_start_pos = prev_byte_buf_pos;
                 m_match_pos = input_buffer.storage().pos();
                 m_match_line = m_line;
@@ -114,9 +246,11 @@ auto Lexer<TypedNfaState, TypedDfaState>::scan(ParserInputBuffer& input_buffer)
             }
         }
 
-        if (input_buffer.log_fully_consumed() || nullptr == m_state) {
+        if (input_buffer.log_fully_consumed() || finite_automata::RuntimeDfa::cDeadState == m_state)
+        {
             if (m_match) {
                 input_buffer.set_log_fully_consumed(false);
+                count_rewind(input_buffer, m_match_pos);
                 input_buffer.set_pos(m_match_pos);
                 m_line = m_match_line;
                 if (m_last_match_pos != m_start_pos) {
@@ -140,9 +274,9 @@ auto Lexer<TypedNfaState, TypedDfaState>::scan(ParserInputBuffer& input_buffer)
                         input_buffer.storage().get_active_buffer(),
                         input_buffer.storage().size(),
                         m_match_line,
-                        m_type_ids,
-                        std::move(m_dfa->release_reg_handler())
+                        m_type_ids
                 };
+                set_match_registers<cTrackTags>(token);
                 return {ErrorCode::Success, token};
             }
             if (input_buffer.log_fully_consumed() && input_buffer.storage().pos() == m_start_pos) {
@@ -197,32 +331,467 @@ auto Lexer<TypedNfaState, TypedDfaState>::scan(ParserInputBuffer& input_buffer)
             }
             m_first_delimiter_pos = std::nullopt;
 
-            // TODO: remove timestamp from m_is_fist_char so that m_is_delimiter check not needed
-            m_state = m_dfa->get_root();
+            // TODO: remove timestamp from the variable start bytes so that the delimiter check is
+            // not needed
+            m_state = m_runtime_dfa->get_root();
             while (false == input_buffer.log_fully_consumed()
-                   && (false == m_is_first_char_of_a_variable[next_char]
-                       || false == m_is_delimiter[next_char]))
+                   && cVariableStartDelimiterFlags
+                              != (m_byte_flags[next_char] & cVariableStartDelimiterFlags))
             {
+                auto const num_skipped{input_buffer.skip_to_next_in(m_variable_start_delimiters)};
+                if constexpr (cCountScannedBytes) {
+                    m_lazy_dfa_clock += num_skipped;
+                }
                 prev_byte_buf_pos = input_buffer.storage().pos();
                 if (auto err{input_buffer.get_next_character(next_char)}; ErrorCode::Success != err)
                 {
                     m_asked_for_more_data = true;
                     return {err, std::nullopt};
                 }
+                if constexpr (cCountScannedBytes) {
+                    ++m_lazy_dfa_clock;
+                }
             }
+            count_rewind(input_buffer, prev_byte_buf_pos);
             input_buffer.set_pos(prev_byte_buf_pos);
+            m_start_state = m_runtime_dfa->get_root();
+            if constexpr (cTrackTags) {
+                m_reg_handler.reset();
+            }
             m_start_pos = prev_byte_buf_pos;
         }
     }
 }
 
-// TODO: this is duplicating almost all the code of scan()
+template <typename TypedNfaState, typename TypedDfaState>
+template <bool cTrackTags>
+auto Lexer<TypedNfaState, TypedDfaState>::scan_linear(ParserInputBuffer& input_buffer)
+        -> std::pair<ErrorCode, std::optional<Token>> {
+    // The rest of the input is contiguous, so positions can be tracked locally and the input buffer
+    // only needs to be updated before returning
+    auto const* buffer{input_buffer.storage().get_active_buffer()};
+    auto pos{input_buffer.storage().pos()};
+    auto const end_pos{pos + static_cast<uint32_t>(input_buffer.get_readable_span().size())};
+    auto log_fully_consumed{input_buffer.log_fully_consumed()};
+    auto const return_token{[&](Token const& token) -> std::pair<ErrorCode, std::optional<Token>> {
+        input_buffer.set_pos(pos);
+        input_buffer.set_log_fully_consumed(log_fully_consumed);
+        return {ErrorCode::Success, token};
+    }};
+
+    // Phase 1: mark every delimiter and newline, unless already done by a previous call. Failed
+    // runs are recorded by position, so they're forgotten along with the block they were found in.
+    if (m_stop_bitmap.build(
+                m_stop_bytes,
+                buffer + pos,
+                buffer + end_pos,
+                input_buffer.get_generation()
+        ))
+    {
+        m_num_extra_scanned_bytes += end_pos - pos;
+        clear_failed_runs();
+        m_max_failed_run_pos = 0;
+    }
+    // Runs never move backwards past the start of the current token
+    if (pos > m_max_failed_run_pos) {
+        clear_failed_runs();
+    }
+
+    // Whether the current run hasn't passed a delimiter or newline since its start, and was
+    // simulated byte by byte, so it would die at the same character if repeated
+    auto is_anchored_run{true};
+    while (true) {
+        if (m_runtime_dfa->get_root() == m_state && pos < end_pos
+            && m_token_prefilter.is_enabled(static_cast<uint8_t>(buffer[pos])))
+        {
+            uint32_t num_consumed{0};
+            if (try_skip_rejected_token({buffer + pos, end_pos - pos}, num_consumed, pos)) {
+                m_lazy_dfa_clock += num_consumed;
+                is_anchored_run = false;
+                continue;
+            }
+        }
+
+        // Phase 2: run the DFA up to the next marked byte without checking for side effects, since
+        // only delimiters and newlines have any besides the transition itself
+        auto const stop_pos{static_cast<uint32_t>(m_stop_bitmap.find_next(buffer + pos) - buffer)};
+        auto const segment_begin_pos{pos};
+        while (pos < stop_pos) {
+            if (finite_automata::RuntimeDfa::is_accelerated(m_state)) {
+                // Exit bytes include every marked byte, so searching past `stop_pos` stops there at
+                // the latest, while searching whole blocks
+                auto const* exit{m_runtime_dfa->get_exit_bytes(m_state)
+                                         .find_first(buffer + pos, buffer + end_pos)};
+                pos = static_cast<uint32_t>(exit - buffer);
+                if (stop_pos == pos) {
+                    break;
+                }
+            }
+            auto const next_char{static_cast<unsigned char>(buffer[pos])};
+            auto const transition_idx{m_runtime_dfa->get_transition_idx(m_state, next_char)};
+            auto const next_state{get_next_state(
+                    transition_idx,
+                    next_char,
+                    m_lazy_dfa_clock + pos - segment_begin_pos
+            )};
+            if (finite_automata::RuntimeDfa::cDeadState == next_state) {
+                break;
+            }
+            if constexpr (cTrackTags) {
+                m_reg_handler.process_reg_ops(
+                        m_runtime_dfa->get_transition_reg_ops(transition_idx),
+                        pos
+                );
+            }
+            m_state = next_state;
+            ++pos;
+        }
+        m_lazy_dfa_clock += pos - segment_begin_pos;
+
+        if (finite_automata::RuntimeDfa::cDeadState != m_state) {
+            auto const key{get_failed_run_key(m_state, pos, m_match)};
+            if (auto const it{m_failed_runs.find(key)}; m_failed_runs.end() == it) {
+                m_run_keys.push_back(key);
+            } else {
+                // Skip to the character the run dies on, applying the only side effect of the
+                // skipped characters. Without a match they contain no newline.
+                auto const death_pos{it->second};
+                if (false == m_match && false == m_first_delimiter_pos.has_value()) {
+                    auto const* delimiter{m_stop_bitmap.find_next(buffer + pos)};
+                    if (buffer + m_last_match_pos == delimiter) {
+                        delimiter = m_stop_bitmap.find_next(delimiter + 1);
+                    }
+                    if (delimiter < buffer + death_pos) {
+                        m_first_delimiter_pos = static_cast<uint32_t>(delimiter - buffer);
+                    }
+                }
+                m_num_extra_scanned_bytes -= death_pos - pos;
+                pos = death_pos;
+                m_state = finite_automata::RuntimeDfa::cDeadState;
+                is_anchored_run = false;
+            }
+        }
+
+        // The next character is a delimiter, a newline, the end of the input, or kills the DFA, so
+        // it's handled exactly like `scan_impl` handles it
+        auto prev_byte_buf_pos{pos};
+        auto next_char{utf8::cCharEOF};
+        if (end_pos == pos) {
+            log_fully_consumed = true;
+        } else {
+            next_char = static_cast<unsigned char>(buffer[pos]);
+            ++pos;
+            ++m_lazy_dfa_clock;
+        }
+        auto const byte_flags{m_byte_flags[next_char]};
+        if (false == m_first_delimiter_pos.has_value() && 0 != (byte_flags & cDelimiterFlag)
+            && prev_byte_buf_pos != m_last_match_pos)
+        {
+            m_first_delimiter_pos = prev_byte_buf_pos;
+        }
+
+        if ((0 != (byte_flags & cDelimiterFlag) || log_fully_consumed)
+            && finite_automata::RuntimeDfa::is_accepting(m_state))
+        {
+            if constexpr (cTrackTags) {
+                m_reg_handler.process_reg_ops(
+                        m_runtime_dfa->get_accepting_reg_ops(m_state),
+                        prev_byte_buf_pos
+                );
+            }
+            m_match = true;
+            m_type_ids = &m_runtime_dfa->get_matching_variable_ids(m_state);
+            m_match_pos = prev_byte_buf_pos;
+            m_match_line = m_line;
+            m_run_keys.clear();
+        }
+        process_char<cTrackTags>(next_char, prev_byte_buf_pos);
+
+        if (0 != (byte_flags & cNewlineFlag)) {
+            m_line++;
+            if (false == m_match) {
+                m_state = m_runtime_dfa->get_root();
+                if constexpr (cTrackTags) {
+                    m_reg_handler.reset();
+                }
+                process_char<cTrackTags>(next_char, prev_byte_buf_pos);
+                m_match = true;
+                m_type_ids = &m_runtime_dfa->get_matching_variable_ids(m_state);
+                m_start_state = m_runtime_dfa->get_root();
+                m_start_pos = prev_byte_buf_pos;
+                m_match_pos = pos;
+                m_match_line = m_line;
+                m_run_keys.clear();
+                continue;
+            }
+        }
+
+        if (false == log_fully_consumed && finite_automata::RuntimeDfa::cDeadState != m_state) {
+            if (m_start_pos != prev_byte_buf_pos) {
+                is_anchored_run = false;
+            }
+            continue;
+        }
+        // Every delimiter passed since the last match leads here without another match
+        for (auto const key : m_run_keys) {
+            m_failed_runs.emplace(key, prev_byte_buf_pos);
+        }
+        m_run_keys.clear();
+        m_max_failed_run_pos = std::max(m_max_failed_run_pos, prev_byte_buf_pos);
+        if (m_match) {
+            log_fully_consumed = false;
+            m_num_extra_scanned_bytes += pos - m_match_pos;
+            pos = m_match_pos;
+            m_line = m_match_line;
+            if (m_last_match_pos != m_start_pos) {
+                return return_token(
+                        {m_last_match_pos,
+                         m_start_pos,
+                         buffer,
+                         input_buffer.storage().size(),
+                         m_last_match_line,
+                         &cTokenUncaughtStringTypes}
+                );
+            }
+            m_first_delimiter_pos = std::nullopt;
+            m_match = false;
+            m_last_match_pos = m_match_pos;
+            m_last_match_line = m_match_line;
+            Token token{
+                    m_start_pos,
+                    m_match_pos,
+                    buffer,
+                    input_buffer.storage().size(),
+                    m_match_line,
+                    m_type_ids
+            };
+            set_match_registers<cTrackTags>(token);
+            return return_token(token);
+        }
+        if (log_fully_consumed && pos == m_start_pos) {
+            if (m_last_match_pos != m_start_pos) {
+                if (m_first_delimiter_pos.has_value()) {
+                    Token const token{
+                            m_last_match_pos,
+                            m_first_delimiter_pos.value(),
+                            buffer,
+                            input_buffer.storage().size(),
+                            m_last_match_line,
+                            &cTokenUncaughtStringTypes
+                    };
+                    m_last_match_pos = m_first_delimiter_pos.value();
+                    return return_token(token);
+                }
+                m_match_pos = pos;
+                m_type_ids = &cTokenEndTypes;
+                m_match = true;
+                return return_token(
+                        {m_last_match_pos,
+                         m_start_pos,
+                         buffer,
+                         input_buffer.storage().size(),
+                         m_last_match_line,
+                         &cTokenUncaughtStringTypes}
+                );
+            }
+            return return_token(
+                    {pos, pos, buffer, input_buffer.storage().size(), m_line, &cTokenEndTypes}
+            );
+        }
+        if (m_first_delimiter_pos.has_value()) {
+            Token const token{
+                    m_last_match_pos,
+                    m_first_delimiter_pos.value(),
+                    buffer,
+                    input_buffer.storage().size(),
+                    m_last_match_line,
+                    &cTokenUncaughtStringTypes
+            };
+            m_last_match_pos = m_first_delimiter_pos.value();
+            if (is_anchored_run && m_start_pos == m_last_match_pos
+                && prev_byte_buf_pos != m_last_match_pos)
+            {
+                // The next call would repeat the run from its start, now the start of the last
+                // token, and die at the same character. So its outcome is set up directly: if that
+                // character is a delimiter, the text before it is the next token, and otherwise
+                // the next run starts at the next delimiter that can start a variable.
+                if (log_fully_consumed) {
+                    m_first_delimiter_pos = end_pos;
+                } else if (0 == (m_byte_flags[next_char] & cDelimiterFlag)) {
+                    pos = static_cast<uint32_t>(
+                            find_next_variable_start_delimiter(buffer + pos, buffer + end_pos)
+                            - buffer
+                    );
+                    m_first_delimiter_pos = pos;
+                } else {
+                    m_match = true;
+                    m_type_ids = &cTokenUncaughtStringTypes;
+                    m_match_pos = prev_byte_buf_pos;
+                    m_match_line = m_last_match_line;
+                    m_num_extra_scanned_bytes += pos - prev_byte_buf_pos;
+                    pos = prev_byte_buf_pos;
+                }
+            }
+            return return_token(token);
+        }
+
+        // Resume at the next delimiter that can start a variable, which is found in the bitmap
+        is_anchored_run = true;
+        m_state = m_runtime_dfa->get_root();
+        while (false == log_fully_consumed
+               && cVariableStartDelimiterFlags
+                          != (m_byte_flags[next_char] & cVariableStartDelimiterFlags))
+        {
+            auto const* next_start{
+                    find_next_variable_start_delimiter(buffer + pos, buffer + end_pos)
+            };
+            m_lazy_dfa_clock += static_cast<uint32_t>(next_start - buffer) - pos;
+            pos = static_cast<uint32_t>(next_start - buffer);
+            prev_byte_buf_pos = pos;
+            if (end_pos == pos) {
+                log_fully_consumed = true;
+                next_char = utf8::cCharEOF;
+            } else {
+                next_char = static_cast<unsigned char>(buffer[pos]);
+                ++pos;
+                ++m_lazy_dfa_clock;
+            }
+        }
+        m_num_extra_scanned_bytes += pos - prev_byte_buf_pos;
+        pos = prev_byte_buf_pos;
+        m_start_state = m_runtime_dfa->get_root();
+        if constexpr (cTrackTags) {
+            m_reg_handler.reset();
+        }
+        m_start_pos = prev_byte_buf_pos;
+    }
+}
+
+template <typename TypedNfaState, typename TypedDfaState>
+auto Lexer<TypedNfaState, TypedDfaState>::find_next_variable_start_delimiter(
+        char const* pos,
+        char const* end
+) const -> char const* {
+    for (pos = m_stop_bitmap.find_next(pos); end != pos; pos = m_stop_bitmap.find_next(pos + 1)) {
+        if (m_variable_start_delimiters.contains(static_cast<uint8_t>(*pos))) {
+            return pos;
+        }
+    }
+    return end;
+}
+
+template <typename TypedNfaState, typename TypedDfaState>
+auto Lexer<TypedNfaState, TypedDfaState>::try_skip_rejected_token(
+        std::span<char const> const span,
+        uint32_t& num_consumed,
+        uint32_t& curr_pos
+) -> bool {
+    auto const* token_begin{span.data() + num_consumed};
+    auto const* span_end{span.data() + span.size()};
+    auto const* token_end{m_token_prefilter.find_delimiter(token_begin + 1, span_end)};
+    if (span_end == token_end || false == m_variable_start_delimiters.contains(*token_end)
+        || m_token_prefilter.may_match(token_begin, token_end))
+    {
+        return false;
+    }
+
+    // Without a match, the DFA dies somewhere in the token or on the delimiter ending it. Both
+    // produce the same tokens, unless a newline is reached before the next scan stops.
+    auto const end_delimiter{static_cast<uint8_t>(*token_end)};
+    if (curr_pos != m_last_match_pos) {
+        // The token's start is the first delimiter, so the next scan stops right after the token
+        if ('\n' == end_delimiter) {
+            return false;
+        }
+    } else if ('\n' != end_delimiter) {
+        // The next scan continues from the end delimiter, so it must stop before a newline
+        auto const* next_delimiter{m_token_prefilter.find_delimiter(token_end + 1, span_end)};
+        if (false == m_token_prefilter.is_delimiter_bounded(end_delimiter)
+            || span_end == next_delimiter || '\n' == *next_delimiter)
+        {
+            return false;
+        }
+    }
+
+    if (false == m_first_delimiter_pos.has_value() && curr_pos != m_last_match_pos) {
+        m_first_delimiter_pos = curr_pos;
+    }
+    auto const token_size{static_cast<uint32_t>(token_end - token_begin)};
+    num_consumed += token_size;
+    curr_pos += token_size;
+    m_state = finite_automata::RuntimeDfa::cDeadState;
+    return true;
+}
+
+template <typename TypedNfaState, typename TypedDfaState>
+template <bool cTrackTags>
+auto Lexer<TypedNfaState, TypedDfaState>::set_match_registers(Token& token) -> void {
+    if (false == m_has_tags) {
+        return;
+    }
+    // Usually, at most one of the matched rules has captures, whose registers can be used as is
+    std::span<reg_id_t const> reg_ids;
+    m_match_capture_reg_ids.clear();
+    for (auto const type_id : *m_type_ids) {
+        auto const it{m_rule_id_to_capture_reg_ids.find(type_id)};
+        if (m_rule_id_to_capture_reg_ids.end() == it) {
+            continue;
+        }
+        if (reg_ids.empty()) {
+            reg_ids = it->second;
+            continue;
+        }
+        if (m_match_capture_reg_ids.empty()) {
+            m_match_capture_reg_ids.assign(reg_ids.begin(), reg_ids.end());
+        }
+        m_match_capture_reg_ids.insert(
+                m_match_capture_reg_ids.end(),
+                it->second.cbegin(),
+                it->second.cend()
+        );
+    }
+    if (false == m_match_capture_reg_ids.empty()) {
+        std::ranges::sort(m_match_capture_reg_ids);
+        auto const duplicates{std::ranges::unique(m_match_capture_reg_ids)};
+        m_match_capture_reg_ids.erase(duplicates.begin(), duplicates.end());
+        reg_ids = m_match_capture_reg_ids;
+    }
+    auto const has_captures{false == reg_ids.empty()};
+    auto& side_storage{*m_token_side_storages[1]};
+    if constexpr (cTrackTags) {
+        if (has_captures) {
+            token.m_side_entry_idx = side_storage.add_registers(m_reg_handler, reg_ids);
+        }
+        m_reg_handler.reset();
+    } else if (has_captures) {
+        token.m_side_entry_idx
+                = side_storage.add_replay(*m_reg_replayer, m_start_state, m_start_pos, reg_ids);
+    }
+}
+
 template <typename TypedNfaState, typename TypedDfaState>
 auto Lexer<TypedNfaState, TypedDfaState>::scan_with_wildcard(
+        ParserInputBuffer& input_buffer,
+        char const wildcard,
+        Token& token
+) -> ErrorCode {
+    auto const err{scan_with_wildcard_impl(input_buffer, wildcard, token)};
+    if (ErrorCode::Success == err) {
+        set_side_storage(token);
+    }
+    return err;
+}
+
+// TODO: this is duplicating almost all the code of scan()
+template <typename TypedNfaState, typename TypedDfaState>
+auto Lexer<TypedNfaState, TypedDfaState>::scan_with_wildcard_impl(
         ParserInputBuffer& input_buffer,
         char wildcard,
         Token& token
 ) -> ErrorCode {
+    if (nullptr == m_dfa) {
+        throw std::logic_error("Scanning with wildcards needs a fully built DFA.");
+    }
     auto const* state = m_dfa->get_root();
     if (m_asked_for_more_data) {
         state = m_prev_state;
@@ -254,7 +823,8 @@ auto Lexer<TypedNfaState, TypedDfaState>::scan_with_wildcard(
             m_prev_state = state;
             return err;
         }
-        if ((m_is_delimiter[next_char] || input_buffer.log_fully_consumed() || !m_has_delimiters)
+        auto const byte_flags{m_byte_flags[next_char]};
+        if ((0 != (byte_flags & cMatchEndFlag) || input_buffer.log_fully_consumed())
             && state->is_accepting())
         {
             m_match = true;
@@ -263,7 +833,7 @@ auto Lexer<TypedNfaState, TypedDfaState>::scan_with_wildcard(
             m_match_line = m_line;
         }
         auto const& optional_transition{state->get_transition(next_char)};
-        if (next_char == '\n') {
+        if (0 != (byte_flags & cNewlineFlag)) {
             m_line++;
             if (m_has_delimiters && !m_match) {
                 auto const* dest_state{
@@ -323,7 +893,7 @@ auto Lexer<TypedNfaState, TypedDfaState>::scan_with_wildcard(
                         unvisited_states.pop();
                         visited_states.insert(current_state);
                         for (uint32_t byte = 0; byte < cSizeOfByte; byte++) {
-                            if (m_is_delimiter[byte]) {
+                            if (0 != (m_byte_flags[byte] & cDelimiterFlag)) {
                                 continue;
                             }
                             auto const& optional_wildcard_transition{
@@ -389,14 +959,33 @@ void Lexer<TypedNfaState, TypedDfaState>::reset() {
     m_asked_for_more_data = false;
     m_prev_state = nullptr;
     m_first_delimiter_pos = std::nullopt;
-    m_state = nullptr;
+    m_state = finite_automata::RuntimeDfa::cDeadState;
+    // The register optimizations assume registers are empty when a match starts, including the
+    // first match of the next input
+    m_reg_handler.reset();
+    m_stop_bitmap.clear();
+    clear_failed_runs();
+    m_max_failed_run_pos = 0;
+    m_run_keys.clear();
+    m_num_lexed_bytes = 0;
+    m_num_extra_scanned_bytes = 0;
+    m_lazy_dfa_clock = 0;
+    for (auto& side_storage : m_token_side_storages) {
+        side_storage->clear();
+    }
 }
 
 template <typename TypedNfaState, typename TypedDfaState>
 void
 Lexer<TypedNfaState, TypedDfaState>::prepend_start_of_file_char(ParserInputBuffer& input_buffer) {
-    m_state = m_dfa->get_root()->get_transition(utf8::cCharStartOfFile)->get_dest_state();
+    m_state = m_runtime_dfa->get_root();
+    m_state = get_next_state(
+            m_runtime_dfa->get_transition_idx(m_state, utf8::cCharStartOfFile),
+            utf8::cCharStartOfFile,
+            m_lazy_dfa_clock
+    );
     m_asked_for_more_data = true;
+    m_start_state = m_state;
     m_start_pos = input_buffer.storage().pos();
     m_match_pos = input_buffer.storage().pos();
     m_match_line = m_line;
@@ -407,13 +996,23 @@ template <typename TypedNfaState, typename TypedDfaState>
 void Lexer<TypedNfaState, TypedDfaState>::set_delimiters(std::vector<uint32_t> const& delimiters) {
     assert(!delimiters.empty());
     m_has_delimiters = true;
-    for (auto& i : m_is_delimiter) {
-        i = false;
+    for (auto& byte_flags : m_byte_flags) {
+        byte_flags &= ~(cDelimiterFlag | cMatchEndFlag);
     }
     for (auto delimiter : delimiters) {
-        m_is_delimiter[delimiter] = true;
+        m_byte_flags[delimiter] |= cDelimiterFlag | cMatchEndFlag;
+    }
+    m_byte_flags[utf8::cCharStartOfFile] |= cDelimiterFlag | cMatchEndFlag;
+}
+
+template <typename TypedNfaState, typename TypedDfaState>
+auto Lexer<TypedNfaState, TypedDfaState>::get_bytes_with_any_flag(uint8_t const flags) const
+        -> std::array<bool, cSizeOfByte> {
+    std::array<bool, cSizeOfByte> has_any_flag{};
+    for (uint32_t i{0}; i < cSizeOfByte; ++i) {
+        has_any_flag[i] = 0 != (m_byte_flags[i] & flags);
     }
-    m_is_delimiter[utf8::cCharStartOfFile] = true;
+    return has_any_flag;
 }
 
 template <typename TypedNfaState, typename TypedDfaState>
@@ -455,18 +1054,367 @@ void Lexer<TypedNfaState, TypedDfaState>::generate() {
         }
     }
 
-    finite_automata::Nfa<TypedNfaState> nfa{m_rules};
-    for (auto const& [capture, tag_id_pair] : nfa.get_capture_to_tag_id_pair()) {
+    // The root state, and every rule's accepting state and regex states
+    uint64_t num_nfa_states{1};
+    for (auto const& rule : m_rules) {
+        auto const num_rule_nfa_states{
+                1 + rule.get_regex()->get_num_nfa_states_with_negative_captures()
+        };
+        if (num_rule_nfa_states > m_max_num_nfa_states - num_nfa_states) {
+            auto const rule_id{rule.get_variable_id()};
+            auto const it{m_id_symbol.find(rule_id)};
+            throw std::invalid_argument(fmt::format(
+                    "Rule `{}` needs {} NFA states, which exceeds the remaining budget of {} out "
+                    "of {}. Reduce its counted repetitions (e.g., `{{m,n}}`).",
+                    m_id_symbol.end() == it ? std::to_string(rule_id) : it->second,
+                    num_rule_nfa_states,
+                    m_max_num_nfa_states - num_nfa_states,
+                    m_max_num_nfa_states
+            ));
+        }
+        num_nfa_states += num_rule_nfa_states;
+    }
+
+    auto nfa{std::make_unique<finite_automata::Nfa<TypedNfaState>>(m_rules)};
+    for (auto const& [capture, tag_id_pair] : nfa->get_capture_to_tag_id_pair()) {
         std::string const capture_name{capture->get_name()};
         auto const capture_id{m_symbol_id.at(capture_name)};
         m_capture_id_to_tag_id_pair.emplace(capture_id, tag_id_pair);
     }
 
-    m_dfa = std::make_unique<finite_automata::Dfa<TypedDfaState, TypedNfaState>>(nfa);
+    m_has_tags = 0 < nfa->get_num_tags();
+    auto const is_delimiter{get_bytes_with_any_flag(cDelimiterFlag)};
+    m_dfa = nullptr;
+    m_lazy_dfa = nullptr;
+    if (m_has_tags || false == m_use_lazy_dfa) {
+        m_dfa = std::make_unique<finite_automata::Dfa<TypedDfaState, TypedNfaState>>(
+                *nfa,
+                is_delimiter,
+                m_max_num_dfa_states,
+                m_num_dfa_threads
+        );
+    }
+    std::array<bool, cSizeOfByte> is_variable_start{};
+    if (nullptr == m_dfa) {
+        m_runtime_dfa = std::make_unique<finite_automata::RuntimeDfa>(
+                finite_automata::Dfa<TypedDfaState, TypedNfaState>::get_byte_classes(
+                        *nfa,
+                        is_delimiter
+                )
+        );
+        m_lazy_dfa = std::make_unique<finite_automata::LazyDfa<TypedNfaState>>(
+                std::move(nfa),
+                *m_runtime_dfa,
+                m_max_num_lazy_dfa_states
+        );
+        is_variable_start = m_lazy_dfa->get_bytes_leaving_root();
+        set_up_registers({}, {});
+    } else {
+        if (m_optimize_registers) {
+            std::unordered_map<uint32_t, std::vector<tag_id_t>> rule_id_to_tag_ids;
+            for (auto const& [rule_id, capture_ids] : m_rule_id_to_capture_ids) {
+                auto& tag_ids{rule_id_to_tag_ids[rule_id]};
+                for (auto const capture_id : capture_ids) {
+                    auto const [start_tag_id, end_tag_id]{
+                            m_capture_id_to_tag_id_pair.at(capture_id)
+                    };
+                    tag_ids.push_back(start_tag_id);
+                    tag_ids.push_back(end_tag_id);
+                }
+            }
+            m_dfa->optimize_registers(rule_id_to_tag_ids);
+        }
+        if (m_minimize_dfa) {
+            m_dfa->minimize();
+        }
+        m_runtime_dfa = std::make_unique<finite_automata::RuntimeDfa>(*m_dfa);
+        set_up_registers(m_dfa->get_multi_valued_regs(), m_dfa->get_tag_id_to_final_reg_id());
+        for (uint32_t i{0}; i < cSizeOfByte; ++i) {
+            is_variable_start[i] = m_dfa->get_root()->get_transition(i).has_value();
+        }
+    }
 
-    auto const* state = m_dfa->get_root();
     for (uint32_t i = 0; i < cSizeOfByte; i++) {
-        m_is_first_char_of_a_variable[i] = state->get_transition(i).has_value();
+        m_byte_flags[i] &= ~(cNewlineFlag | cVariableStartFlag);
+        if (false == m_has_delimiters) {
+            m_byte_flags[i] |= cMatchEndFlag;
+        }
+        if (is_variable_start[i]) {
+            m_byte_flags[i] |= cVariableStartFlag;
+        }
+    }
+    m_byte_flags['\n'] |= cNewlineFlag;
+
+    set_up_scan_tables();
+
+    // Skipping a rejected token is only exact if it can't contain a newline, which must be counted
+    m_token_prefilter = {};
+    if (m_has_delimiters && is_delimiter['\n'] && nullptr != m_dfa
+        && false == finite_automata::RuntimeDfa::is_accepting(m_runtime_dfa->get_root()))
+    {
+        m_token_prefilter = TokenPrefilter{m_rules, *m_runtime_dfa, is_delimiter};
+    }
+}
+
+template <typename TypedNfaState, typename TypedDfaState>
+auto Lexer<TypedNfaState, TypedDfaState>::set_up_scan_tables() -> void {
+    auto const is_stop_byte{get_bytes_with_any_flag(cDelimiterFlag | cNewlineFlag)};
+    // Without delimiters every byte may end a match, so no state can be skipped through. States
+    // determinized on demand are never accelerated, and states loaded from an image were already
+    // accelerated before being written.
+    if (m_has_delimiters && nullptr != m_dfa) {
+        m_runtime_dfa->accelerate_states(is_stop_byte);
+    }
+
+    std::array<bool, cSizeOfByte> is_variable_start_delimiter{};
+    for (uint32_t i{0}; i < cSizeOfByte; ++i) {
+        is_variable_start_delimiter[i]
+                = cVariableStartDelimiterFlags
+                  == (m_byte_flags[i] & cVariableStartDelimiterFlags);
+    }
+    m_variable_start_delimiters = ByteSet{is_variable_start_delimiter};
+    m_stop_bytes = ByteSet{is_stop_byte};
+}
+
+template <typename TypedNfaState, typename TypedDfaState>
+auto Lexer<TypedNfaState, TypedDfaState>::serialize_binary() const -> std::vector<uint8_t> {
+    if (nullptr == m_dfa) {
+        throw std::logic_error(
+                "Only a lexer generated with a fully determinized DFA can be serialized."
+        );
+    }
+    BinaryWriter writer;
+    serialize_symbol_tables(writer);
+    m_dfa->serialize_binary(writer);
+    m_token_prefilter.serialize_binary(writer);
+    return seal_binary_blob(cBinaryMagic, cBinaryVersion, writer.get_bytes());
+}
+
+template <typename TypedNfaState, typename TypedDfaState>
+auto Lexer<TypedNfaState, TypedDfaState>::load_binary(std::span<uint8_t const> const blob)
+        -> void {
+    BinaryReader reader{unseal_binary_blob(cBinaryMagic, cBinaryVersion, blob)};
+    auto symbol_tables{load_symbol_tables(reader)};
+    auto dfa{finite_automata::Dfa<TypedDfaState, TypedNfaState>::load_binary(reader)};
+    std::array<bool, cSizeOfByte> is_delimiter{};
+    for (uint32_t i{0}; i < cSizeOfByte; ++i) {
+        is_delimiter[i] = 0 != (symbol_tables.m_byte_flags[i] & cDelimiterFlag);
+    }
+    auto token_prefilter{TokenPrefilter::load_binary(reader, is_delimiter)};
+    if (false == reader.is_done()) {
+        throw std::runtime_error("Binary lexer has unexpected trailing data.");
+    }
+
+    // Only modify the lexer once the whole blob is known to be valid
+    set_symbol_tables(std::move(symbol_tables));
+    m_dfa = std::move(dfa);
+    m_runtime_dfa = std::make_unique<finite_automata::RuntimeDfa>(*m_dfa);
+    set_up_registers(m_dfa->get_multi_valued_regs(), m_dfa->get_tag_id_to_final_reg_id());
+    m_token_prefilter = std::move(token_prefilter);
+    set_up_scan_tables();
+}
+
+template <typename TypedNfaState, typename TypedDfaState>
+auto Lexer<TypedNfaState, TypedDfaState>::serialize_image() const -> std::vector<uint8_t> {
+    if (nullptr == m_runtime_dfa || nullptr != m_lazy_dfa) {
+        throw std::logic_error(
+                "Only a lexer with a fully determinized DFA can be serialized to an image."
+        );
+    }
+    BinaryWriter writer;
+    serialize_symbol_tables(writer);
+    std::vector<uint8_t> const multi_valued_regs(
+            m_multi_valued_regs.cbegin(),
+            m_multi_valued_regs.cend()
+    );
+    writer.write_vector(multi_valued_regs);
+    writer.write(static_cast<uint64_t>(m_tag_id_to_final_reg_id.size()));
+    for (auto const& [tag_id, reg_id] : m_tag_id_to_final_reg_id) {
+        writer.write(tag_id);
+        writer.write(reg_id);
+    }
+    m_token_prefilter.serialize_binary(writer);
+    m_runtime_dfa->serialize_image(writer);
+    return seal_binary_blob(cImageMagic, cImageVersion, writer.get_bytes());
+}
+
+template <typename TypedNfaState, typename TypedDfaState>
+auto Lexer<TypedNfaState, TypedDfaState>::load_image(std::span<uint8_t const> const image)
+        -> void {
+    BinaryReader reader{unseal_binary_blob(cImageMagic, cImageVersion, image)};
+    auto symbol_tables{load_symbol_tables(reader)};
+    std::vector<bool> multi_valued_regs;
+    for (auto const multi_valued : reader.read_vector<uint8_t>()) {
+        if (multi_valued > 1) {
+            throw std::runtime_error("Lexer image has a register of an invalid kind.");
+        }
+        multi_valued_regs.push_back(1 == multi_valued);
+    }
+    std::map<tag_id_t, reg_id_t> tag_id_to_final_reg_id;
+    auto const num_tags{reader.read_size(sizeof(tag_id_t) + sizeof(reg_id_t))};
+    for (size_t i{0}; i < num_tags; ++i) {
+        auto const tag_id{reader.read<tag_id_t>()};
+        auto const reg_id{reader.read<reg_id_t>()};
+        if (reg_id >= multi_valued_regs.size()) {
+            throw std::runtime_error("Lexer image has a tag in an invalid register.");
+        }
+        tag_id_to_final_reg_id.emplace(tag_id, reg_id);
+    }
+    std::array<bool, cSizeOfByte> is_delimiter{};
+    for (uint32_t i{0}; i < cSizeOfByte; ++i) {
+        is_delimiter[i] = 0 != (symbol_tables.m_byte_flags[i] & cDelimiterFlag);
+    }
+    auto token_prefilter{TokenPrefilter::load_binary(reader, is_delimiter)};
+    auto runtime_dfa{finite_automata::RuntimeDfa::load_image(reader, multi_valued_regs.size())};
+    if (false == reader.is_done()) {
+        throw std::runtime_error("Lexer image has unexpected trailing data.");
+    }
+
+    // Only modify the lexer once the whole image is known to be valid
+    set_symbol_tables(std::move(symbol_tables));
+    m_dfa = nullptr;
+    m_runtime_dfa = std::move(runtime_dfa);
+    set_up_registers(std::move(multi_valued_regs), std::move(tag_id_to_final_reg_id));
+    m_token_prefilter = std::move(token_prefilter);
+    set_up_scan_tables();
+}
+
+template <typename TypedNfaState, typename TypedDfaState>
+auto Lexer<TypedNfaState, TypedDfaState>::serialize_symbol_tables(BinaryWriter& writer) const
+        -> void {
+    writer.write(m_byte_flags);
+    writer.write(m_has_delimiters);
+    writer.write(m_has_tags);
+
+    std::map<rule_id_t, std::string> const sorted_id_symbol{
+            m_id_symbol.cbegin(),
+            m_id_symbol.cend()
+    };
+    writer.write(static_cast<uint64_t>(sorted_id_symbol.size()));
+    for (auto const& [id, symbol] : sorted_id_symbol) {
+        writer.write(id);
+        writer.write_string(symbol);
+    }
+    std::map<std::string, rule_id_t> const sorted_symbol_id{
+            m_symbol_id.cbegin(),
+            m_symbol_id.cend()
+    };
+    writer.write(static_cast<uint64_t>(sorted_symbol_id.size()));
+    for (auto const& [symbol, id] : sorted_symbol_id) {
+        writer.write_string(symbol);
+        writer.write(id);
+    }
+
+    std::map<rule_id_t, std::vector<capture_id_t>> const sorted_rule_id_to_capture_ids{
+            m_rule_id_to_capture_ids.cbegin(),
+            m_rule_id_to_capture_ids.cend()
+    };
+    writer.write(static_cast<uint64_t>(sorted_rule_id_to_capture_ids.size()));
+    for (auto const& [rule_id, capture_ids] : sorted_rule_id_to_capture_ids) {
+        writer.write(rule_id);
+        writer.write_vector(capture_ids);
+    }
+    std::map<capture_id_t, std::pair<tag_id_t, tag_id_t>> const sorted_capture_id_to_tag_id_pair{
+            m_capture_id_to_tag_id_pair.cbegin(),
+            m_capture_id_to_tag_id_pair.cend()
+    };
+    writer.write(static_cast<uint64_t>(sorted_capture_id_to_tag_id_pair.size()));
+    for (auto const& [capture_id, tag_id_pair] : sorted_capture_id_to_tag_id_pair) {
+        writer.write(capture_id);
+        writer.write(tag_id_pair.first);
+        writer.write(tag_id_pair.second);
+    }
+}
+
+template <typename TypedNfaState, typename TypedDfaState>
+auto Lexer<TypedNfaState, TypedDfaState>::load_symbol_tables(BinaryReader& reader)
+        -> SymbolTables {
+    SymbolTables symbol_tables;
+    symbol_tables.m_byte_flags = reader.read<std::array<uint8_t, cSizeOfByte>>();
+    symbol_tables.m_has_delimiters = reader.read<bool>();
+    symbol_tables.m_has_tags = reader.read<bool>();
+
+    auto const num_ids{reader.read_size(sizeof(rule_id_t) + sizeof(uint64_t))};
+    for (size_t i{0}; i < num_ids; ++i) {
+        auto const id{reader.read<rule_id_t>()};
+        symbol_tables.m_id_symbol.emplace(id, reader.read_string());
+    }
+    auto const num_symbols{reader.read_size(sizeof(uint64_t) + sizeof(rule_id_t))};
+    for (size_t i{0}; i < num_symbols; ++i) {
+        auto symbol{reader.read_string()};
+        symbol_tables.m_symbol_id.emplace(std::move(symbol), reader.read<rule_id_t>());
+    }
+
+    auto const num_rules_with_captures{reader.read_size(sizeof(rule_id_t) + sizeof(uint64_t))};
+    for (size_t i{0}; i < num_rules_with_captures; ++i) {
+        auto const rule_id{reader.read<rule_id_t>()};
+        symbol_tables.m_rule_id_to_capture_ids.emplace(
+                rule_id,
+                reader.read_vector<capture_id_t>()
+        );
+    }
+    auto const num_captures{reader.read_size(sizeof(capture_id_t) + 2 * sizeof(tag_id_t))};
+    for (size_t i{0}; i < num_captures; ++i) {
+        auto const capture_id{reader.read<capture_id_t>()};
+        auto const start_tag_id{reader.read<tag_id_t>()};
+        auto const end_tag_id{reader.read<tag_id_t>()};
+        symbol_tables.m_capture_id_to_tag_id_pair.emplace(
+                capture_id,
+                std::make_pair(start_tag_id, end_tag_id)
+        );
+    }
+    return symbol_tables;
+}
+
+template <typename TypedNfaState, typename TypedDfaState>
+auto Lexer<TypedNfaState, TypedDfaState>::set_symbol_tables(SymbolTables symbol_tables) -> void {
+    m_byte_flags = symbol_tables.m_byte_flags;
+    m_has_delimiters = symbol_tables.m_has_delimiters;
+    m_has_tags = symbol_tables.m_has_tags;
+    m_id_symbol = std::move(symbol_tables.m_id_symbol);
+    m_symbol_id = std::move(symbol_tables.m_symbol_id);
+    m_rule_id_to_capture_ids = std::move(symbol_tables.m_rule_id_to_capture_ids);
+    m_capture_id_to_tag_id_pair = std::move(symbol_tables.m_capture_id_to_tag_id_pair);
+    m_rules.clear();
+    m_lazy_dfa = nullptr;
+}
+
+template <typename TypedNfaState, typename TypedDfaState>
+auto Lexer<TypedNfaState, TypedDfaState>::set_up_registers(
+        std::vector<bool> multi_valued_regs,
+        std::map<tag_id_t, reg_id_t> tag_id_to_final_reg_id
+) -> void {
+    m_multi_valued_regs = std::move(multi_valued_regs);
+    m_tag_id_to_final_reg_id = std::move(tag_id_to_final_reg_id);
+    m_reg_handler = finite_automata::RegisterHandler();
+    for (auto const multi_valued : m_multi_valued_regs) {
+        m_reg_handler.add_register(multi_valued);
+    }
+    m_reg_replayer = std::make_unique<finite_automata::RegisterReplayer>(
+            *m_runtime_dfa,
+            m_multi_valued_regs
+    );
+    m_rule_id_to_capture_regs.clear();
+    m_rule_id_to_capture_reg_ids.clear();
+    for (auto const& [rule_id, capture_ids] : m_rule_id_to_capture_ids) {
+        auto& capture_regs{m_rule_id_to_capture_regs[rule_id]};
+        std::vector<reg_id_t> capture_reg_ids;
+        for (auto const capture_id : capture_ids) {
+            auto const optional_reg_id_pair{get_reg_ids_from_capture_id(capture_id)};
+            if (optional_reg_id_pair.has_value()) {
+                auto const [start_reg_id, end_reg_id]{optional_reg_id_pair.value()};
+                capture_regs.push_back({capture_id, start_reg_id, end_reg_id});
+                capture_reg_ids.push_back(start_reg_id);
+                capture_reg_ids.push_back(end_reg_id);
+            }
+        }
+        if (capture_reg_ids.empty()) {
+            continue;
+        }
+        std::ranges::sort(capture_reg_ids);
+        auto const duplicates{std::ranges::unique(capture_reg_ids)};
+        capture_reg_ids.erase(duplicates.begin(), duplicates.end());
+        m_rule_id_to_capture_reg_ids.emplace(rule_id, std::move(capture_reg_ids));
     }
 }
 }  // namespace log_surgeon
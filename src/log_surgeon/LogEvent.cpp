@@ -61,27 +61,16 @@ auto LogEventView::get_logtype() const -> std::string {
             {
                 logtype += token.get_delimiter();
             }
-            if (auto const& optional_capture_ids{
-                        m_log_parser.m_lexer.get_capture_ids_from_rule_id(rule_id)
+            if (auto const optional_capture_regs{
+                        m_log_parser.m_lexer.get_capture_regs_from_rule_id(rule_id)
                 };
-                optional_capture_ids.has_value())
+                optional_capture_regs.has_value())
             {
-                auto const& capture_ids{optional_capture_ids.value()};
-                std::vector<std::pair<reg_id_t, reg_id_t>> register_pairs;
-                for (auto const capture_id : capture_ids) {
-                    auto const& optional_reg_id_pair{
-                            m_log_parser.m_lexer.get_reg_ids_from_capture_id(capture_id)
-                    };
-                    if (optional_reg_id_pair.has_value()) {
-                        register_pairs.push_back(optional_reg_id_pair.value());
-                    }
-                }
                 auto const tag_formatter = [&](capture_id_t id) {
                     return "<" + m_log_parser.get_id_symbol(id) + ">";
                 };
                 token.append_context_to_logtype(
-                        register_pairs,
-                        capture_ids,
+                        optional_capture_regs.value(),
                         tag_formatter,
                         logtype
                 );
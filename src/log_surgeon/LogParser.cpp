@@ -4,9 +4,12 @@
 #include <iostream>
 #include <memory>
 #include <optional>
+#include <span>
+#include <utility>
 
 #include <log_surgeon/Constants.hpp>
 #include <log_surgeon/FileReader.hpp>
+#include <log_surgeon/MappedFile.hpp>
 #include <log_surgeon/ParserAst.hpp>
 #include <log_surgeon/SchemaParser.hpp>
 
@@ -37,6 +40,17 @@ LogParser::LogParser(std::unique_ptr<SchemaAST> schema_ast) {
     m_log_event_view = make_unique<LogEventView>(*this);
 }
 
+LogParser::LogParser(std::span<uint8_t const> serialized_lexer) {
+    m_lexer.load_binary(serialized_lexer);
+    m_log_event_view = make_unique<LogEventView>(*this);
+}
+
+LogParser::LogParser(std::shared_ptr<MappedFile const> lexer_image)
+        : m_lexer_image{std::move(lexer_image)} {
+    m_lexer.load_image(m_lexer_image->get_bytes());
+    m_log_event_view = make_unique<LogEventView>(*this);
+}
+
 auto LogParser::set_delimiters(unique_ptr<ParserAST> const& delimiters) -> void {
     auto* delimiters_ptr = dynamic_cast<DelimiterStringAST*>(delimiters.get());
     if (delimiters_ptr != nullptr) {
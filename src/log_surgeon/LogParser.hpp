@@ -2,13 +2,17 @@
 #define LOG_SURGEON_LOG_PARSER_HPP
 
 #include <cassert>
+#include <cstdint>
 #include <iostream>
 #include <memory>
+#include <span>
+#include <vector>
 
 #include <log_surgeon/Constants.hpp>
 #include <log_surgeon/Lalr1Parser.hpp>
 #include <log_surgeon/LogEvent.hpp>
 #include <log_surgeon/LogParserOutputBuffer.hpp>
+#include <log_surgeon/MappedFile.hpp>
 #include <log_surgeon/Parser.hpp>
 #include <log_surgeon/ParserAst.hpp>
 #include <log_surgeon/ParserInputBuffer.hpp>
@@ -41,6 +45,23 @@ public:
      */
     explicit LogParser(std::unique_ptr<log_surgeon::SchemaAST> schema_ast);
 
+    /**
+     * Constructs the parser using a lexer serialized by `serialize_lexer`, without parsing a
+     * schema or building the lexer's DFA.
+     * @param serialized_lexer
+     * @throw std::runtime_error from Lexer::load_binary if the serialized lexer is invalid.
+     */
+    explicit LogParser(std::span<uint8_t const> serialized_lexer);
+
+    /**
+     * Constructs the parser using a lexer image written by `serialize_lexer_image`, which the
+     * lexer uses in place rather than copying its DFA (see Lexer::load_image). Parsers in any
+     * number of processes can therefore share one mapping of the image.
+     * @param lexer_image A mapping of the image, which the parser keeps alive.
+     * @throw std::runtime_error from Lexer::load_image if the image is invalid.
+     */
+    explicit LogParser(std::shared_ptr<MappedFile const> lexer_image);
+
     /**
      * Returns the parser to its initial state, clearing any existing
      * parsed/lexed state.
@@ -72,6 +93,22 @@ public:
      */
     auto get_symbol_id(std::string const& symbol) const -> std::optional<uint32_t>;
 
+    /**
+     * @return The parser's lexer serialized with Lexer::serialize_binary, from which an equivalent
+     * parser can be constructed.
+     * @throw std::logic_error from Lexer::serialize_binary.
+     */
+    auto serialize_lexer() const -> std::vector<uint8_t> { return m_lexer.serialize_binary(); }
+
+    /**
+     * @return The parser's lexer serialized with Lexer::serialize_image, which can be written to a
+     * file and mapped to construct equivalent parsers.
+     * @throw std::logic_error from Lexer::serialize_image.
+     */
+    auto serialize_lexer_image() const -> std::vector<uint8_t> {
+        return m_lexer.serialize_image();
+    }
+
     /**
      * Manually sets up the underlying input buffer. The ParserInputBuffer will
      * no longer use the currently set underlying storage and instead use what
@@ -88,6 +125,17 @@ public:
         m_input_buffer.set_storage(storage, size, pos, finished_reading_input);
     }
 
+    /**
+     * Moves to pos in the input buffer last set up by set_input_buffer,
+     * promising that its contents haven't changed since, so that the lexer can
+     * keep what it computed over them (see
+     * ParserInputBuffer::set_pos_in_unchanged_storage).
+     * @param pos The current position into the buffer to set.
+     */
+    auto set_pos_in_unchanged_input_buffer(uint32_t pos) -> void {
+        m_input_buffer.set_pos_in_unchanged_storage(pos);
+    }
+
     /**
      * @return the current position inside the input buffer.
      */
@@ -109,10 +157,38 @@ public:
      */
     auto increase_capacity() -> void { m_lexer.increase_buffer_capacity(m_input_buffer); }
 
+    /**
+     * Sets how the lexer finds tokens. All modes produce the same tokens.
+     * @param lexing_mode
+     */
+    auto set_lexing_mode(LexingMode lexing_mode) -> void {
+        m_lexer.set_lexing_mode(lexing_mode);
+    }
+
+    /**
+     * Sets whether the captures of a token are only located when they're read. Either way, the
+     * parser produces the same tokens and captures.
+     * @param lazy_captures
+     */
+    auto set_lazy_captures(bool lazy_captures) -> void {
+        m_lexer.set_lazy_captures(lazy_captures);
+    }
+
+    /**
+     * @return The number of bytes the lexer has moved past since the last reset, counting bytes
+     * scanned more than once every time.
+     */
+    [[nodiscard]] auto get_num_scanned_bytes() const -> uint64_t {
+        return m_lexer.get_num_scanned_bytes();
+    }
+
     /**
      * Resets the log event view to prepare for the next parse
      */
-    auto reset_log_event_view() -> void { m_log_event_view->reset(); }
+    auto reset_log_event_view() -> void {
+        m_log_event_view->reset();
+        m_lexer.release_old_token_registers();
+    }
 
     /**
      * @return the log event view based on the last parse
@@ -162,6 +238,8 @@ private:
     bool m_has_start_of_log{false};
     Token m_start_of_log_message{};
     std::unique_ptr<LogEventView> m_log_event_view{nullptr};
+    // The image the lexer's DFA is read from, if any
+    std::shared_ptr<MappedFile const> m_lexer_image;
 };
 }  // namespace log_surgeon
 
@@ -2,6 +2,7 @@
 #define LOG_SURGEON_LOG_PARSER_OUTPUT_BUFFER_HPP
 
 #include <log_surgeon/Buffer.hpp>
+#include <log_surgeon/Constants.hpp>
 #include <log_surgeon/Token.hpp>
 
 namespace log_surgeon {
@@ -61,7 +62,7 @@ private:
     bool m_has_timestamp{false};
     bool m_has_delimiters{false};
     // contains the static and dynamic Token buffers
-    Buffer<Token> m_storage{};
+    Buffer<Token, cStaticTokenBuffSize> m_storage{};
 };
 }  // namespace log_surgeon
 
@@ -0,0 +1,59 @@
+#include "MappedFile.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <fmt/core.h>
+
+using std::string;
+
+namespace log_surgeon {
+MappedFile::MappedFile(string const& path) {
+    auto const fd{open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+    if (-1 == fd) {
+        throw std::runtime_error(fmt::format("Failed to open {}: {}", path, std::strerror(errno)));
+    }
+    try {
+        map(fd);
+    } catch (std::runtime_error const&) {
+        close(fd);
+        throw;
+    }
+    // NOTE: The mapping stays valid after the file is closed
+    close(fd);
+}
+
+MappedFile::MappedFile(int const fd) {
+    map(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (nullptr != m_data) {
+        munmap(m_data, m_size);
+    }
+}
+
+auto MappedFile::map(int const fd) -> void {
+    struct stat file_stat{};
+    if (0 != fstat(fd, &file_stat)) {
+        throw std::runtime_error(fmt::format("Failed to stat file: {}", std::strerror(errno)));
+    }
+    m_size = static_cast<size_t>(file_stat.st_size);
+    // An empty range can't be mapped
+    if (0 == m_size) {
+        return;
+    }
+    auto* const data{mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0)};
+    if (MAP_FAILED == data) {
+        throw std::runtime_error(fmt::format("Failed to map file: {}", std::strerror(errno)));
+    }
+    m_data = data;
+}
+}  // namespace log_surgeon
@@ -0,0 +1,59 @@
+#ifndef LOG_SURGEON_MAPPED_FILE_HPP
+#define LOG_SURGEON_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+namespace log_surgeon {
+/**
+ * A read-only, shared memory mapping of a whole file, e.g., of a lexer image (see
+ * `Lexer::serialize_image`), so that every process mapping the file shares its pages.
+ */
+class MappedFile {
+public:
+    /**
+     * Maps the file at `path`.
+     * @param path
+     * @throw std::runtime_error if the file can't be opened or mapped.
+     */
+    explicit MappedFile(std::string const& path);
+
+    /**
+     * Maps the whole file referred to by `fd`, e.g., a file created with `memfd_create`. The
+     * mapping doesn't depend on `fd`, which stays owned by the caller and can be closed right away.
+     * @param fd
+     * @throw std::runtime_error if the file can't be mapped.
+     */
+    explicit MappedFile(int fd);
+
+    // Delete copy & move constructors and assignment operators, as the mapping is unmapped once
+    MappedFile(MappedFile const&) = delete;
+    MappedFile(MappedFile&&) = delete;
+    auto operator=(MappedFile const&) -> MappedFile& = delete;
+    auto operator=(MappedFile&&) -> MappedFile& = delete;
+
+    ~MappedFile();
+
+    /**
+     * @return The file's contents, which are valid as long as the mapping is, and are aligned to
+     * a page.
+     */
+    [[nodiscard]] auto get_bytes() const -> std::span<uint8_t const> {
+        return {static_cast<uint8_t const*>(m_data), m_size};
+    }
+
+private:
+    /**
+     * @param fd
+     * @throw std::runtime_error if the file can't be mapped.
+     */
+    auto map(int fd) -> void;
+
+    void* m_data{nullptr};
+    size_t m_size{0};
+};
+}  // namespace log_surgeon
+
+#endif  // LOG_SURGEON_MAPPED_FILE_HPP
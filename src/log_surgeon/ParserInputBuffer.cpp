@@ -1,8 +1,11 @@
 #include "ParserInputBuffer.hpp"
 
+#include <algorithm>
 #include <memory>
+#include <span>
 #include <string>
 
+#include <log_surgeon/ByteSet.hpp>
 #include <log_surgeon/Constants.hpp>
 
 using std::string;
@@ -16,6 +19,7 @@ auto ParserInputBuffer::reset() -> void {
     m_last_read_first_half = false;
     m_storage.reset();
     m_consumed_pos = m_storage.size() - 1;
+    ++m_generation;
 }
 
 auto ParserInputBuffer::read_is_safe() -> bool {
@@ -58,6 +62,7 @@ auto ParserInputBuffer::read(Reader& reader) -> ErrorCode {
     if (m_pos_last_read_char > m_storage.size()) {
         m_pos_last_read_char -= m_storage.size();
     }
+    ++m_generation;
     return ErrorCode::Success;
 }
 
@@ -81,6 +86,7 @@ auto ParserInputBuffer::increase_capacity(uint32_t& old_storage_size, bool& flip
     m_last_read_first_half = true;
     m_pos_last_read_char = new_storage_size - old_storage_size;
     m_storage.set_pos(old_storage_size);
+    ++m_generation;
 }
 
 auto ParserInputBuffer::get_next_character(unsigned char& next_char) -> ErrorCode {
@@ -103,6 +109,38 @@ auto ParserInputBuffer::get_next_character(unsigned char& next_char) -> ErrorCod
     return ErrorCode::Success;
 }
 
+auto ParserInputBuffer::get_readable_span() const -> std::span<char const> {
+    auto const pos{m_storage.pos()};
+    auto const half_size{m_storage.size() / 2};
+    if ((m_finished_reading_input && pos == m_pos_last_read_char)
+        || (m_last_read_first_half && pos == half_size)
+        || (false == m_last_read_first_half && 0 == pos))
+    {
+        return {};
+    }
+    // Past the end of the half last read, the older half continues until the wrap around
+    uint32_t end{m_last_read_first_half && pos < half_size ? half_size : m_storage.size()};
+    if (m_finished_reading_input && pos < m_pos_last_read_char) {
+        end = std::min(end, m_pos_last_read_char);
+    }
+    return {m_storage.get_active_buffer() + pos, end - pos};
+}
+
+auto ParserInputBuffer::readable_span_reaches_end() const -> bool {
+    return m_finished_reading_input && m_pos_last_read_char < m_storage.size()
+           && m_storage.pos() + get_readable_span().size() == m_pos_last_read_char;
+}
+
+auto ParserInputBuffer::skip_to_next_in(ByteSet const& byte_set) -> uint32_t {
+    auto const span{get_readable_span()};
+    auto const* span_end{span.data() + span.size()};
+    auto const num_skipped{
+            static_cast<uint32_t>(byte_set.find_first(span.data(), span_end) - span.data())
+    };
+    advance(num_skipped);
+    return num_skipped;
+}
+
 // This is a work around to allow the BufferParser to work without needing
 // the user to wrap their input buffer. It tricks the LogParser and
 // ParserInputBuffer into thinking it never reaches the wrap, while still
@@ -119,4 +157,15 @@ auto ParserInputBuffer::set_storage(
     m_pos_last_read_char = size;
     m_last_read_first_half = true;
 }
+
+auto ParserInputBuffer::set_pos_in_unchanged_storage(uint32_t pos) -> void {
+    auto const generation{m_generation};
+    set_storage(
+            m_storage.get_mutable_active_buffer(),
+            m_storage.size() / 2,
+            pos,
+            m_finished_reading_input
+    );
+    m_generation = generation;
+}
 }  // namespace log_surgeon
@@ -1,8 +1,12 @@
 #ifndef LOG_SURGEON_PARSER_INPUT_BUFFER_HPP
 #define LOG_SURGEON_PARSER_INPUT_BUFFER_HPP
 
+#include <cstdint>
+#include <span>
+
 // Project Headers
 #include "Buffer.hpp"
+#include "ByteSet.hpp"
 #include "Constants.hpp"
 
 namespace log_surgeon {
@@ -66,6 +70,45 @@ public:
      */
     auto get_next_character(unsigned char& next_char) -> ErrorCode;
 
+    /**
+     * Returns the largest contiguous span of characters, starting at the
+     * current position, that get_next_character would return without
+     * reaching the end of the input, a half of the buffer that hasn't been
+     * read into, or the end of the underlying storage. Callers can iterate
+     * over the span directly and then call advance, and only need to use
+     * get_next_character once the span is empty.
+     * @return The readable span, which is empty if the next call to
+     * get_next_character would not return a character from the buffer.
+     */
+    [[nodiscard]] auto get_readable_span() const -> std::span<char const>;
+
+    /**
+     * @return Whether the readable span extends to the end of the input,
+     * i.e., the input has been fully read into the buffer and no character
+     * other than the end of the input follows the span.
+     */
+    [[nodiscard]] auto readable_span_reaches_end() const -> bool;
+
+    /**
+     * Advances the current position past characters of the readable span.
+     * @param num_chars The number of characters to advance past, which must
+     * not exceed the size of the readable span.
+     */
+    auto advance(uint32_t num_chars) -> void {
+        auto const pos{m_storage.pos() + num_chars};
+        m_storage.set_pos(pos == m_storage.size() ? 0 : pos);
+    }
+
+    /**
+     * Advances the current position to the next character in `byte_set`,
+     * without moving past the end of the readable span. Callers should keep
+     * using get_next_character to consume the character and to handle any
+     * boundary.
+     * @param byte_set The characters to stop at.
+     * @return The number of characters skipped.
+     */
+    auto skip_to_next_in(ByteSet const& byte_set) -> uint32_t;
+
     /**
      * Set the current position of the underlying buffer.
      * @param pos The value to set.
@@ -111,11 +154,27 @@ public:
     auto set_storage(char* storage, uint32_t size, uint32_t pos, bool finished_reading_input)
             -> void;
 
+    /**
+     * Equivalent to calling set_storage again with the storage, size and
+     * finished_reading_input last passed to it, but keeps the generation (see
+     * get_generation), so that anything computed over the storage's contents
+     * can be reused. Must only be called after set_storage, and only if the
+     * storage's contents haven't changed since.
+     * @param pos The current position into the storage to set.
+     */
+    auto set_pos_in_unchanged_storage(uint32_t pos) -> void;
+
     /**
      * Return a reference to the underlying storage buffer.
      */
     [[nodiscard]] auto storage() const -> Buffer<char> const& { return m_storage; }
 
+    /**
+     * @return A counter that changes whenever the contents of the storage may have changed, i.e.,
+     * when it's read into, grown, reset, or replaced by different storage.
+     */
+    [[nodiscard]] auto get_generation() const -> uint64_t { return m_generation; }
+
 private:
     /**
      * Reads into the half of the buffer currently available.
@@ -135,6 +194,8 @@ private:
     Buffer<char> m_storage{};
     // the position last used by the caller (no longer needed in storage)
     uint32_t m_consumed_pos{m_storage.size() - 1};
+    // changes whenever the contents of the storage may have changed
+    uint64_t m_generation{0};
 };
 }  // namespace log_surgeon
 
@@ -1,9 +1,14 @@
 #include "ReaderParser.hpp"
 
+#include <cstdint>
+#include <memory>
+#include <span>
 #include <string>
+#include <utility>
 
 #include <log_surgeon/Constants.hpp>
 #include <log_surgeon/LogEvent.hpp>
+#include <log_surgeon/MappedFile.hpp>
 #include <log_surgeon/Schema.hpp>
 
 namespace log_surgeon {
@@ -12,6 +17,12 @@ ReaderParser::ReaderParser(std::unique_ptr<log_surgeon::SchemaAST> schema_ast)
 
 ReaderParser::ReaderParser(std::string const& schema_file_path) : m_log_parser(schema_file_path) {}
 
+ReaderParser::ReaderParser(std::span<uint8_t const> serialized_lexer)
+        : m_log_parser(serialized_lexer) {}
+
+ReaderParser::ReaderParser(std::shared_ptr<MappedFile const> lexer_image)
+        : m_log_parser(std::move(lexer_image)) {}
+
 auto ReaderParser::reset_and_set_reader(Reader& reader) -> void {
     m_done = false;
     m_log_parser.reset();
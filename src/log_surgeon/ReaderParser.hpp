@@ -1,11 +1,15 @@
 #ifndef LOG_SURGEON_READER_PARSER_HPP
 #define LOG_SURGEON_READER_PARSER_HPP
 
+#include <cstdint>
+#include <memory>
 #include <optional>
+#include <span>
 #include <string>
 
 #include <log_surgeon/LogEvent.hpp>
 #include <log_surgeon/LogParser.hpp>
+#include <log_surgeon/MappedFile.hpp>
 #include <log_surgeon/Reader.hpp>
 #include <log_surgeon/Schema.hpp>
 
@@ -33,6 +37,21 @@ public:
      */
     explicit ReaderParser(std::unique_ptr<log_surgeon::SchemaAST> schema_ast);
 
+    /**
+     * Constructs the parser using a lexer serialized by LogParser::serialize_lexer.
+     * @param serialized_lexer
+     * @throw std::runtime_error from LogParser if the serialized lexer is
+     * invalid.
+     */
+    explicit ReaderParser(std::span<uint8_t const> serialized_lexer);
+
+    /**
+     * Constructs the parser using a lexer image written by LogParser::serialize_lexer_image.
+     * @param lexer_image A mapping of the image, which the parser keeps alive.
+     * @throw std::runtime_error from LogParser if the image is invalid.
+     */
+    explicit ReaderParser(std::shared_ptr<MappedFile const> lexer_image);
+
     /**
      * Clears the internal state of the log parser (lexer and input buffer),
      * and sets the reader containing the logs to be parsed. The next call to
@@ -62,6 +81,23 @@ public:
      */
     auto get_log_parser() const -> LogParser const& { return m_log_parser; }
 
+    /**
+     * Sets how the lexer finds tokens. All modes produce the same tokens.
+     * @param lexing_mode
+     */
+    auto set_lexing_mode(LexingMode lexing_mode) -> void {
+        m_log_parser.set_lexing_mode(lexing_mode);
+    }
+
+    /**
+     * Sets whether the captures of a token are only located when they're read. Either way, the
+     * parser produces the same tokens and captures.
+     * @param lazy_captures
+     */
+    auto set_lazy_captures(bool lazy_captures) -> void {
+        m_log_parser.set_lazy_captures(lazy_captures);
+    }
+
     /**
      * @param var The name of the variable as provided in the schema file or
      * when building the LogParser's Schema object.
@@ -56,6 +56,9 @@ SchemaParser::SchemaParser() {
 }
 
 auto SchemaParser::generate_schema_ast(Reader& reader) -> unique_ptr<SchemaAST> {
+    // Children of earlier parses are never read again, so each parse can start from the beginning
+    // of the shared children buffer instead of using up whatever earlier parses left behind.
+    NonTerminal::m_next_children_start = 0;
     NonTerminal nonterminal = parse(reader);
     std::unique_ptr<SchemaAST> schema_ast(
             dynamic_cast<SchemaAST*>(nonterminal.get_parser_ast().release())
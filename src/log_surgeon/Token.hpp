@@ -1,42 +1,81 @@
 #ifndef LOG_SURGEON_TOKEN_HPP
 #define LOG_SURGEON_TOKEN_HPP
 
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <span>
 #include <string>
 #include <string_view>
+#include <type_traits>
 #include <vector>
 
 #include <log_surgeon/finite_automata/PrefixTree.hpp>
-#include <log_surgeon/finite_automata/RegisterHandler.hpp>
+#include <log_surgeon/finite_automata/RegisterSnapshots.hpp>
+#include <log_surgeon/TokenCaptures.hpp>
 #include <log_surgeon/types.hpp>
 
 namespace log_surgeon {
+class TokenSideStorage;
+
+/**
+ * A token is trivially copyable and small, since parsers store and copy many of them. The parts
+ * most tokens don't need, i.e., their registers and contiguous copies of their values if they wrap
+ * around the end of the buffer, are kept in the lexer's `TokenSideStorage`.
+ */
 class Token {
 public:
+    // The value of `m_side_entry_idx` for a token without an entry
+    static constexpr uint32_t cNoSideEntry{UINT32_MAX};
+
     /**
      * @return The token's value as a string
      */
     [[nodiscard]] auto to_string() -> std::string;
 
     /**
-     * @return A string view of the token's value
+     * @return A string view of the token's value. If the value wraps around the end of the buffer,
+     * it's copied to the token's side storage once for the token and its copies, and the view is
+     * only valid until the lexer releases that storage (see `Lexer::release_old_token_registers`).
+     * @throw std::logic_error if the value wraps around the end of the buffer, but the token has no
+     * side storage entry. Tokens returned by `Lexer::scan` and `Lexer::scan_with_wildcard`, and
+     * their copies, have one if they wrap, so only the values of tokens constructed otherwise must
+     * be read with `to_string` if they may wrap.
      */
     [[nodiscard]] auto to_string_view() -> std::string_view;
 
     /**
-     * @param reg_id_pairs The registers id pairs indicating all capture locations in the token.
-     * @param capture_ids The ID for each capture corresponding to `reg_id_pairs`.
+     * @param capture_regs The registers of all the captures in the token.
      * @param tag_formatter A formatting function for inserting the captured variables into the
      * logtype.
      * @param logtype Returns the updated logtype now containing the contextualized token.
      */
     auto append_context_to_logtype(
-            std::vector<std::pair<reg_id_t, reg_id_t>> const& reg_id_pairs,
-            std::vector<capture_id_t> const& capture_ids,
+            std::span<CaptureRegisters const> capture_regs,
             std::function<std::string(capture_id_t)> const& tag_formatter,
             std::string& logtype
     ) const -> void;
 
+    /**
+     * @param capture_regs The registers of the captures to iterate over, e.g., those of the
+     * token's rule (see `Lexer::get_capture_regs_from_rule_id`).
+     * @return A range over the values the captures matched, in the order they start in the token,
+     * which is only valid while the token's registers and buffer are.
+     */
+    [[nodiscard]] auto get_captures(std::span<CaptureRegisters const> capture_regs) const
+            -> TokenCaptures;
+
+    /**
+     * Like `get_captures`, but writes the values to a caller-provided buffer instead.
+     * @param capture_regs
+     * @param captures Returns the first `captures.size()` values, in the order they start.
+     * @return The number of values the captures matched, which may exceed `captures.size()`.
+     */
+    auto get_captures(
+            std::span<CaptureRegisters const> capture_regs,
+            std::span<TokenCapture> captures
+    ) const -> size_t;
+
     /**
      * @return The first character (as a string) of the token string (which is a
      * delimiter if delimiters are being used)
@@ -56,7 +95,8 @@ public:
 
     [[nodiscard]] auto get_reversed_reg_positions(reg_id_t const reg_id) const
             -> std::vector<finite_automata::PrefixTree::position_t> {
-        return m_reg_handler.get_reversed_positions(reg_id);
+        auto const positions{get_reg_snapshot().get_reversed_positions(reg_id)};
+        return {positions.begin(), positions.end()};
     }
 
     uint32_t m_start_pos{0};
@@ -65,9 +105,21 @@ public:
     uint32_t m_buffer_size{0};
     uint32_t m_line{0};
     std::vector<uint32_t> const* m_type_ids_ptr{nullptr};
-    finite_automata::RegisterHandler m_reg_handler{};
-    std::string m_wrap_around_string{};
+    // The lexer's side storage, which is only valid while the lexer keeps it (see
+    // `Lexer::release_old_token_registers`)
+    TokenSideStorage* m_side_storage{nullptr};
+    // The token's entry in `m_side_storage` if it has captures or its value wraps around the end
+    // of the buffer
+    uint32_t m_side_entry_idx{cNoSideEntry};
+
+private:
+    /**
+     * @return The token's registers, replaying them first if they haven't been yet.
+     */
+    [[nodiscard]] auto get_reg_snapshot() const -> finite_automata::RegisterSnapshot;
 };
+
+static_assert(std::is_trivially_copyable_v<Token>);
 }  // namespace log_surgeon
 
 #endif  // LOG_SURGEON_TOKEN_HPP
@@ -0,0 +1,218 @@
+#ifndef LOG_SURGEON_TOKEN_CAPTURES_HPP
+#define LOG_SURGEON_TOKEN_CAPTURES_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include <log_surgeon/finite_automata/PrefixTree.hpp>
+#include <log_surgeon/finite_automata/RegisterSnapshots.hpp>
+#include <log_surgeon/types.hpp>
+
+namespace log_surgeon {
+/**
+ * The registers holding the start and end positions of a capture of a rule (see
+ * `Lexer::get_capture_registers`).
+ */
+struct CaptureRegisters {
+    capture_id_t m_capture_id;
+    reg_id_t m_start_reg_id;
+    reg_id_t m_end_reg_id;
+};
+
+/**
+ * A value a capture matched in a token. Since the token's buffer is circular, the value may wrap
+ * around the end of the buffer, in which case it continues in `m_wrapped_value`.
+ */
+struct TokenCapture {
+    capture_id_t m_capture_id{0};
+    uint32_t m_start_pos{0};
+    uint32_t m_end_pos{0};
+    std::string_view m_value;
+    // The part of the value at the start of the buffer, which is empty unless the value wraps
+    std::string_view m_wrapped_value;
+};
+
+/**
+ * A single-pass range over the values the captures of a token matched, in the order they start in
+ * the token, with captures starting at the same position in the order they're given.
+ *
+ * The positions of each capture are read forward from the token's saved registers, and the
+ * captures are merged as they're iterated, so that iterating doesn't allocate unless the rule has
+ * more than `cNumInlineCursors` captures.
+ */
+class TokenCaptures {
+public:
+    class Iterator {
+    public:
+        using value_type = TokenCapture;
+        using difference_type = std::ptrdiff_t;
+
+        Iterator() = default;
+
+        explicit Iterator(TokenCaptures* captures) : m_captures{captures} {}
+
+        auto operator*() const -> TokenCapture const& { return m_captures->m_curr; }
+
+        auto operator->() const -> TokenCapture const* { return &m_captures->m_curr; }
+
+        auto operator++() -> Iterator& {
+            m_captures->advance();
+            return *this;
+        }
+
+        auto operator++(int) -> void { ++*this; }
+
+        auto operator==(std::default_sentinel_t /*end*/) const -> bool {
+            return m_captures->m_done;
+        }
+
+    private:
+        TokenCaptures* m_captures{nullptr};
+    };
+
+    /**
+     * @param reg_snapshot The token's registers.
+     * @param capture_regs The registers of each capture to iterate over.
+     * @param buffer The token's circular buffer.
+     * @param buffer_size
+     * @param token_start_pos
+     */
+    TokenCaptures(
+            finite_automata::RegisterSnapshot const reg_snapshot,
+            std::span<CaptureRegisters const> const capture_regs,
+            char const* const buffer,
+            uint32_t const buffer_size,
+            uint32_t const token_start_pos
+    )
+            : m_reg_snapshot{reg_snapshot},
+              m_capture_regs{capture_regs},
+              m_buffer{buffer},
+              m_buffer_size{buffer_size},
+              m_token_start_pos{token_start_pos} {
+        if (m_capture_regs.size() > cNumInlineCursors) {
+            m_spilled_cursors.resize(m_capture_regs.size());
+        }
+        auto* cursors{get_cursors()};
+        for (size_t i{0}; i < m_capture_regs.size(); ++i) {
+            auto const start_positions{get_start_positions(i)};
+            cursors[i] = skip_unmatched(start_positions, start_positions.size());
+        }
+        advance();
+    }
+
+    // Iterators point to the range, so it can't be copied or moved
+    TokenCaptures(TokenCaptures const&) = delete;
+    TokenCaptures(TokenCaptures&&) = delete;
+    auto operator=(TokenCaptures const&) -> TokenCaptures& = delete;
+    auto operator=(TokenCaptures&&) -> TokenCaptures& = delete;
+    ~TokenCaptures() = default;
+
+    [[nodiscard]] auto begin() -> Iterator { return Iterator{this}; }
+
+    [[nodiscard]] static auto end() -> std::default_sentinel_t { return std::default_sentinel; }
+
+private:
+    // The number of captures whose cursors are stored without allocating
+    static constexpr size_t cNumInlineCursors{16};
+
+    /**
+     * @param positions A register's positions, from the last to the first.
+     * @param cursor
+     * @return The largest cursor at most `cursor` past a matched position, or 0 if there is none.
+     */
+    [[nodiscard]] static auto skip_unmatched(
+            std::span<finite_automata::PrefixTree::position_t const> const positions,
+            uint32_t cursor
+    ) -> uint32_t {
+        while (0 < cursor && positions[cursor - 1] < 0) {
+            --cursor;
+        }
+        return cursor;
+    }
+
+    [[nodiscard]] auto get_cursors() -> uint32_t* {
+        return m_spilled_cursors.empty() ? m_inline_cursors.data() : m_spilled_cursors.data();
+    }
+
+    [[nodiscard]] auto get_start_positions(size_t const capture_idx) const
+            -> std::span<finite_automata::PrefixTree::position_t const> {
+        return m_reg_snapshot.get_reversed_positions(m_capture_regs[capture_idx].m_start_reg_id);
+    }
+
+    /**
+     * @param pos
+     * @return The offset of `pos` from the start of the token in the circular buffer.
+     */
+    [[nodiscard]] auto get_offset(uint32_t const pos) const -> uint32_t {
+        return m_token_start_pos <= pos ? pos - m_token_start_pos
+                                        : pos + m_buffer_size - m_token_start_pos;
+    }
+
+    /**
+     * Moves `m_curr` to the next capture value, or sets `m_done` if there are no more.
+     */
+    auto advance() -> void;
+
+    finite_automata::RegisterSnapshot m_reg_snapshot;
+    std::span<CaptureRegisters const> m_capture_regs;
+    char const* m_buffer;
+    uint32_t m_buffer_size;
+    uint32_t m_token_start_pos;
+    // For each capture, the number of its positions that haven't been iterated over, which are read
+    // backwards since the registers hold them from the last to the first
+    std::array<uint32_t, cNumInlineCursors> m_inline_cursors{};
+    std::vector<uint32_t> m_spilled_cursors;
+    TokenCapture m_curr;
+    bool m_done{false};
+};
+
+inline auto TokenCaptures::advance() -> void {
+    auto* cursors{get_cursors()};
+    std::optional<size_t> next_capture_idx;
+    uint32_t next_offset{0};
+    for (size_t i{0}; i < m_capture_regs.size(); ++i) {
+        if (0 == cursors[i]) {
+            continue;
+        }
+        auto const offset{
+                get_offset(static_cast<uint32_t>(get_start_positions(i)[cursors[i] - 1]))
+        };
+        if (false == next_capture_idx.has_value() || offset < next_offset) {
+            next_capture_idx = i;
+            next_offset = offset;
+        }
+    }
+    if (false == next_capture_idx.has_value()) {
+        m_done = true;
+        return;
+    }
+
+    auto const capture_idx{next_capture_idx.value()};
+    auto const& capture_regs{m_capture_regs[capture_idx]};
+    auto const start_positions{get_start_positions(capture_idx)};
+    auto const end_positions{m_reg_snapshot.get_reversed_positions(capture_regs.m_end_reg_id)};
+    auto& cursor{cursors[capture_idx]};
+    auto const start_pos{static_cast<uint32_t>(start_positions[cursor - 1])};
+    auto const end_pos{static_cast<uint32_t>(end_positions[cursor - 1])};
+    cursor = skip_unmatched(start_positions, cursor - 1);
+
+    m_curr.m_capture_id = capture_regs.m_capture_id;
+    m_curr.m_start_pos = start_pos;
+    m_curr.m_end_pos = end_pos;
+    if (start_pos <= end_pos) {
+        m_curr.m_value = {m_buffer + start_pos, end_pos - start_pos};
+        m_curr.m_wrapped_value = {};
+    } else {
+        m_curr.m_value = {m_buffer + start_pos, m_buffer_size - start_pos};
+        m_curr.m_wrapped_value = {m_buffer, end_pos};
+    }
+}
+}  // namespace log_surgeon
+
+#endif  // LOG_SURGEON_TOKEN_CAPTURES_HPP
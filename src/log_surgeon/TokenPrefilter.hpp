@@ -0,0 +1,251 @@
+#ifndef LOG_SURGEON_TOKEN_PREFILTER_HPP
+#define LOG_SURGEON_TOKEN_PREFILTER_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <map>
+#include <queue>
+#include <stdexcept>
+#include <vector>
+
+#include <log_surgeon/BinarySerialization.hpp>
+#include <log_surgeon/ByteSet.hpp>
+#include <log_surgeon/Constants.hpp>
+#include <log_surgeon/finite_automata/RegexAST.hpp>
+#include <log_surgeon/finite_automata/RuntimeDfa.hpp>
+#include <log_surgeon/LexicalRule.hpp>
+
+namespace log_surgeon {
+/**
+ * A cheap test that rejects tokens no variable can match, so that the lexer can skip simulating the
+ * DFA on them.
+ *
+ * Lexing a variable starts at a delimiter. If every DFA state reachable from the root on a
+ * delimiter `d` followed by non-delimiters dies on the next delimiter, then any variable matched
+ * from `d` ends right before the next delimiter. A token from `d` up to the next delimiter can then
+ * be rejected if, for every variable reachable from `d`, it lacks a byte from one of the byte sets
+ * required by the variable's rule (see `RegexAST::get_required_byte_sets`).
+ *
+ * The required byte sets of all rules are numbered, so that the sets a token contains are computed
+ * with a single table lookup and bitwise OR per byte.
+ */
+class TokenPrefilter {
+public:
+    static constexpr uint32_t cMaxNumRequiredByteSets{64};
+
+    TokenPrefilter() = default;
+
+    /**
+     * @param rules The rules the DFA was built from.
+     * @param dfa
+     * @param is_delimiter Whether each byte is a delimiter.
+     */
+    template <typename TypedNfaState>
+    TokenPrefilter(
+            std::vector<LexicalRule<TypedNfaState>> const& rules,
+            finite_automata::RuntimeDfa const& dfa,
+            std::array<bool, cSizeOfByte> const& is_delimiter
+    );
+
+    /**
+     * @param start_delimiter
+     * @return Whether every variable matched from `start_delimiter` ends right before the next
+     * delimiter, i.e., the DFA dies on the next delimiter.
+     */
+    [[nodiscard]] auto is_delimiter_bounded(uint8_t const start_delimiter) const -> bool {
+        return m_is_delimiter_bounded[start_delimiter];
+    }
+
+    /**
+     * @param start_delimiter
+     * @return Whether tokens starting with `start_delimiter` can be tested.
+     */
+    [[nodiscard]] auto is_enabled(uint8_t const start_delimiter) const -> bool {
+        return 0 != m_start_delimiter_to_rule_masks_id[start_delimiter];
+    }
+
+    /**
+     * @param begin
+     * @param end
+     * @return A pointer to the first delimiter in [begin, end), or `end` if there is none.
+     */
+    [[nodiscard]] auto find_delimiter(char const* begin, char const* end) const -> char const* {
+        return m_delimiters.find_first(begin, end);
+    }
+
+    /**
+     * @param token_begin A pointer to a start delimiter for which the prefilter is enabled.
+     * @param token_end A pointer to the next delimiter.
+     * @return Whether any variable may match the token.
+     */
+    [[nodiscard]] auto may_match(char const* token_begin, char const* token_end) const -> bool;
+
+    /**
+     * Writes the prefilter in a binary form, which `load_binary` reads back without the rules.
+     * @param writer
+     */
+    auto serialize_binary(BinaryWriter& writer) const -> void;
+
+    /**
+     * @param reader
+     * @param is_delimiter Whether each byte is a delimiter, as given to the serialized prefilter.
+     * @return The prefilter written by `serialize_binary`.
+     * @throw std::runtime_error if the binary data is truncated or describes an invalid prefilter.
+     */
+    [[nodiscard]] static auto
+    load_binary(BinaryReader& reader, std::array<bool, cSizeOfByte> const& is_delimiter)
+            -> TokenPrefilter;
+
+private:
+    ByteSet m_delimiters;
+    std::array<uint64_t, cSizeOfByte> m_byte_to_required_set_bits{};
+    std::array<bool, cSizeOfByte> m_is_delimiter_bounded{};
+    std::array<uint32_t, cSizeOfByte> m_start_delimiter_to_rule_masks_id{};
+    // The required set bits of each variable reachable from a start delimiter. ID 0 is reserved for
+    // start delimiters without a prefilter.
+    std::vector<std::vector<uint64_t>> m_rule_masks{{}};
+};
+
+template <typename TypedNfaState>
+TokenPrefilter::TokenPrefilter(
+        std::vector<LexicalRule<TypedNfaState>> const& rules,
+        finite_automata::RuntimeDfa const& dfa,
+        std::array<bool, cSizeOfByte> const& is_delimiter
+)
+        : m_delimiters{is_delimiter} {
+    using finite_automata::RuntimeDfa;
+
+    std::map<std::array<bool, cSizeOfByte>, uint32_t> required_set_ids;
+    // Several rules may share a variable, which may match if any of its rules' masks is satisfied
+    std::map<uint32_t, std::vector<uint64_t>> variable_id_to_rule_masks;
+    for (auto const& rule : rules) {
+        uint64_t rule_mask{0};
+        for (auto const& byte_set : rule.get_regex()->get_required_byte_sets()) {
+            auto const [it, inserted]{required_set_ids.try_emplace(
+                    byte_set,
+                    static_cast<uint32_t>(required_set_ids.size())
+            )};
+            if (it->second >= cMaxNumRequiredByteSets) {
+                // Dropping a required set only weakens the prefilter
+                required_set_ids.erase(it);
+                continue;
+            }
+            rule_mask |= uint64_t{1} << it->second;
+            if (inserted) {
+                for (uint32_t byte{0}; byte < cSizeOfByte; ++byte) {
+                    if (byte_set[byte]) {
+                        m_byte_to_required_set_bits[byte] |= uint64_t{1} << it->second;
+                    }
+                }
+            }
+        }
+        variable_id_to_rule_masks[rule.get_variable_id()].push_back(rule_mask);
+    }
+
+    for (uint32_t delimiter{0}; delimiter < cSizeOfByte; ++delimiter) {
+        if (false == is_delimiter[delimiter]) {
+            continue;
+        }
+        auto const start_state{dfa.get_next_state(dfa.get_root(), delimiter)};
+        if (RuntimeDfa::cDeadState == start_state) {
+            continue;
+        }
+
+        // Find the variables reachable from the start state without crossing a delimiter
+        std::vector<bool> visited(dfa.get_num_states(), false);
+        std::queue<RuntimeDfa::state_id_t> state_queue;
+        visited[start_state & RuntimeDfa::cStateIndexMask] = true;
+        state_queue.push(start_state);
+        std::vector<uint64_t> rule_masks;
+        bool is_bounded{true};
+        bool has_unconstrained_rule{false};
+        while (is_bounded && false == state_queue.empty()) {
+            auto const state{state_queue.front()};
+            state_queue.pop();
+            if (RuntimeDfa::is_accepting(state)) {
+                for (auto const variable_id : dfa.get_matching_variable_ids(state)) {
+                    for (auto const rule_mask : variable_id_to_rule_masks[variable_id]) {
+                        if (0 == rule_mask) {
+                            has_unconstrained_rule = true;
+                        }
+                        rule_masks.push_back(rule_mask);
+                    }
+                }
+            }
+            for (uint32_t byte{0}; byte < cSizeOfByte; ++byte) {
+                auto const next_state{dfa.get_next_state(state, static_cast<uint8_t>(byte))};
+                if (RuntimeDfa::cDeadState == next_state) {
+                    continue;
+                }
+                if (is_delimiter[byte]) {
+                    is_bounded = false;
+                    break;
+                }
+                if (false == visited[next_state & RuntimeDfa::cStateIndexMask]) {
+                    visited[next_state & RuntimeDfa::cStateIndexMask] = true;
+                    state_queue.push(next_state);
+                }
+            }
+        }
+        m_is_delimiter_bounded[delimiter] = is_bounded;
+        if (false == is_bounded || has_unconstrained_rule || '\n' == delimiter) {
+            continue;
+        }
+        std::ranges::sort(rule_masks);
+        auto const duplicates{std::ranges::unique(rule_masks)};
+        rule_masks.erase(duplicates.begin(), duplicates.end());
+        m_start_delimiter_to_rule_masks_id[delimiter] = m_rule_masks.size();
+        m_rule_masks.push_back(std::move(rule_masks));
+    }
+}
+
+inline auto TokenPrefilter::may_match(char const* token_begin, char const* token_end) const
+        -> bool {
+    uint64_t contained_sets{0};
+    for (auto const* it{token_begin}; it < token_end; ++it) {
+        contained_sets |= m_byte_to_required_set_bits[static_cast<uint8_t>(*it)];
+    }
+    auto const start_delimiter{static_cast<uint8_t>(*token_begin)};
+    for (auto const rule_mask : m_rule_masks[m_start_delimiter_to_rule_masks_id[start_delimiter]]) {
+        if (rule_mask == (contained_sets & rule_mask)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline auto TokenPrefilter::serialize_binary(BinaryWriter& writer) const -> void {
+    writer.write(m_byte_to_required_set_bits);
+    writer.write(m_is_delimiter_bounded);
+    writer.write(m_start_delimiter_to_rule_masks_id);
+    writer.write(static_cast<uint64_t>(m_rule_masks.size()));
+    for (auto const& rule_masks : m_rule_masks) {
+        writer.write_vector(rule_masks);
+    }
+}
+
+inline auto
+TokenPrefilter::load_binary(BinaryReader& reader, std::array<bool, cSizeOfByte> const& is_delimiter)
+        -> TokenPrefilter {
+    TokenPrefilter prefilter;
+    prefilter.m_delimiters = ByteSet{is_delimiter};
+    prefilter.m_byte_to_required_set_bits = reader.read<std::array<uint64_t, cSizeOfByte>>();
+    prefilter.m_is_delimiter_bounded = reader.read<std::array<bool, cSizeOfByte>>();
+    prefilter.m_start_delimiter_to_rule_masks_id
+            = reader.read<std::array<uint32_t, cSizeOfByte>>();
+    auto const num_rule_masks{reader.read_size(sizeof(uint64_t))};
+    prefilter.m_rule_masks.clear();
+    for (size_t i{0}; i < num_rule_masks; ++i) {
+        prefilter.m_rule_masks.push_back(reader.read_vector<uint64_t>());
+    }
+    for (auto const rule_masks_id : prefilter.m_start_delimiter_to_rule_masks_id) {
+        if (rule_masks_id >= prefilter.m_rule_masks.size()) {
+            throw std::runtime_error("Binary token prefilter has invalid rule masks.");
+        }
+    }
+    return prefilter;
+}
+}  // namespace log_surgeon
+
+#endif  // LOG_SURGEON_TOKEN_PREFILTER_HPP
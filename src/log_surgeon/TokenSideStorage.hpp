@@ -0,0 +1,195 @@
+#ifndef LOG_SURGEON_TOKEN_SIDE_STORAGE_HPP
+#define LOG_SURGEON_TOKEN_SIDE_STORAGE_HPP
+
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <log_surgeon/finite_automata/RegisterHandler.hpp>
+#include <log_surgeon/finite_automata/RegisterReplayer.hpp>
+#include <log_surgeon/finite_automata/RegisterSnapshots.hpp>
+#include <log_surgeon/finite_automata/RuntimeDfa.hpp>
+#include <log_surgeon/types.hpp>
+
+namespace log_surgeon {
+/**
+ * Stores the parts of tokens that most tokens don't need, so that a `Token` stays small and
+ * trivially copyable: the registers of tokens with captures, what's needed to replay them for
+ * tokens lexed with lazy captures, and copies of token values that wrap around the end of the
+ * circular buffer. A token refers to its entry by index, which its copies share, so a wrapped value
+ * is copied at most once however often it's viewed.
+ *
+ * Like `finite_automata::RegisterSnapshots`, `clear` keeps the storage of the entries, so that once
+ * it has grown to fit the tokens between two calls to `clear`, adding an entry doesn't allocate.
+ * Copying a wrapped value, which is rare, still allocates.
+ */
+class TokenSideStorage {
+public:
+    /**
+     * Adds an entry for a token whose registers were tracked while lexing.
+     * @param reg_handler The registers at the end of the token.
+     * @param reg_ids The registers to keep, i.e., those of the captures of the token's rules.
+     * @return The index of the entry.
+     */
+    auto add_registers(
+            finite_automata::RegisterHandler const& reg_handler,
+            std::span<reg_id_t const> const reg_ids
+    ) -> uint32_t {
+        m_entries.push_back(
+                {nullptr, 0, 0, 0, 0, m_reg_snapshots.save(reg_handler, reg_ids), cNoWrappedValue}
+        );
+        return static_cast<uint32_t>(m_entries.size() - 1);
+    }
+
+    /**
+     * Adds an entry for a token whose registers are replayed when they're first read.
+     * @param reg_replayer The replayer, which must outlive the entry.
+     * @param match_start_state The state the token's match started in.
+     * @param match_start_pos The position the token's match started at.
+     * @param reg_ids The registers to keep once they're replayed, i.e., those of the captures of
+     * the token's rules.
+     * @return The index of the entry.
+     */
+    auto add_replay(
+            finite_automata::RegisterReplayer& reg_replayer,
+            finite_automata::RuntimeDfa::state_id_t const match_start_state,
+            uint32_t const match_start_pos,
+            std::span<reg_id_t const> const reg_ids
+    ) -> uint32_t {
+        auto const reg_ids_offset{static_cast<uint32_t>(m_replay_reg_ids.size())};
+        m_replay_reg_ids.insert(m_replay_reg_ids.end(), reg_ids.begin(), reg_ids.end());
+        m_entries.push_back(
+                {&reg_replayer,
+                 match_start_state,
+                 match_start_pos,
+                 reg_ids_offset,
+                 static_cast<uint32_t>(reg_ids.size()),
+                 {},
+                 cNoWrappedValue}
+        );
+        return static_cast<uint32_t>(m_entries.size() - 1);
+    }
+
+    /**
+     * Adds an entry for a token without registers, e.g., one whose value wraps around the end of
+     * the buffer, so that its value can be copied once for all the copies of the token.
+     * @return The index of the entry.
+     */
+    auto add_empty() -> uint32_t {
+        m_entries.push_back({nullptr, 0, 0, 0, 0, {}, cNoWrappedValue});
+        return static_cast<uint32_t>(m_entries.size() - 1);
+    }
+
+    /**
+     * @param entry_idx
+     * @param buffer The token's circular buffer.
+     * @param buffer_size
+     * @param end_pos The end of the token, which a replay stops at.
+     * @return The registers of the entry's token, replaying them first if they haven't been yet.
+     * @throw std::out_of_range if there is no such entry.
+     */
+    [[nodiscard]] auto get_registers(
+            uint32_t const entry_idx,
+            char const* const buffer,
+            uint32_t const buffer_size,
+            uint32_t const end_pos
+    ) -> finite_automata::RegisterSnapshot {
+        auto& entry{m_entries.at(entry_idx)};
+        if (nullptr != entry.m_reg_replayer) {
+            entry.m_reg_snapshot = entry.m_reg_replayer->replay(
+                    entry.m_match_start_state,
+                    buffer,
+                    buffer_size,
+                    entry.m_match_start_pos,
+                    end_pos,
+                    std::span{m_replay_reg_ids}.subspan(
+                            entry.m_replay_reg_ids_offset,
+                            entry.m_num_replay_reg_ids
+                    ),
+                    m_reg_snapshots
+            );
+            entry.m_reg_replayer = nullptr;
+        }
+        return entry.m_reg_snapshot;
+    }
+
+    /**
+     * @param entry_idx
+     * @param buffer The token's circular buffer.
+     * @param buffer_size
+     * @param start_pos
+     * @param end_pos
+     * @return A contiguous view of the entry's token value, which wraps around the end of the
+     * buffer, copying it first unless it has been copied for the same token before. The view is
+     * valid until the storage is cleared.
+     * @throw std::out_of_range if there is no such entry.
+     */
+    [[nodiscard]] auto get_wrapped_value(
+            uint32_t const entry_idx,
+            char const* const buffer,
+            uint32_t const buffer_size,
+            uint32_t const start_pos,
+            uint32_t const end_pos
+    ) -> std::string_view {
+        auto& entry{m_entries.at(entry_idx)};
+        // A parser may shift the bounds of a copy of the token, which then needs its own copy
+        if (cNoWrappedValue != entry.m_wrapped_value_idx) {
+            auto const& wrapped_value{m_wrapped_values[entry.m_wrapped_value_idx]};
+            if (start_pos == wrapped_value.m_start_pos && end_pos == wrapped_value.m_end_pos) {
+                return wrapped_value.m_value;
+            }
+        }
+        entry.m_wrapped_value_idx = static_cast<uint32_t>(m_wrapped_values.size());
+        auto& wrapped_value{m_wrapped_values.emplace_back(
+                std::string{buffer + start_pos, buffer + buffer_size},
+                start_pos,
+                end_pos
+        )};
+        wrapped_value.m_value.append(buffer, buffer + end_pos);
+        return wrapped_value.m_value;
+    }
+
+    /**
+     * Removes every entry and copied value, keeping the storage of the entries for reuse.
+     */
+    auto clear() -> void {
+        m_reg_snapshots.clear();
+        m_entries.clear();
+        m_replay_reg_ids.clear();
+        m_wrapped_values.clear();
+    }
+
+private:
+    // The value of `Entry::m_wrapped_value_idx` for an entry without a copied value
+    static constexpr uint32_t cNoWrappedValue{UINT32_MAX};
+
+    struct WrappedValue {
+        std::string m_value;
+        uint32_t m_start_pos;
+        uint32_t m_end_pos;
+    };
+
+    struct Entry {
+        // Set until the registers are replayed into `m_reg_snapshot`
+        finite_automata::RegisterReplayer* m_reg_replayer;
+        finite_automata::RuntimeDfa::state_id_t m_match_start_state;
+        uint32_t m_match_start_pos;
+        // The registers to keep once they're replayed, in `m_replay_reg_ids`
+        uint32_t m_replay_reg_ids_offset;
+        uint32_t m_num_replay_reg_ids;
+        finite_automata::RegisterSnapshot m_reg_snapshot;
+        uint32_t m_wrapped_value_idx;
+    };
+
+    finite_automata::RegisterSnapshots m_reg_snapshots;
+    std::vector<Entry> m_entries;
+    std::vector<reg_id_t> m_replay_reg_ids;
+    // A deque, so that adding a value doesn't move the ones already viewed
+    std::deque<WrappedValue> m_wrapped_values;
+};
+}  // namespace log_surgeon
+
+#endif  // LOG_SURGEON_TOKEN_SIDE_STORAGE_HPP
@@ -0,0 +1,101 @@
+#ifndef LOG_SURGEON_FINITE_AUTOMATA_BYTE_CLASS_MAP_HPP
+#define LOG_SURGEON_FINITE_AUTOMATA_BYTE_CLASS_MAP_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <log_surgeon/Constants.hpp>
+
+namespace log_surgeon::finite_automata {
+/**
+ * Partitions the byte alphabet into equivalence classes. Two bytes belong to the same class only if
+ * no automaton built on top of the map can tell them apart, so transitions can be computed and
+ * stored once per class instead of once per byte.
+ *
+ * Class IDs are assigned in the order of each class's smallest byte, which is also used as the
+ * class's representative. This keeps any per-class iteration in the same order as the equivalent
+ * per-byte iteration.
+ */
+class ByteClassMap {
+public:
+    using class_id_t = uint8_t;
+
+    /**
+     * Splits the classes such that two bytes stay in the same class only if they have the same
+     * key.
+     * @param byte_keys A key for every byte.
+     */
+    auto refine(std::array<uint32_t, cSizeOfByte> const& byte_keys) -> void;
+
+    /**
+     * Splits the classes such that no class contains bytes both inside and outside `byte_set`.
+     * @param byte_set Whether each byte is in the set.
+     */
+    auto refine(std::array<bool, cSizeOfByte> const& byte_set) -> void {
+        std::array<uint32_t, cSizeOfByte> byte_keys{};
+        for (uint32_t byte{0}; byte < cSizeOfByte; ++byte) {
+            byte_keys[byte] = byte_set[byte] ? 1 : 0;
+        }
+        refine(byte_keys);
+    }
+
+    [[nodiscard]] auto get_class_id(uint8_t const byte) const -> class_id_t {
+        return m_byte_to_class_id[byte];
+    }
+
+    [[nodiscard]] auto get_byte_to_class_id() const
+            -> std::array<class_id_t, cSizeOfByte> const& {
+        return m_byte_to_class_id;
+    }
+
+    [[nodiscard]] auto get_num_classes() const -> uint32_t { return m_representatives.size(); }
+
+    /**
+     * @param first
+     * @param last
+     * @return The half-open range of IDs of the classes whose smallest byte is in [first, last].
+     */
+    [[nodiscard]] auto get_class_ids_starting_in(uint8_t const first, uint8_t const last) const
+            -> std::pair<uint32_t, uint32_t> {
+        auto const begin{
+                std::lower_bound(m_representatives.cbegin(), m_representatives.cend(), first)
+        };
+        auto const end{std::upper_bound(begin, m_representatives.cend(), last)};
+        return {static_cast<uint32_t>(begin - m_representatives.cbegin()),
+                static_cast<uint32_t>(end - m_representatives.cbegin())};
+    }
+
+    /**
+     * @param class_id
+     * @return The smallest byte in the class.
+     */
+    [[nodiscard]] auto get_representative(class_id_t const class_id) const -> uint8_t {
+        return m_representatives[class_id];
+    }
+
+private:
+    std::array<class_id_t, cSizeOfByte> m_byte_to_class_id{};
+    std::vector<uint8_t> m_representatives{0};
+};
+
+inline auto ByteClassMap::refine(std::array<uint32_t, cSizeOfByte> const& byte_keys) -> void {
+    std::map<std::pair<class_id_t, uint32_t>, class_id_t> new_class_ids;
+    m_representatives.clear();
+    for (uint32_t byte{0}; byte < cSizeOfByte; ++byte) {
+        auto const [it, inserted]{new_class_ids.try_emplace(
+                {m_byte_to_class_id[byte], byte_keys[byte]},
+                static_cast<class_id_t>(new_class_ids.size())
+        )};
+        if (inserted) {
+            m_representatives.push_back(static_cast<uint8_t>(byte));
+        }
+        m_byte_to_class_id[byte] = it->second;
+    }
+}
+}  // namespace log_surgeon::finite_automata
+
+#endif  // LOG_SURGEON_FINITE_AUTOMATA_BYTE_CLASS_MAP_HPP
@@ -1,7 +1,8 @@
 #ifndef LOG_SURGEON_FINITE_AUTOMATA_DETERMINIZATION_CONFIGURATION_HPP
 #define LOG_SURGEON_FINITE_AUTOMATA_DETERMINIZATION_CONFIGURATION_HPP
 
-#include <map>
+#include <cstddef>
+#include <functional>
 #include <optional>
 #include <set>
 #include <stack>
@@ -18,7 +19,7 @@ namespace log_surgeon::finite_automata {
  *
  * A configuration captures a snapshot of the NFA's execution, including:
  * - the current NFA state,
- * - a mapping from tag IDs to register IDs,
+ * - the register of each tag,
  * - the history of tag operations,
  * - and the lookahead for upcoming tag operations.
  *
@@ -37,19 +38,27 @@ namespace log_surgeon::finite_automata {
 template <typename TypedNfaState>
 class DeterminizationConfiguration {
 public:
+    /**
+     * @param nfa_state
+     * @param reg_ids The register of each tag, indexed by tag ID.
+     * @param tag_history
+     * @param tag_lookahead
+     * @throw std::invalid_argument if `nfa_state` is null.
+     */
     DeterminizationConfiguration(
             TypedNfaState const* nfa_state,
-            std::map<tag_id_t, reg_id_t> tag_id_to_reg_ids,
+            std::vector<reg_id_t> reg_ids,
             std::vector<TagOperation> tag_history,
             std::vector<TagOperation> tag_lookahead
     )
             : m_nfa_state{nfa_state},
-              m_tag_id_to_reg_ids{std::move(tag_id_to_reg_ids)},
+              m_reg_ids{std::move(reg_ids)},
               m_history{std::move(tag_history)},
               m_lookahead{std::move(tag_lookahead)} {
         if (nullptr == m_nfa_state) {
             throw std::invalid_argument("Determinization config cannot have a null NFA state.");
         }
+        update_hashes();
     }
 
     /**
@@ -58,7 +67,7 @@ public:
      * This operator is used to insert configurations into ordered containers such as `std::set`
      * or `std::map`. The comparison considers:
      * 1. The NFA state ID.
-     * 2. The mapping of tag IDs to register IDs.
+     * 2. The register of each tag.
      * 3. The history of tag operations.
      * 4. The lookahead for upcoming tag operations.
      *
@@ -72,8 +81,8 @@ public:
         if (m_nfa_state->get_id() != rhs.m_nfa_state->get_id()) {
             return m_nfa_state->get_id() < rhs.m_nfa_state->get_id();
         }
-        if (m_tag_id_to_reg_ids != rhs.m_tag_id_to_reg_ids) {
-            return m_tag_id_to_reg_ids < rhs.m_tag_id_to_reg_ids;
+        if (m_reg_ids != rhs.m_reg_ids) {
+            return m_reg_ids < rhs.m_reg_ids;
         }
         if (m_history != rhs.m_history) {
             return m_history < rhs.m_history;
@@ -81,37 +90,47 @@ public:
         return m_lookahead < rhs.m_lookahead;
     }
 
-    auto child_configuration_with_new_state(TypedNfaState const* new_nfa_state) const
-            -> DeterminizationConfiguration {
-        return DeterminizationConfiguration(
-                new_nfa_state,
-                m_tag_id_to_reg_ids,
-                m_history,
-                m_lookahead
-        );
+    auto operator==(DeterminizationConfiguration const& rhs) const -> bool {
+        return m_hash == rhs.m_hash && m_nfa_state == rhs.m_nfa_state && m_reg_ids == rhs.m_reg_ids
+               && m_history == rhs.m_history && m_lookahead == rhs.m_lookahead;
+    }
+
+    /**
+     * @return A hash of the configuration that is equal for equal configurations.
+     */
+    [[nodiscard]] auto hash() const -> size_t { return m_hash; }
+
+    /**
+     * @return A hash of the NFA state and the lookahead only, which is equal for configurations
+     * that only differ in their registers.
+     */
+    [[nodiscard]] auto hash_state_and_lookahead() const -> size_t {
+        return m_state_and_lookahead_hash;
     }
 
     /**
      * Creates a new configuration from the current configuration by replacing the NFA state and
-     * appending a future tag operation.
+     * appending future tag operations.
      *
      * This is used during determinization to create configurations during the closure.
      *
      * @param new_nfa_state The NFA state to use in the new configuration.
-     * @param tag_op The tag operation to append to the lookahead.
+     * @param tag_ops The tag operations to append to the lookahead.
      * @return A new `DeterminizationConfiguration` with the updated state and lookahead.
      */
-    [[nodiscard]] auto child_configuration_with_new_state_and_tag(
+    [[nodiscard]] auto child_configuration_with_new_state_and_tags(
             TypedNfaState const* new_nfa_state,
-            TagOperation const& tag_op
+            std::vector<TagOperation> const& tag_ops
     ) const -> DeterminizationConfiguration {
-        auto lookahead{m_lookahead};
-        lookahead.push_back(tag_op);
+        std::vector<TagOperation> lookahead;
+        lookahead.reserve(m_lookahead.size() + tag_ops.size());
+        lookahead.insert(lookahead.end(), m_lookahead.begin(), m_lookahead.end());
+        lookahead.insert(lookahead.end(), tag_ops.begin(), tag_ops.end());
         return DeterminizationConfiguration(
                 new_nfa_state,
-                m_tag_id_to_reg_ids,
+                m_reg_ids,
                 m_history,
-                lookahead
+                std::move(lookahead)
         );
     }
 
@@ -122,14 +141,18 @@ public:
     [[nodiscard]] auto spontaneous_closure() const -> std::set<DeterminizationConfiguration>;
 
     auto set_reg_id(tag_id_t const tag_id, reg_id_t const reg_id) -> void {
-        m_tag_id_to_reg_ids.insert_or_assign(tag_id, reg_id);
+        if (m_reg_ids[tag_id] != reg_id) {
+            m_reg_ids[tag_id] = reg_id;
+            update_hashes();
+        }
     }
 
     [[nodiscard]] auto get_state() const -> TypedNfaState const* { return m_nfa_state; }
 
-    [[nodiscard]] auto get_tag_id_to_reg_ids() const -> std::map<tag_id_t, reg_id_t> {
-        return m_tag_id_to_reg_ids;
-    }
+    /**
+     * @return The register of each tag, indexed by tag ID.
+     */
+    [[nodiscard]] auto get_reg_ids() const -> std::vector<reg_id_t> const& { return m_reg_ids; }
 
     [[nodiscard]] auto get_tag_history(tag_id_t const tag_id) const -> std::optional<TagOperation> {
         for (auto const tag_op : m_history) {
@@ -140,7 +163,9 @@ public:
         return std::nullopt;
     }
 
-    [[nodiscard]] auto get_lookahead() const -> std::vector<TagOperation> { return m_lookahead; }
+    [[nodiscard]] auto get_lookahead() const -> std::vector<TagOperation> const& {
+        return m_lookahead;
+    }
 
     [[nodiscard]] auto get_tag_lookahead(tag_id_t const tag_id) const
             -> std::optional<TagOperation> {
@@ -153,6 +178,37 @@ public:
     }
 
 private:
+    /**
+     * @param seed
+     * @param value
+     * @return `seed` updated to also depend on `value`.
+     */
+    [[nodiscard]] static auto combine_hash(size_t const seed, size_t const value) -> size_t {
+        constexpr size_t cGoldenRatio{0x9e37'79b9'7f4a'7c15};
+        return seed ^ (value + cGoldenRatio + (seed << 6U) + (seed >> 2U));
+    }
+
+    /**
+     * Recomputes the hashes, which are kept up to date since the configuration is hashed far more
+     * often than it's modified.
+     */
+    auto update_hashes() -> void {
+        auto seed{std::hash<TypedNfaState const*>{}(m_nfa_state)};
+        for (auto const tag_op : m_lookahead) {
+            seed = combine_hash(seed, tag_op.get_tag_id());
+            seed = combine_hash(seed, static_cast<size_t>(tag_op.get_type()));
+        }
+        m_state_and_lookahead_hash = seed;
+        for (auto const reg_id : m_reg_ids) {
+            seed = combine_hash(seed, reg_id);
+        }
+        for (auto const tag_op : m_history) {
+            seed = combine_hash(seed, tag_op.get_tag_id());
+            seed = combine_hash(seed, static_cast<size_t>(tag_op.get_type()));
+        }
+        m_hash = seed;
+    }
+
     /**
      * @param unexplored_stack Returns the stack of configurations updated to contain configurations
      * reachable from this configuration via a single spontaneous transition.
@@ -161,9 +217,12 @@ private:
             -> void;
 
     TypedNfaState const* m_nfa_state;
-    std::map<tag_id_t, reg_id_t> m_tag_id_to_reg_ids;
+    // Every configuration has a register for every tag, so the registers are indexed by tag ID
+    std::vector<reg_id_t> m_reg_ids;
     std::vector<TagOperation> m_history;
     std::vector<TagOperation> m_lookahead;
+    size_t m_hash{0};
+    size_t m_state_and_lookahead_hash{0};
 };
 
 template <typename TypedNfaState>
@@ -171,16 +230,10 @@ auto DeterminizationConfiguration<TypedNfaState>::update_reachable_configs(
         std::stack<DeterminizationConfiguration>& unexplored_stack
 ) const -> void {
     for (auto const& nfa_spontaneous_transition : m_nfa_state->get_spontaneous_transitions()) {
-        auto child_config{this->child_configuration_with_new_state(
-                nfa_spontaneous_transition.get_dest_state()
-        )};
-        for (auto const tag_op : nfa_spontaneous_transition.get_tag_ops()) {
-            child_config = child_config.child_configuration_with_new_state_and_tag(
-                    nfa_spontaneous_transition.get_dest_state(),
-                    tag_op
-            );
-        }
-        unexplored_stack.push(child_config);
+        unexplored_stack.push(child_configuration_with_new_state_and_tags(
+                nfa_spontaneous_transition.get_dest_state(),
+                nfa_spontaneous_transition.get_tag_ops()
+        ));
     }
 }
 
@@ -191,11 +244,11 @@ auto DeterminizationConfiguration<TypedNfaState>::spontaneous_closure() const
     std::stack<DeterminizationConfiguration> unexplored_stack;
     unexplored_stack.push(*this);
     while (false == unexplored_stack.empty()) {
-        auto current_configuration = unexplored_stack.top();
+        auto current_configuration{std::move(unexplored_stack.top())};
         unexplored_stack.pop();
-        if (false == reachable_set.contains(current_configuration)) {
-            current_configuration.update_reachable_configs(unexplored_stack);
-            reachable_set.insert(current_configuration);
+        if (auto const [it, is_new]{reachable_set.insert(std::move(current_configuration))}; is_new)
+        {
+            it->update_reachable_configs(unexplored_stack);
         }
     }
     return reachable_set;
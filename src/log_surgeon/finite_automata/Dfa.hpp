@@ -2,26 +2,36 @@
 #define LOG_SURGEON_FINITE_AUTOMATA_DFA_HPP
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <exception>
+#include <limits>
 #include <map>
 #include <memory>
+#include <numeric>
 #include <optional>
 #include <queue>
 #include <set>
+#include <span>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include <log_surgeon/BinarySerialization.hpp>
 #include <log_surgeon/Constants.hpp>
+#include <log_surgeon/finite_automata/ByteClassMap.hpp>
 #include <log_surgeon/finite_automata/DeterminizationConfiguration.hpp>
 #include <log_surgeon/finite_automata/DfaStatePair.hpp>
 #include <log_surgeon/finite_automata/Nfa.hpp>
 #include <log_surgeon/finite_automata/RegisterHandler.hpp>
 #include <log_surgeon/finite_automata/RegisterOperation.hpp>
+#include <log_surgeon/finite_automata/StatePartition.hpp>
 #include <log_surgeon/finite_automata/TagOperation.hpp>
 #include <log_surgeon/Token.hpp>
 
@@ -29,6 +39,31 @@
 #include <fmt/format.h>
 
 namespace log_surgeon::finite_automata {
+/**
+ * The size of a DFA.
+ */
+struct DfaStats {
+    uint32_t m_num_states{0};
+    // The bytes used by the states and their transitions (see `DfaState::get_num_bytes`)
+    size_t m_num_bytes{0};
+    uint32_t m_num_regs{0};
+    // The register operations of all transitions and accepting states
+    uint32_t m_num_reg_ops{0};
+};
+
+struct DfaMinimizationStats {
+    DfaStats m_before;
+    DfaStats m_after;
+};
+
+/**
+ * Thrown when determinization needs more DFA states than it's allowed to create.
+ */
+class DfaStateLimitExceeded : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
 /**
  * Represents a Deterministic Finite Automaton (DFA).
  *
@@ -72,17 +107,36 @@ template <typename TypedDfaState, typename TypedNfaState>
 class Dfa {
 public:
     using ConfigurationSet = std::set<DeterminizationConfiguration<TypedNfaState>>;
+    using TransitionMap = std::map<
+            ByteClassMap::class_id_t,
+            std::pair<std::vector<RegisterOperation>, ConfigurationSet>>;
 
-    explicit Dfa(Nfa<TypedNfaState> const& nfa);
+    /**
+     * @param nfa The NFA to determinize.
+     * @param is_delimiter Whether each byte is a delimiter. Delimiters are kept in byte classes of
+     * their own, so that the lexer can tell them apart by class.
+     * @param max_num_states The maximum number of states determinization may create.
+     * @param num_threads The number of threads that determinize the states. The DFA is the same
+     * for any number of threads.
+     * @throw DfaStateLimitExceeded if determinization needs more than `max_num_states` states.
+     */
+    explicit Dfa(
+            Nfa<TypedNfaState> const& nfa,
+            std::array<bool, cSizeOfByte> const& is_delimiter = {},
+            size_t max_num_states = std::numeric_limits<size_t>::max(),
+            size_t num_threads = 1
+    );
 
     /**
      * Updates the register handler using the register operations.
-     * @param reg_ops The vector of register operations to apply.
+     * @param reg_ops The register operations to apply.
      * @param curr_pos The current position in the lexing.
-     * @throws `std::logic_error` if copy operation has no source register.
-     * @throws `std::logic_error` if register operation has unhandlded type.
+     * @throws Forwards `RegisterHandler::process_reg_ops`'s exceptions.
      */
-    auto process_reg_ops(std::vector<RegisterOperation> const& reg_ops, uint32_t curr_pos) -> void;
+    auto process_reg_ops(std::span<RegisterOperation const> const reg_ops, uint32_t const curr_pos)
+            -> void {
+        m_reg_handler.process_reg_ops(reg_ops, curr_pos);
+    }
 
     /**
      * @return A string representation of the DFA.
@@ -90,8 +144,71 @@ public:
      */
     [[nodiscard]] auto serialize() const -> std::optional<std::string>;
 
+    /**
+     * Writes the byte classes, register kinds, states, transitions, register operations, and final
+     * registers of the DFA in a binary form, which `load_binary` reads back without any
+     * determinization.
+     * @param writer
+     */
+    auto serialize_binary(BinaryWriter& writer) const -> void;
+
+    /**
+     * @param reader
+     * @return The DFA written by `serialize_binary`, with no minimization stats.
+     * @throw std::runtime_error if the binary data is truncated or describes an invalid DFA.
+     */
+    [[nodiscard]] static auto load_binary(BinaryReader& reader) -> std::unique_ptr<Dfa>;
+
     [[nodiscard]] auto get_root() const -> TypedDfaState const* { return m_states.at(0).get(); }
 
+    [[nodiscard]] auto get_byte_class_map() const -> ByteClassMap const& {
+        return *m_byte_class_map;
+    }
+
+    /**
+     * Merges the states that no input can tell apart, using Hopcroft's partition refinement.
+     *
+     * Since register operations are executed as the DFA runs, they are part of a state's identity:
+     * two states are only merged if they match the same variables with the same accepting
+     * operations, and if, for every byte class, both have no transition or both transition to
+     * merged states with the same register operations. The root remains the first state.
+     * @return The state count and memory usage before and after minimization.
+     */
+    auto minimize() -> DfaMinimizationStats;
+
+    /**
+     * Reduces the register operations executed while lexing and the number of registers, in the
+     * style of the register optimizations for TDFAs described by Trafimovich:
+     * - Liveness analysis finds the registers whose values may still be read at each state. A
+     *   token of a variable only reads the final registers of the variable's tags, so accepting
+     *   operations writing other final registers are dead. Since the lexer only executes a
+     *   state's accepting operations if the match may end there, they're treated as optional.
+     *   The lexer only reads the final registers once the DFA dies, so those read at an accepting
+     *   state stay live in every state reachable from it.
+     * - Operations whose results are never read are removed.
+     * - Registers connected by a copy are coalesced unless their values may differ while both are
+     *   live (i.e., they interfere), removing the copy.
+     * - The remaining registers are greedily colored, letting registers that never interfere
+     *   share an ID. The final register of tag `i` becomes register `i`.
+     *
+     * Registers are assumed to be empty when a match starts.
+     * @param variable_id_to_tag_ids The tags read when a token of each variable is matched.
+     * Variables without an entry are assumed to read no tags.
+     */
+    auto optimize_registers(
+            std::unordered_map<uint32_t, std::vector<tag_id_t>> const& variable_id_to_tag_ids
+    ) -> void;
+
+    [[nodiscard]] auto get_stats() const -> DfaStats;
+
+    /**
+     * @return The stats returned by `minimize`, or std::nullopt if the DFA wasn't minimized.
+     */
+    [[nodiscard]] auto get_minimization_stats() const
+            -> std::optional<DfaMinimizationStats> const& {
+        return m_minimization_stats;
+    }
+
     /**
      * Compares this DFA with `dfa_in` to determine the set of schema types in this DFA that are
      * reachable by any type in `dfa_in`. A type is considered reachable if there is at least one
@@ -107,35 +224,143 @@ public:
         return m_tag_id_to_final_reg_id;
     }
 
+    [[nodiscard]] auto get_num_regs() const -> size_t { return m_num_regs; }
+
+    /**
+     * @return Whether each register, indexed by ID, is multi-valued (see `RegisterHandler`).
+     */
+    [[nodiscard]] auto get_multi_valued_regs() const -> std::vector<bool> const& {
+        return m_multi_valued_regs;
+    }
+
     [[nodiscard]] auto release_reg_handler() -> RegisterHandler {
         auto out{std::move(m_reg_handler)};
-        m_reg_handler = RegisterHandler();
-        m_reg_handler.add_registers(m_num_regs);
+        reset_registers();
         return out;
     }
 
+    /**
+     * Resets the registers in place. This is a cheaper alternative to `release_reg_handler` when
+     * the register values are no longer needed.
+     */
+    auto reset_reg_handler() -> void { m_reg_handler.reset(); }
+
+    /**
+     * @return A vector representing the traversal order of the DFA states using breadth-first
+     * search (BFS).
+     */
+    [[nodiscard]] auto get_bfs_traversal_order() const -> std::vector<TypedDfaState const*>;
+
+    /**
+     * Partitions the bytes into classes such that bytes in the same class have the same
+     * transitions out of every NFA state and agree on whether they are delimiters.
+     *
+     * @param nfa The NFA whose transitions to consider.
+     * @param is_delimiter Whether each byte is a delimiter.
+     * @return The byte class map.
+     */
+    [[nodiscard]] static auto get_byte_classes(
+            Nfa<TypedNfaState> const& nfa,
+            std::array<bool, cSizeOfByte> const& is_delimiter
+    ) -> ByteClassMap;
+
 private:
+    static constexpr uint32_t cNoTransition{std::numeric_limits<uint32_t>::max()};
+    // The registers a thread allocates while determinizing a state are numbered from here, above
+    // any register the DFA can have, until the state's actual registers are known
+    static constexpr reg_id_t cFirstSpeculativeRegId{1U << 31U};
+
+    struct ConfigurationSetHash {
+        auto operator()(ConfigurationSet const& config_set) const -> size_t {
+            auto seed{config_set.size()};
+            for (auto const& config : config_set) {
+                seed = seed * 31 + config.hash();
+            }
+            return seed;
+        }
+    };
+
+    using DfaStateMap = std::unordered_map<ConfigurationSet, TypedDfaState*, ConfigurationSetHash>;
+
+    Dfa() = default;
+
+    // Groups the config sets in a `DfaStateMap` by `get_register_agnostic_hash`, each group sorted
+    // in `ConfigurationSet` order
+    using MappingCandidates = std::unordered_map<
+            size_t,
+            std::vector<std::pair<ConfigurationSet const*, TypedDfaState*>>>;
+
+    /**
+     * @param config_set
+     * @return A hash of `config_set` that is equal for config sets that `try_get_mapping` can map
+     * to each other, i.e., config sets whose configs only differ in their registers.
+     */
+    [[nodiscard]] static auto get_register_agnostic_hash(ConfigurationSet const& config_set)
+            -> size_t {
+        // The configs' order depends on their registers, so their hashes are combined commutatively
+        auto hash{config_set.size()};
+        for (auto const& config : config_set) {
+            hash += config.hash_state_and_lookahead();
+        }
+        return hash;
+    }
+
     /**
      * Generates the DFA states from the given NFA using the superset determinization algorithm.
+     * Transitions are computed once per byte class, using the class's representative byte.
+     *
+     * The states are explored one BFS level at a time. With multiple threads, the transitions of
+     * all states in a level are computed in parallel, numbering the registers they allocate from
+     * `cFirstSpeculativeRegId`. The transitions are then added in BFS order on a single thread,
+     * renumbering the registers to what they would have been if the transitions had been computed
+     * in that order, so the DFA doesn't depend on the number of threads. This works because the
+     * registers in a state's config set always precede the ones allocated for its transitions, so
+     * renumbering them preserves the order of configs.
      *
      * @param nfa The NFA used to generate the DFA.
+     * @param max_num_states
+     * @param num_threads
+     * @throw DfaStateLimitExceeded if more than `max_num_states` states are needed.
      */
-    auto generate(Nfa<TypedNfaState> const& nfa) -> void;
+    auto generate(Nfa<TypedNfaState> const& nfa, size_t max_num_states, size_t num_threads)
+            -> void;
 
     /**
-     * Adds two registers for each tag:
+     * Computes the transitions of several config sets in parallel (see `get_transitions`).
+     * @param num_tags Number of tags in the NFA.
+     * @param config_sets
+     * @param num_threads
+     * @return For each config set, its transitions, with registers allocated from
+     * `cFirstSpeculativeRegId`, and the mapping from each tag with operations to its register.
+     */
+    [[nodiscard]] auto get_transitions_in_parallel(
+            size_t num_tags,
+            std::vector<ConfigurationSet> const& config_sets,
+            size_t num_threads
+    ) const -> std::vector<std::pair<TransitionMap, std::map<tag_id_t, reg_id_t>>>;
+
+    /**
+     * Renumbers the registers allocated from `cFirstSpeculativeRegId` in transitions.
+     * @param first_new_reg_id The new ID of register `cFirstSpeculativeRegId`.
+     * @param transitions Returns the renumbered transitions.
+     */
+    static auto renumber_speculative_regs(reg_id_t first_new_reg_id, TransitionMap& transitions)
+            -> void;
+
+    /**
+     * Adds two registers for each tag, of the tag's kind:
      * - One to track the initial possibility of the tag's position.
      * - One to track the final selection of the tag's position.
      *
-     * @param num_tags Number of tags in the NFA.
+     * @param multi_valued_tags Whether each tag in the NFA, indexed by ID, is multi-valued.
      * @param register_handler Returns the handler with the added registers.
-     * @param tag_id_to_initial_reg_id Returns a mapping from tag ID to its initial register ID.
+     * @param initial_reg_ids Returns the initial register of each tag, indexed by tag ID.
      * @param tag_id_to_final_reg_id Returns a mapping from tag ID to its final register ID.
      */
     static auto initialize_registers(
-            size_t num_tags,
+            std::vector<bool> const& multi_valued_tags,
             RegisterHandler& register_handler,
-            std::map<tag_id_t, reg_id_t>& tag_id_to_initial_reg_id,
+            std::vector<reg_id_t>& initial_reg_ids,
             std::map<tag_id_t, reg_id_t>& tag_id_to_final_reg_id
     ) -> void;
 
@@ -156,10 +381,15 @@ private:
     /**
      * Creates a DFA state based on the given config set if the config does not already exist and
      * cannot be mapped to an existing config. In the case of a new DFA state, it is added to
-     * `m_states`, `dfa_states`, and `unexplored_sets`.
+     * `m_states`, `dfa_states`, `mapping_candidates`, and `unexplored_sets`.
+     *
+     * Only the config sets with the same register-agnostic hash are tried as mappings, in
+     * `ConfigurationSet` order.
      *
      * @param config_set The configuration set for which to create or get the DFA state.
      * @param dfa_states Returns an updated map of configuration sets to DFA states.
+     * @param mapping_candidates Returns the config sets in `dfa_states` grouped by their
+     * register-agnostic hash.
      * @param unexplored_sets Returns a queue of unexplored states.
      * @return If `new_config_set` is already in `dfa_states`, a pair containing:
      * - The existing DFA state.
@@ -174,40 +404,64 @@ private:
      */
     auto create_or_get_dfa_state(
             ConfigurationSet const& config_set,
-            std::map<ConfigurationSet, TypedDfaState*>& dfa_states,
+            DfaStateMap& dfa_states,
+            MappingCandidates& mapping_candidates,
             std::queue<ConfigurationSet>& unexplored_sets
     ) -> std::pair<TypedDfaState*, std::optional<std::unordered_map<reg_id_t, reg_id_t>>>;
 
+    /**
+     * Adds the registers allocated for a state's transitions to `m_reg_handler`, each of the kind
+     * of its tag.
+     * @param multi_valued_tags Whether each tag in the NFA, indexed by ID, is multi-valued.
+     * @param first_reg_id The ID the registers were allocated from.
+     * @param tag_id_with_op_to_reg_id The mapping from each tag with operations to its register.
+     */
+    auto add_transition_registers(
+            std::vector<bool> const& multi_valued_tags,
+            reg_id_t first_reg_id,
+            std::map<tag_id_t, reg_id_t> const& tag_id_with_op_to_reg_id
+    ) -> void;
+
+    /**
+     * Replaces `m_reg_handler` with an empty handler with the registers in `m_multi_valued_regs`.
+     */
+    auto reset_registers() -> void;
+
     /**
      * Determines the out-going transitions from the configuration set based on its NFA states.
      *
      * @param num_tags Number of tags in the NFA.
      * @param config_set The configuration set.
+     * @param first_new_reg_id The ID of the first register allocated for the transitions.
      * @param tag_id_with_op_to_reg_id Returns an updated mapping from operation tag id to
-     * register id.
-     * @return A map of input symbols to transitions. Each transition contains a vector of register
+     * register id. The registers allocated are numbered consecutively from `first_new_reg_id`, and
+     * must be added to `m_reg_handler` by the caller.
+     * @return A map of byte classes to transitions. Each transition contains a vector of register
      * operations and a destination configuration set.
      */
     [[nodiscard]] auto get_transitions(
             size_t num_tags,
             ConfigurationSet const& config_set,
+            reg_id_t first_new_reg_id,
             std::map<tag_id_t, reg_id_t>& tag_id_with_op_to_reg_id
-    ) -> std::map<uint32_t, std::pair<std::vector<RegisterOperation>, ConfigurationSet>>;
+    ) const -> TransitionMap;
 
     /**
      * Iterates over the configurations in the closure to:
-     * - Add the new registers needed to track the tags to 'm_reg_handler'.
+     * - Allocate the new registers needed to track the tags.
      * - Determine the operations to perform on the new registers.
      *
      * @param num_tags Number of tags in the NFA.
      * @param closure Returns the set of DFA configurations with updated `tag_id_to_reg_ids`.
+     * @param first_new_reg_id The ID of the first register allocated for the transitions.
      * @param tag_id_with_op_to_reg_id Returns the updated map of tags with operations to
      * registers.
      * @returns The operations to perform on the new registers.
      */
-    auto assign_transition_reg_ops(
+    static auto assign_transition_reg_ops(
             size_t num_tags,
             ConfigurationSet& closure,
+            reg_id_t first_new_reg_id,
             std::map<tag_id_t, reg_id_t>& tag_id_with_op_to_reg_id
     ) -> std::vector<RegisterOperation>;
 
@@ -225,6 +479,52 @@ private:
             std::vector<RegisterOperation>& reg_ops
     ) -> void;
 
+    /**
+     * @return A map of the states to their indices in `m_states`.
+     */
+    [[nodiscard]] auto get_state_ids() const -> std::unordered_map<TypedDfaState const*, uint32_t>;
+
+    /**
+     * Updates the set of live registers, i.e., registers whose values may still be read, from
+     * after to before a sequence of register operations.
+     * @param reg_ops
+     * @param live_regs The registers live after `reg_ops`. Returns the registers live before them.
+     */
+    static auto update_live_regs(
+            std::vector<RegisterOperation> const& reg_ops,
+            std::vector<bool>& live_regs
+    ) -> void;
+
+    /**
+     * Same as `update_live_regs`, but also removes the operations writing registers that aren't
+     * live, and marks every register written as interfering with every other register live after
+     * the write, except for a copy's source, which holds the same value.
+     * @param reg_ops Returns with the dead operations removed.
+     * @param live_regs The registers live after `reg_ops`. Returns the registers live before them.
+     * @param interference Returns with the interfering register pairs marked.
+     */
+    static auto remove_dead_reg_ops(
+            std::vector<RegisterOperation>& reg_ops,
+            std::vector<bool>& live_regs,
+            std::vector<std::vector<bool>>& interference
+    ) -> void;
+
+    /**
+     * @param reg_ops
+     * @param writer Returns with `reg_ops` written.
+     */
+    static auto
+    serialize_reg_ops(std::vector<RegisterOperation> const& reg_ops, BinaryWriter& writer) -> void;
+
+    /**
+     * @param num_regs The number of registers of the DFA.
+     * @param reader
+     * @return The register operations written by `serialize_reg_ops`.
+     * @throw std::runtime_error if the binary data is truncated or an operation is invalid.
+     */
+    [[nodiscard]] static auto load_reg_ops(size_t num_regs, BinaryReader& reader)
+            -> std::vector<RegisterOperation>;
+
     /**
      * Creates a new DFA state based on a set of NFA configurations and adds it to `m_states`.
      *
@@ -237,101 +537,738 @@ private:
             std::map<tag_id_t, reg_id_t> const& tag_id_to_final_reg_id
     ) -> TypedDfaState*;
 
-    /**
-     * @return A vector representing the traversal order of the DFA states using breadth-first
-     * search (BFS).
-     */
-    [[nodiscard]] auto get_bfs_traversal_order() const -> std::vector<TypedDfaState const*>;
-
+    // The map is heap-allocated as the states point to it, so it must not move with the DFA.
+    std::unique_ptr<ByteClassMap> m_byte_class_map;
     std::vector<std::unique_ptr<TypedDfaState>> m_states;
     std::map<tag_id_t, reg_id_t> m_tag_id_to_final_reg_id;
     RegisterHandler m_reg_handler;
     size_t m_num_regs{0};
+    std::vector<bool> m_multi_valued_regs;
+    std::optional<DfaMinimizationStats> m_minimization_stats;
 };
 
 template <typename TypedDfaState, typename TypedNfaState>
-Dfa<TypedDfaState, TypedNfaState>::Dfa(Nfa<TypedNfaState> const& nfa) {
-    generate(nfa);
+Dfa<TypedDfaState, TypedNfaState>::Dfa(
+        Nfa<TypedNfaState> const& nfa,
+        std::array<bool, cSizeOfByte> const& is_delimiter,
+        size_t const max_num_states,
+        size_t const num_threads
+)
+        : m_byte_class_map{std::make_unique<ByteClassMap>(get_byte_classes(nfa, is_delimiter))} {
+    generate(nfa, max_num_states, num_threads);
 }
 
 template <typename TypedDfaState, typename TypedNfaState>
-auto Dfa<TypedDfaState, TypedNfaState>::process_reg_ops(
-        std::vector<RegisterOperation> const& reg_ops,
-        uint32_t const curr_pos
-) -> void {
-    for (auto const& reg_op : reg_ops) {
-        switch (reg_op.get_type()) {
-            case RegisterOperation::Type::Set: {
-                m_reg_handler.append_position(reg_op.get_reg_id(), curr_pos);
-                break;
-            }
-            case RegisterOperation::Type::Negate: {
-                m_reg_handler.append_position(reg_op.get_reg_id(), -1);
-                break;
-            }
-            case RegisterOperation::Type::Copy: {
-                auto copy_reg_id_optional{reg_op.get_copy_reg_id()};
-                if (copy_reg_id_optional.has_value()) {
-                    m_reg_handler.copy_register(reg_op.get_reg_id(), copy_reg_id_optional.value());
-                } else {
-                    throw std::logic_error("Copy operation does not specify register to copy.");
-                }
-                break;
-            }
-            default: {
-                throw std::logic_error("Unhandled register operation type when simulating DFA.");
-            }
+auto Dfa<TypedDfaState, TypedNfaState>::get_byte_classes(
+        Nfa<TypedNfaState> const& nfa,
+        std::array<bool, cSizeOfByte> const& is_delimiter
+) -> ByteClassMap {
+    ByteClassMap byte_class_map;
+    byte_class_map.refine(is_delimiter);
+    for (auto const* nfa_state : nfa.get_bfs_traversal_order()) {
+        // Bytes with the same destinations out of this state get the same key, including the bytes
+        // without any, which get key 0.
+        auto const& intervals{nfa_state->get_byte_transition_intervals()};
+        std::map<std::vector<TypedNfaState*>, uint32_t> dest_states_to_key;
+        uint32_t num_bytes_with_transitions{0};
+        for (auto const& interval : intervals) {
+            num_bytes_with_transitions += interval.m_last - interval.m_first + 1U;
+        }
+        if (num_bytes_with_transitions < cSizeOfByte) {
+            dest_states_to_key.emplace(std::vector<TypedNfaState*>{}, 0);
+        }
+        std::array<uint32_t, cSizeOfByte> byte_keys{};
+        for (auto const& [first, last, dest_states] : intervals) {
+            auto const key{dest_states_to_key.try_emplace(dest_states, dest_states_to_key.size())
+                                   .first->second};
+            std::fill(byte_keys.begin() + first, byte_keys.begin() + last + 1, key);
+        }
+        if (dest_states_to_key.size() > 1) {
+            byte_class_map.refine(byte_keys);
         }
     }
+    return byte_class_map;
 }
 
 // TODO: handle utf8 case in DFA generation.
 template <typename TypedDfaState, typename TypedNfaState>
-auto Dfa<TypedDfaState, TypedNfaState>::generate(Nfa<TypedNfaState> const& nfa) -> void {
-    std::map<tag_id_t, reg_id_t> tag_id_to_initial_reg_id;
+auto Dfa<TypedDfaState, TypedNfaState>::generate(
+        Nfa<TypedNfaState> const& nfa,
+        size_t const max_num_states,
+        size_t const num_threads
+) -> void {
+    auto const multi_valued_tags{nfa.get_multi_valued_tags()};
+    std::vector<reg_id_t> initial_reg_ids;
     initialize_registers(
-            nfa.get_num_tags(),
+            multi_valued_tags,
             m_reg_handler,
-            tag_id_to_initial_reg_id,
+            initial_reg_ids,
             m_tag_id_to_final_reg_id
     );
     DeterminizationConfiguration<TypedNfaState>
-            initial_config{nfa.get_root(), tag_id_to_initial_reg_id, {}, {}};
+            initial_config{nfa.get_root(), std::move(initial_reg_ids), {}, {}};
 
-    std::map<ConfigurationSet, TypedDfaState*> dfa_states;
+    DfaStateMap dfa_states;
+    MappingCandidates mapping_candidates;
     std::queue<ConfigurationSet> unexplored_sets;
-    create_or_get_dfa_state(initial_config.spontaneous_closure(), dfa_states, unexplored_sets);
+    create_or_get_dfa_state(
+            initial_config.spontaneous_closure(),
+            dfa_states,
+            mapping_candidates,
+            unexplored_sets
+    );
+    std::vector<ConfigurationSet> level;
+    std::vector<std::pair<TransitionMap, std::map<tag_id_t, reg_id_t>>> level_transitions;
     while (false == unexplored_sets.empty()) {
-        auto config_set{unexplored_sets.front()};
-        auto* dfa_state{dfa_states.at(config_set)};
-        unexplored_sets.pop();
-        std::map<tag_id_t, reg_id_t> tag_id_with_op_to_reg_id;
-        for (auto [ascii_value, dest_config_pair] :
-             get_transitions(nfa.get_num_tags(), config_set, tag_id_with_op_to_reg_id))
-        {
-            auto& [reg_ops, dest_config_set]{dest_config_pair};
-            auto [dest_state, optional_reg_map]{
-                    create_or_get_dfa_state(dest_config_set, dfa_states, unexplored_sets)
-            };
-            if (optional_reg_map.has_value()) {
-                reassign_transition_reg_ops(optional_reg_map.value(), reg_ops);
+        level.clear();
+        while (false == unexplored_sets.empty()) {
+            level.push_back(std::move(unexplored_sets.front()));
+            unexplored_sets.pop();
+        }
+        bool const is_parallel{num_threads > 1 && level.size() > 1};
+        if (is_parallel) {
+            level_transitions = get_transitions_in_parallel(nfa.get_num_tags(), level, num_threads);
+        }
+
+        for (size_t level_idx{0}; level_idx < level.size(); ++level_idx) {
+            auto const& config_set{level[level_idx]};
+            auto* dfa_state{dfa_states.at(config_set)};
+            auto const first_new_reg_id{static_cast<reg_id_t>(m_reg_handler.get_num_regs())};
+            TransitionMap transitions;
+            if (is_parallel) {
+                auto& [parallel_transitions, tag_id_with_op_to_reg_id]{
+                        level_transitions[level_idx]
+                };
+                if (first_new_reg_id + tag_id_with_op_to_reg_id.size() > cFirstSpeculativeRegId) {
+                    throw std::runtime_error("Determinization needs too many registers.");
+                }
+                transitions = std::move(parallel_transitions);
+                renumber_speculative_regs(first_new_reg_id, transitions);
+                add_transition_registers(
+                        multi_valued_tags,
+                        cFirstSpeculativeRegId,
+                        tag_id_with_op_to_reg_id
+                );
+            } else {
+                std::map<tag_id_t, reg_id_t> tag_id_with_op_to_reg_id;
+                transitions = get_transitions(
+                        nfa.get_num_tags(),
+                        config_set,
+                        first_new_reg_id,
+                        tag_id_with_op_to_reg_id
+                );
+                add_transition_registers(
+                        multi_valued_tags,
+                        first_new_reg_id,
+                        tag_id_with_op_to_reg_id
+                );
+            }
+            for (auto& [class_id, dest_config_pair] : transitions) {
+                auto& [reg_ops, dest_config_set]{dest_config_pair};
+                auto [dest_state, optional_reg_map]{create_or_get_dfa_state(
+                        dest_config_set,
+                        dfa_states,
+                        mapping_candidates,
+                        unexplored_sets
+                )};
+                if (m_states.size() > max_num_states) {
+                    throw DfaStateLimitExceeded(fmt::format(
+                            "Determinization needs more than the maximum of {} DFA states.",
+                            max_num_states
+                    ));
+                }
+                if (optional_reg_map.has_value()) {
+                    reassign_transition_reg_ops(optional_reg_map.value(), reg_ops);
+                }
+                dfa_state->add_class_transition(class_id, {reg_ops, dest_state});
             }
-            dfa_state->add_byte_transition(ascii_value, {reg_ops, dest_state});
         }
     }
     m_num_regs = m_reg_handler.get_num_regs();
+    m_multi_valued_regs.reserve(m_num_regs);
+    for (reg_id_t reg_id{0}; reg_id < m_num_regs; ++reg_id) {
+        m_multi_valued_regs.push_back(m_reg_handler.is_multi_valued(reg_id));
+    }
 }
 
 template <typename TypedDfaState, typename TypedNfaState>
-auto Dfa<TypedDfaState, TypedNfaState>::initialize_registers(
+auto Dfa<TypedDfaState, TypedNfaState>::get_transitions_in_parallel(
         size_t const num_tags,
+        std::vector<ConfigurationSet> const& config_sets,
+        size_t const num_threads
+) const -> std::vector<std::pair<TransitionMap, std::map<tag_id_t, reg_id_t>>> {
+    std::vector<std::pair<TransitionMap, std::map<tag_id_t, reg_id_t>>> transitions(
+            config_sets.size()
+    );
+    auto const num_workers{std::min(num_threads, config_sets.size())};
+    std::vector<std::exception_ptr> exceptions(num_workers);
+    std::atomic<size_t> next_idx{0};
+    auto const compute_transitions{[&](size_t const worker_idx) -> void {
+        try {
+            for (auto idx{next_idx++}; idx < config_sets.size(); idx = next_idx++) {
+                auto& [idx_transitions, tag_id_with_op_to_reg_id]{transitions[idx]};
+                idx_transitions = get_transitions(
+                        num_tags,
+                        config_sets[idx],
+                        cFirstSpeculativeRegId,
+                        tag_id_with_op_to_reg_id
+                );
+            }
+        } catch (...) {
+            exceptions[worker_idx] = std::current_exception();
+        }
+    }};
+    {
+        // The threads are joined when they go out of scope
+        std::vector<std::jthread> threads;
+        threads.reserve(num_workers - 1);
+        for (size_t worker_idx{1}; worker_idx < num_workers; ++worker_idx) {
+            threads.emplace_back(compute_transitions, worker_idx);
+        }
+        compute_transitions(0);
+    }
+    for (auto const& exception : exceptions) {
+        if (nullptr != exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+    return transitions;
+}
+
+template <typename TypedDfaState, typename TypedNfaState>
+auto Dfa<TypedDfaState, TypedNfaState>::renumber_speculative_regs(
+        reg_id_t const first_new_reg_id,
+        TransitionMap& transitions
+) -> void {
+    auto const renumber{[&](reg_id_t const reg_id) -> reg_id_t {
+        return reg_id < cFirstSpeculativeRegId ? reg_id
+                                               : reg_id - cFirstSpeculativeRegId + first_new_reg_id;
+    }};
+    for (auto& [class_id, transition] : transitions) {
+        auto& [reg_ops, config_set]{transition};
+        for (auto& reg_op : reg_ops) {
+            reg_op.set_reg_id(renumber(reg_op.get_reg_id()));
+        }
+        // Renumbering preserves the order of the configs, so they're appended in order
+        ConfigurationSet renumbered_config_set;
+        for (auto config : config_set) {
+            auto const num_tags{static_cast<tag_id_t>(config.get_reg_ids().size())};
+            for (tag_id_t tag_id{0}; tag_id < num_tags; ++tag_id) {
+                config.set_reg_id(tag_id, renumber(config.get_reg_ids()[tag_id]));
+            }
+            renumbered_config_set.emplace_hint(renumbered_config_set.end(), std::move(config));
+        }
+        config_set = std::move(renumbered_config_set);
+    }
+}
+
+template <typename TypedDfaState, typename TypedNfaState>
+auto Dfa<TypedDfaState, TypedNfaState>::minimize() -> DfaMinimizationStats {
+    auto const stats_before{get_stats()};
+    auto const num_states{static_cast<uint32_t>(m_states.size())};
+    auto const state_ids{get_state_ids()};
+
+    // The label of a transition is its byte class together with its register operations. For
+    // each state, collect the (label, source state) pair of every transition into it.
+    std::map<std::pair<ByteClassMap::class_id_t, std::vector<RegisterOperation>>, uint32_t>
+            label_ids;
+    std::vector<std::vector<std::pair<uint32_t, uint32_t>>> incoming_transitions(num_states);
+    for (uint32_t state_id{0}; state_id < num_states; ++state_id) {
+        auto const& transitions{m_states[state_id]->get_class_transitions()};
+        for (uint32_t class_idx{0}; class_idx < transitions.size(); ++class_idx) {
+            auto const& optional_transition{transitions[class_idx]};
+            if (false == optional_transition.has_value()) {
+                continue;
+            }
+            auto const label_id{
+                    label_ids
+                            .try_emplace(
+                                    {static_cast<ByteClassMap::class_id_t>(class_idx),
+                                     optional_transition->get_reg_ops()},
+                                    label_ids.size()
+                            )
+                            .first->second
+            };
+            incoming_transitions[state_ids.at(optional_transition->get_dest_state())]
+                    .emplace_back(label_id, state_id);
+        }
+    }
+
+    std::map<std::pair<std::vector<uint32_t>, std::vector<RegisterOperation>>, uint32_t>
+            initial_block_ids;
+    std::vector<uint32_t> state_id_to_initial_block_id(num_states);
+    for (uint32_t state_id{0}; state_id < num_states; ++state_id) {
+        auto const& state{m_states[state_id]};
+        state_id_to_initial_block_id[state_id]
+                = initial_block_ids
+                          .try_emplace(
+                                  {state->get_matching_variable_ids(),
+                                   state->get_accepting_reg_ops()},
+                                  initial_block_ids.size()
+                          )
+                          .first->second;
+    }
+    StatePartition partition{
+            state_id_to_initial_block_id,
+            static_cast<uint32_t>(initial_block_ids.size())
+    };
+
+    // As states may lack transitions, every initial block must be used as a splitter. After that,
+    // when a block that isn't waiting is split, splitting by the smaller half is enough.
+    std::vector<uint32_t> splitters(partition.get_num_blocks());
+    std::iota(splitters.begin(), splitters.end(), 0);
+    std::vector<bool> is_splitter(partition.get_num_blocks(), true);
+    std::vector<std::pair<uint32_t, uint32_t>> splitter_transitions;
+    while (false == splitters.empty()) {
+        auto const splitter{splitters.back()};
+        splitters.pop_back();
+        is_splitter[splitter] = false;
+
+        splitter_transitions.clear();
+        auto const [block_begin, block_end]{partition.get_block(splitter)};
+        for (auto const* it{block_begin}; block_end != it; ++it) {
+            auto const& transitions{incoming_transitions[*it]};
+            splitter_transitions.insert(
+                    splitter_transitions.end(),
+                    transitions.cbegin(),
+                    transitions.cend()
+            );
+        }
+        std::sort(splitter_transitions.begin(), splitter_transitions.end());
+
+        auto it{splitter_transitions.cbegin()};
+        while (splitter_transitions.cend() != it) {
+            auto const label_id{it->first};
+            for (; splitter_transitions.cend() != it && label_id == it->first; ++it) {
+                partition.mark(it->second);
+            }
+            for (auto const& [block_id, new_block_id] : partition.split()) {
+                is_splitter.push_back(false);
+                if (is_splitter[block_id]
+                    || partition.get_block_size(new_block_id)
+                               <= partition.get_block_size(block_id))
+                {
+                    splitters.push_back(new_block_id);
+                    is_splitter[new_block_id] = true;
+                } else {
+                    splitters.push_back(block_id);
+                    is_splitter[block_id] = true;
+                }
+            }
+        }
+    }
+
+    // Create a state per block, in the order of the blocks' first states, so the root stays first
+    std::vector<std::unique_ptr<TypedDfaState>> minimized_states;
+    std::vector<TypedDfaState*> block_id_to_state(partition.get_num_blocks(), nullptr);
+    std::vector<uint32_t> representative_state_ids;
+    for (uint32_t state_id{0}; state_id < num_states; ++state_id) {
+        auto& minimized_state{block_id_to_state[partition.get_block_id(state_id)]};
+        if (nullptr != minimized_state) {
+            continue;
+        }
+        minimized_states.emplace_back(std::make_unique<TypedDfaState>(*m_byte_class_map));
+        minimized_state = minimized_states.back().get();
+        representative_state_ids.push_back(state_id);
+    }
+    for (uint32_t idx{0}; idx < minimized_states.size(); ++idx) {
+        auto const& state{m_states[representative_state_ids[idx]]};
+        auto& minimized_state{minimized_states[idx]};
+        for (auto const variable_id : state->get_matching_variable_ids()) {
+            minimized_state->add_matching_variable_id(variable_id);
+        }
+        for (auto const& accepting_op : state->get_accepting_reg_ops()) {
+            minimized_state->add_accepting_op(accepting_op);
+        }
+        auto const& transitions{state->get_class_transitions()};
+        for (uint32_t class_idx{0}; class_idx < transitions.size(); ++class_idx) {
+            auto const& optional_transition{transitions[class_idx]};
+            if (false == optional_transition.has_value()) {
+                continue;
+            }
+            auto const dest_state_id{state_ids.at(optional_transition->get_dest_state())};
+            minimized_state->add_class_transition(
+                    static_cast<ByteClassMap::class_id_t>(class_idx),
+                    {optional_transition->get_reg_ops(),
+                     block_id_to_state[partition.get_block_id(dest_state_id)]}
+            );
+        }
+    }
+    m_states = std::move(minimized_states);
+
+    m_minimization_stats = DfaMinimizationStats{stats_before, get_stats()};
+    return m_minimization_stats.value();
+}
+
+template <typename TypedDfaState, typename TypedNfaState>
+auto Dfa<TypedDfaState, TypedNfaState>::optimize_registers(
+        std::unordered_map<uint32_t, std::vector<tag_id_t>> const& variable_id_to_tag_ids
+) -> void {
+    auto const num_states{static_cast<uint32_t>(m_states.size())};
+    auto const num_regs{static_cast<reg_id_t>(m_num_regs)};
+    auto const state_ids{get_state_ids()};
+
+    std::vector<std::vector<bool>> observed_regs(num_states, std::vector<bool>(num_regs, false));
+    for (uint32_t state_id{0}; state_id < num_states; ++state_id) {
+        for (auto const variable_id : m_states[state_id]->get_matching_variable_ids()) {
+            auto const it{variable_id_to_tag_ids.find(variable_id)};
+            if (variable_id_to_tag_ids.end() == it) {
+                continue;
+            }
+            for (auto const tag_id : it->second) {
+                observed_regs[state_id][m_tag_id_to_final_reg_id.at(tag_id)] = true;
+            }
+        }
+    }
+
+    // The lexer keeps simulating the DFA past an accepting state, looking for a longer match, and
+    // only reads the final registers once the DFA dies. So the registers observed at an accepting
+    // state stay live in every state reachable from it.
+    std::vector<std::vector<bool>> pending_regs(num_states, std::vector<bool>(num_regs, false));
+    for (bool changed{true}; changed;) {
+        changed = false;
+        for (uint32_t state_id{0}; state_id < num_states; ++state_id) {
+            auto regs{pending_regs[state_id]};
+            for (reg_id_t reg_id{0}; reg_id < num_regs; ++reg_id) {
+                if (observed_regs[state_id][reg_id]) {
+                    regs[reg_id] = true;
+                }
+            }
+            for (auto const& optional_transition : m_states[state_id]->get_class_transitions()) {
+                if (false == optional_transition.has_value()) {
+                    continue;
+                }
+                auto& dest_pending_regs{
+                        pending_regs[state_ids.at(optional_transition->get_dest_state())]
+                };
+                for (reg_id_t reg_id{0}; reg_id < num_regs; ++reg_id) {
+                    if (regs[reg_id] && false == dest_pending_regs[reg_id]) {
+                        dest_pending_regs[reg_id] = true;
+                        changed = true;
+                    }
+                }
+            }
+        }
+    }
+
+    // The registers live when entering each state, before its accepting operations
+    std::vector<std::vector<bool>> entry_live_regs(num_states, std::vector<bool>(num_regs, false));
+    auto const get_exit_live_regs{[&](uint32_t const state_id) -> std::vector<bool> {
+        std::vector<bool> live_regs(num_regs, false);
+        for (auto const& optional_transition : m_states[state_id]->get_class_transitions()) {
+            if (false == optional_transition.has_value()) {
+                continue;
+            }
+            auto dest_live_regs{
+                    entry_live_regs[state_ids.at(optional_transition->get_dest_state())]
+            };
+            update_live_regs(optional_transition->get_reg_ops(), dest_live_regs);
+            for (reg_id_t reg_id{0}; reg_id < num_regs; ++reg_id) {
+                if (dest_live_regs[reg_id]) {
+                    live_regs[reg_id] = true;
+                }
+            }
+        }
+        return live_regs;
+    }};
+    auto const get_accepting_live_regs{[&](uint32_t const state_id,
+                                           std::vector<bool> const& exit_live_regs) {
+        auto live_regs{exit_live_regs};
+        for (reg_id_t reg_id{0}; reg_id < num_regs; ++reg_id) {
+            if (observed_regs[state_id][reg_id]) {
+                live_regs[reg_id] = true;
+            }
+        }
+        return live_regs;
+    }};
+    for (bool changed{true}; changed;) {
+        changed = false;
+        for (auto state_id{num_states}; state_id-- > 0;) {
+            auto live_regs{get_exit_live_regs(state_id)};
+            auto const& state{m_states[state_id]};
+            if (state->is_accepting()) {
+                auto accepting_live_regs{get_accepting_live_regs(state_id, live_regs)};
+                update_live_regs(state->get_accepting_reg_ops(), accepting_live_regs);
+                for (reg_id_t reg_id{0}; reg_id < num_regs; ++reg_id) {
+                    if (accepting_live_regs[reg_id]) {
+                        live_regs[reg_id] = true;
+                    }
+                }
+            }
+            for (reg_id_t reg_id{0}; reg_id < num_regs; ++reg_id) {
+                if (pending_regs[state_id][reg_id]) {
+                    live_regs[reg_id] = true;
+                }
+            }
+            if (live_regs != entry_live_regs[state_id]) {
+                entry_live_regs[state_id] = std::move(live_regs);
+                changed = true;
+            }
+        }
+    }
+
+    std::vector<std::vector<bool>> interference(num_regs, std::vector<bool>(num_regs, false));
+    for (uint32_t state_id{0}; state_id < num_states; ++state_id) {
+        auto& state{m_states[state_id]};
+        if (state->is_accepting()) {
+            auto live_regs{get_accepting_live_regs(state_id, get_exit_live_regs(state_id))};
+            auto reg_ops{state->get_accepting_reg_ops()};
+            remove_dead_reg_ops(reg_ops, live_regs, interference);
+            state->set_accepting_ops(std::move(reg_ops));
+        }
+        auto const& transitions{state->get_class_transitions()};
+        for (uint32_t class_idx{0}; class_idx < transitions.size(); ++class_idx) {
+            if (false == transitions[class_idx].has_value()) {
+                continue;
+            }
+            auto const* dest_state{transitions[class_idx]->get_dest_state()};
+            auto reg_ops{transitions[class_idx]->get_reg_ops()};
+            auto live_regs{entry_live_regs[state_ids.at(dest_state)]};
+            remove_dead_reg_ops(reg_ops, live_regs, interference);
+            state->add_class_transition(
+                    static_cast<ByteClassMap::class_id_t>(class_idx),
+                    {std::move(reg_ops), dest_state}
+            );
+        }
+    }
+
+    // Registers of different kinds hold different representations, so they can't share an ID
+    for (reg_id_t reg_id{0}; reg_id < num_regs; ++reg_id) {
+        for (reg_id_t other_reg_id{0}; other_reg_id < num_regs; ++other_reg_id) {
+            if (m_multi_valued_regs[reg_id] != m_multi_valued_regs[other_reg_id]) {
+                interference[reg_id][other_reg_id] = true;
+            }
+        }
+    }
+
+    // Coalesce the registers of copies, starting with those on transitions as they're executed
+    // most often. Each group of coalesced registers is represented by one of its registers, whose
+    // row in `interference` is the union of the group's rows.
+    std::vector<reg_id_t> reg_id_to_parent(num_regs);
+    std::iota(reg_id_to_parent.begin(), reg_id_to_parent.end(), 0);
+    auto const find_group{[&](reg_id_t reg_id) {
+        while (reg_id_to_parent[reg_id] != reg_id) {
+            reg_id_to_parent[reg_id] = reg_id_to_parent[reg_id_to_parent[reg_id]];
+            reg_id = reg_id_to_parent[reg_id];
+        }
+        return reg_id;
+    }};
+    std::vector<bool> has_final_reg(num_regs, false);
+    for (auto const& [tag_id, final_reg_id] : m_tag_id_to_final_reg_id) {
+        has_final_reg[final_reg_id] = true;
+    }
+    auto const try_coalesce{[&](RegisterOperation const& reg_op) {
+        if (RegisterOperation::Type::Copy != reg_op.get_type()) {
+            return;
+        }
+        auto group{find_group(reg_op.get_reg_id())};
+        auto other_group{find_group(reg_op.get_copy_reg_id().value())};
+        if (group == other_group || interference[group][other_group]
+            || (has_final_reg[group] && has_final_reg[other_group]))
+        {
+            return;
+        }
+        reg_id_to_parent[other_group] = group;
+        has_final_reg[group] = has_final_reg[group] || has_final_reg[other_group];
+        for (reg_id_t reg_id{0}; reg_id < num_regs; ++reg_id) {
+            if (interference[other_group][reg_id]) {
+                interference[group][reg_id] = true;
+                interference[reg_id][group] = true;
+            }
+        }
+    }};
+    for (auto const& state : m_states) {
+        for (auto const& optional_transition : state->get_class_transitions()) {
+            if (optional_transition.has_value()) {
+                std::ranges::for_each(optional_transition->get_reg_ops(), try_coalesce);
+            }
+        }
+    }
+    for (auto const& state : m_states) {
+        std::ranges::for_each(state->get_accepting_reg_ops(), try_coalesce);
+    }
+
+    // Color the groups, starting with the final registers' groups
+    constexpr reg_id_t cNoColor{std::numeric_limits<reg_id_t>::max()};
+    std::vector<reg_id_t> group_to_color(num_regs, cNoColor);
+    std::vector<std::vector<reg_id_t>> color_to_groups;
+    for (auto const& [tag_id, final_reg_id] : m_tag_id_to_final_reg_id) {
+        group_to_color[find_group(final_reg_id)] = color_to_groups.size();
+        color_to_groups.push_back({find_group(final_reg_id)});
+    }
+    auto const get_new_reg_id{[&](reg_id_t const reg_id) {
+        auto const group{find_group(reg_id)};
+        if (cNoColor != group_to_color[group]) {
+            return group_to_color[group];
+        }
+        reg_id_t color{0};
+        while (color < color_to_groups.size()
+               && std::ranges::any_of(color_to_groups[color], [&](reg_id_t const other_group) {
+                      return interference[group][other_group];
+                  }))
+        {
+            ++color;
+        }
+        if (color == color_to_groups.size()) {
+            color_to_groups.emplace_back();
+        }
+        color_to_groups[color].push_back(group);
+        group_to_color[group] = color;
+        return color;
+    }};
+    auto const rename_reg_ops{[&](std::vector<RegisterOperation> const& reg_ops) {
+        std::vector<RegisterOperation> renamed_reg_ops;
+        for (auto const& reg_op : reg_ops) {
+            auto const new_reg_id{get_new_reg_id(reg_op.get_reg_id())};
+            switch (reg_op.get_type()) {
+                case RegisterOperation::Type::Set:
+                    renamed_reg_ops.push_back(RegisterOperation::create_set_operation(new_reg_id));
+                    break;
+                case RegisterOperation::Type::Negate:
+                    renamed_reg_ops.push_back(
+                            RegisterOperation::create_negate_operation(new_reg_id)
+                    );
+                    break;
+                case RegisterOperation::Type::Copy: {
+                    auto const new_copy_reg_id{get_new_reg_id(reg_op.get_copy_reg_id().value())};
+                    if (new_copy_reg_id != new_reg_id) {
+                        renamed_reg_ops.push_back(
+                                RegisterOperation::create_copy_operation(
+                                        new_reg_id,
+                                        new_copy_reg_id
+                                )
+                        );
+                    }
+                    break;
+                }
+                default:
+                    throw std::logic_error("Unhandled register operation type when renaming.");
+            }
+        }
+        return renamed_reg_ops;
+    }};
+    for (auto const& state : m_states) {
+        state->set_accepting_ops(rename_reg_ops(state->get_accepting_reg_ops()));
+        auto const& transitions{state->get_class_transitions()};
+        for (uint32_t class_idx{0}; class_idx < transitions.size(); ++class_idx) {
+            if (false == transitions[class_idx].has_value()) {
+                continue;
+            }
+            auto const* dest_state{transitions[class_idx]->get_dest_state()};
+            state->add_class_transition(
+                    static_cast<ByteClassMap::class_id_t>(class_idx),
+                    {rename_reg_ops(transitions[class_idx]->get_reg_ops()), dest_state}
+            );
+        }
+    }
+
+    for (auto& [tag_id, final_reg_id] : m_tag_id_to_final_reg_id) {
+        final_reg_id = get_new_reg_id(final_reg_id);
+    }
+    m_num_regs = color_to_groups.size();
+    std::vector<bool> multi_valued_regs;
+    multi_valued_regs.reserve(m_num_regs);
+    for (auto const& groups : color_to_groups) {
+        multi_valued_regs.push_back(m_multi_valued_regs[groups.front()]);
+    }
+    m_multi_valued_regs = std::move(multi_valued_regs);
+    reset_registers();
+}
+
+template <typename TypedDfaState, typename TypedNfaState>
+auto Dfa<TypedDfaState, TypedNfaState>::get_stats() const -> DfaStats {
+    DfaStats stats{
+            .m_num_states = static_cast<uint32_t>(m_states.size()),
+            .m_num_bytes = 0,
+            .m_num_regs = static_cast<uint32_t>(m_num_regs),
+            .m_num_reg_ops = 0
+    };
+    for (auto const& state : m_states) {
+        stats.m_num_bytes += state->get_num_bytes();
+        stats.m_num_reg_ops += state->get_accepting_reg_ops().size();
+        for (auto const& optional_transition : state->get_class_transitions()) {
+            if (optional_transition.has_value()) {
+                stats.m_num_reg_ops += optional_transition->get_reg_ops().size();
+            }
+        }
+    }
+    return stats;
+}
+
+template <typename TypedDfaState, typename TypedNfaState>
+auto Dfa<TypedDfaState, TypedNfaState>::get_state_ids() const
+        -> std::unordered_map<TypedDfaState const*, uint32_t> {
+    std::unordered_map<TypedDfaState const*, uint32_t> state_ids;
+    for (uint32_t state_id{0}; state_id < m_states.size(); ++state_id) {
+        state_ids.emplace(m_states[state_id].get(), state_id);
+    }
+    return state_ids;
+}
+
+template <typename TypedDfaState, typename TypedNfaState>
+auto Dfa<TypedDfaState, TypedNfaState>::update_live_regs(
+        std::vector<RegisterOperation> const& reg_ops,
+        std::vector<bool>& live_regs
+) -> void {
+    for (auto it{reg_ops.crbegin()}; reg_ops.crend() != it; ++it) {
+        // Set and negate operations append to the register, so they keep it live
+        if (RegisterOperation::Type::Copy == it->get_type() && live_regs[it->get_reg_id()]) {
+            live_regs[it->get_reg_id()] = false;
+            live_regs[it->get_copy_reg_id().value()] = true;
+        }
+    }
+}
+
+template <typename TypedDfaState, typename TypedNfaState>
+auto Dfa<TypedDfaState, TypedNfaState>::remove_dead_reg_ops(
+        std::vector<RegisterOperation>& reg_ops,
+        std::vector<bool>& live_regs,
+        std::vector<std::vector<bool>>& interference
+) -> void {
+    std::vector<RegisterOperation> live_reg_ops;
+    for (auto it{reg_ops.crbegin()}; reg_ops.crend() != it; ++it) {
+        auto const reg_id{it->get_reg_id()};
+        if (false == live_regs[reg_id]) {
+            continue;
+        }
+        auto const is_copy{RegisterOperation::Type::Copy == it->get_type()};
+        if (is_copy && it->get_copy_reg_id().value() == reg_id) {
+            continue;
+        }
+        for (reg_id_t other_reg_id{0}; other_reg_id < live_regs.size(); ++other_reg_id) {
+            if (false == live_regs[other_reg_id] || other_reg_id == reg_id
+                || (is_copy && it->get_copy_reg_id().value() == other_reg_id))
+            {
+                continue;
+            }
+            interference[reg_id][other_reg_id] = true;
+            interference[other_reg_id][reg_id] = true;
+        }
+        if (is_copy) {
+            live_regs[reg_id] = false;
+            live_regs[it->get_copy_reg_id().value()] = true;
+        }
+        live_reg_ops.push_back(*it);
+    }
+    reg_ops.assign(live_reg_ops.crbegin(), live_reg_ops.crend());
+}
+
+template <typename TypedDfaState, typename TypedNfaState>
+auto Dfa<TypedDfaState, TypedNfaState>::initialize_registers(
+        std::vector<bool> const& multi_valued_tags,
         RegisterHandler& register_handler,
-        std::map<tag_id_t, reg_id_t>& tag_id_to_initial_reg_id,
+        std::vector<reg_id_t>& initial_reg_ids,
         std::map<tag_id_t, reg_id_t>& tag_id_to_final_reg_id
 ) -> void {
-    register_handler.add_registers(2 * num_tags);
+    auto const num_tags{static_cast<uint32_t>(multi_valued_tags.size())};
+    for (auto const multi_valued : multi_valued_tags) {
+        register_handler.add_register(multi_valued);
+    }
+    for (auto const multi_valued : multi_valued_tags) {
+        register_handler.add_register(multi_valued);
+    }
     for (uint32_t i{0}; i < num_tags; i++) {
-        tag_id_to_initial_reg_id.insert({i, i});
+        initial_reg_ids.push_back(i);
         tag_id_to_final_reg_id.insert({i, num_tags + i});
     }
 }
@@ -354,12 +1291,15 @@ auto Dfa<TypedDfaState, TypedNfaState>::try_get_mapping(
             {
                 continue;
             }
-            for (auto const [tag_id, lhs_reg_id] : config_lhs.get_tag_id_to_reg_ids()) {
+            auto const& lhs_reg_ids{config_lhs.get_reg_ids()};
+            auto const& rhs_reg_ids{config_rhs.get_reg_ids()};
+            for (tag_id_t tag_id{0}; tag_id < lhs_reg_ids.size(); ++tag_id) {
                 // If the NFA state sets the tag then the current register is irrelevent
                 if (config_lhs.get_tag_lookahead(tag_id).has_value()) {
                     continue;
                 }
-                auto const rhs_reg_id{config_rhs.get_tag_id_to_reg_ids().at(tag_id)};
+                auto const lhs_reg_id{lhs_reg_ids[tag_id]};
+                auto const rhs_reg_id{rhs_reg_ids[tag_id]};
                 if (false == reg_map_lhs_to_rhs.contains(lhs_reg_id)
                     && false == reg_map_rhs_to_lhs.contains(rhs_reg_id))
                 {
@@ -386,67 +1326,124 @@ auto Dfa<TypedDfaState, TypedNfaState>::try_get_mapping(
 template <typename TypedDfaState, typename TypedNfaState>
 auto Dfa<TypedDfaState, TypedNfaState>::create_or_get_dfa_state(
         ConfigurationSet const& config_set,
-        std::map<ConfigurationSet, TypedDfaState*>& dfa_states,
+        DfaStateMap& dfa_states,
+        MappingCandidates& mapping_candidates,
         std::queue<ConfigurationSet>& unexplored_sets
 ) -> std::pair<TypedDfaState*, std::optional<std::unordered_map<reg_id_t, reg_id_t>>> {
-    if (false == dfa_states.contains(config_set)) {
-        for (auto const& [config_set_in_map, dfa_state] : dfa_states) {
-            auto const optional_reg_map{try_get_mapping(config_set, config_set_in_map)};
-            if (optional_reg_map.has_value()) {
-                return {dfa_state, optional_reg_map};
-            }
+    if (auto const it{dfa_states.find(config_set)}; dfa_states.end() != it) {
+        return {it->second, std::nullopt};
+    }
+    auto& candidates{mapping_candidates[get_register_agnostic_hash(config_set)]};
+    for (auto const& [candidate_config_set, dfa_state] : candidates) {
+        auto const optional_reg_map{try_get_mapping(config_set, *candidate_config_set)};
+        if (optional_reg_map.has_value()) {
+            return {dfa_state, optional_reg_map};
         }
-        dfa_states.insert({config_set, new_state(config_set, m_tag_id_to_final_reg_id)});
-        unexplored_sets.push(config_set);
     }
-    return {dfa_states.at(config_set), std::nullopt};
+    auto* dfa_state{new_state(config_set, m_tag_id_to_final_reg_id)};
+    auto const* inserted_config_set{&dfa_states.emplace(config_set, dfa_state).first->first};
+    candidates.emplace(
+            std::upper_bound(
+                    candidates.begin(),
+                    candidates.end(),
+                    inserted_config_set,
+                    [](ConfigurationSet const* lhs, auto const& rhs) { return *lhs < *rhs.first; }
+            ),
+            inserted_config_set,
+            dfa_state
+    );
+    unexplored_sets.push(config_set);
+    return {dfa_state, std::nullopt};
+}
+
+template <typename TypedDfaState, typename TypedNfaState>
+auto Dfa<TypedDfaState, TypedNfaState>::add_transition_registers(
+        std::vector<bool> const& multi_valued_tags,
+        reg_id_t const first_reg_id,
+        std::map<tag_id_t, reg_id_t> const& tag_id_with_op_to_reg_id
+) -> void {
+    std::vector<bool> multi_valued_regs(tag_id_with_op_to_reg_id.size());
+    for (auto const& [tag_id, reg_id] : tag_id_with_op_to_reg_id) {
+        multi_valued_regs[reg_id - first_reg_id] = multi_valued_tags[tag_id];
+    }
+    for (auto const multi_valued : multi_valued_regs) {
+        m_reg_handler.add_register(multi_valued);
+    }
+}
+
+template <typename TypedDfaState, typename TypedNfaState>
+auto Dfa<TypedDfaState, TypedNfaState>::reset_registers() -> void {
+    m_reg_handler = RegisterHandler();
+    for (auto const multi_valued : m_multi_valued_regs) {
+        m_reg_handler.add_register(multi_valued);
+    }
 }
 
 template <typename TypedDfaState, typename TypedNfaState>
 auto Dfa<TypedDfaState, TypedNfaState>::get_transitions(
         size_t const num_tags,
         ConfigurationSet const& config_set,
+        reg_id_t const first_new_reg_id,
         std::map<tag_id_t, reg_id_t>& tag_id_with_op_to_reg_id
-) -> std::map<uint32_t, std::pair<std::vector<RegisterOperation>, ConfigurationSet>> {
-    std::map<uint32_t, std::pair<std::vector<RegisterOperation>, ConfigurationSet>>
-            ascii_transitions_map;
+) const -> TransitionMap {
+    TransitionMap class_transitions_map;
     for (auto const& configuration : config_set) {
-        auto const* nfa_state{configuration.get_state()};
-        for (uint32_t i{0}; i < cSizeOfByte; ++i) {
-            for (auto const* next_nfa_state : nfa_state->get_byte_transitions(i)) {
-                DeterminizationConfiguration<TypedNfaState> next_configuration{
-                        next_nfa_state,
-                        configuration.get_tag_id_to_reg_ids(),
-                        configuration.get_lookahead(),
-                        {}
-                };
-                auto closure{next_configuration.spontaneous_closure()};
-                auto const new_reg_ops{
-                        assign_transition_reg_ops(num_tags, closure, tag_id_with_op_to_reg_id)
-                };
-                if (ascii_transitions_map.contains(i)) {
-                    for (auto const& new_reg_op : new_reg_ops) {
-                        auto& byte_reg_ops{ascii_transitions_map.at(i).first};
-                        if (byte_reg_ops.end()
-                            == std::find(byte_reg_ops.begin(), byte_reg_ops.end(), new_reg_op))
-                        {
-                            byte_reg_ops.push_back(new_reg_op);
+        // Every byte in a class has the same transitions, so each class is handled in the
+        // interval containing its representative. This visits the classes in ascending order.
+        for (auto const& [first, last, dest_states] :
+             configuration.get_state()->get_byte_transition_intervals())
+        {
+            auto const [class_ids_begin, class_ids_end]{
+                    m_byte_class_map->get_class_ids_starting_in(first, last)
+            };
+            for (auto class_idx{class_ids_begin}; class_idx < class_ids_end; ++class_idx) {
+                auto const class_id{static_cast<ByteClassMap::class_id_t>(class_idx)};
+                for (auto const* next_nfa_state : dest_states) {
+                    DeterminizationConfiguration<TypedNfaState> next_configuration{
+                            next_nfa_state,
+                            configuration.get_reg_ids(),
+                            configuration.get_lookahead(),
+                            {}
+                    };
+                    auto closure{next_configuration.spontaneous_closure()};
+                    auto const new_reg_ops{assign_transition_reg_ops(
+                            num_tags,
+                            closure,
+                            first_new_reg_id,
+                            tag_id_with_op_to_reg_id
+                    )};
+                    if (class_transitions_map.contains(class_id)) {
+                        auto& [class_reg_ops, class_closure]{class_transitions_map.at(class_id)};
+                        for (auto const& new_reg_op : new_reg_ops) {
+                            if (class_reg_ops.end()
+                                == std::find(
+                                        class_reg_ops.begin(),
+                                        class_reg_ops.end(),
+                                        new_reg_op
+                                ))
+                            {
+                                class_reg_ops.push_back(new_reg_op);
+                            }
                         }
+                        class_closure.merge(closure);
+                    } else {
+                        class_transitions_map.emplace(
+                                class_id,
+                                std::make_pair(new_reg_ops, std::move(closure))
+                        );
                     }
-                    ascii_transitions_map.at(i).second.insert(closure.begin(), closure.end());
-                } else {
-                    ascii_transitions_map.emplace(i, std::make_pair(new_reg_ops, closure));
                 }
             }
         }
     }
-    return ascii_transitions_map;
+    return class_transitions_map;
 }
 
 template <typename TypedDfaState, typename TypedNfaState>
 auto Dfa<TypedDfaState, TypedNfaState>::assign_transition_reg_ops(
         size_t const num_tags,
         ConfigurationSet& closure,
+        reg_id_t const first_new_reg_id,
         std::map<tag_id_t, reg_id_t>& tag_id_with_op_to_reg_id
 ) -> std::vector<RegisterOperation> {
     std::vector<RegisterOperation> reg_ops;
@@ -457,7 +1454,11 @@ auto Dfa<TypedDfaState, TypedNfaState>::assign_transition_reg_ops(
             if (optional_tag_op.has_value()) {
                 auto const tag_op{optional_tag_op.value()};
                 if (false == tag_id_with_op_to_reg_id.contains(tag_id)) {
-                    tag_id_with_op_to_reg_id.emplace(tag_id, m_reg_handler.add_register());
+                    auto const num_new_regs{tag_id_with_op_to_reg_id.size()};
+                    tag_id_with_op_to_reg_id.emplace(
+                            tag_id,
+                            first_new_reg_id + static_cast<reg_id_t>(num_new_regs)
+                    );
                 }
                 auto reg_id = tag_id_with_op_to_reg_id.at(tag_id);
                 if (std::none_of(
@@ -477,9 +1478,9 @@ auto Dfa<TypedDfaState, TypedNfaState>::assign_transition_reg_ops(
                 config.set_reg_id(tag_id, tag_id_with_op_to_reg_id.at(tag_id));
             }
         }
-        new_closure.insert(config);
+        new_closure.insert(std::move(config));
     }
-    closure = new_closure;
+    closure = std::move(new_closure);
     return reg_ops;
 }
 
@@ -511,7 +1512,7 @@ auto Dfa<TypedDfaState, TypedNfaState>::new_state(
         ConfigurationSet const& config_set,
         std::map<tag_id_t, reg_id_t> const& tag_id_to_final_reg_id
 ) -> TypedDfaState* {
-    m_states.emplace_back(std::make_unique<TypedDfaState>());
+    m_states.emplace_back(std::make_unique<TypedDfaState>(*m_byte_class_map));
     auto* dfa_state = m_states.back().get();
     for (auto const& config : config_set) {
         auto const* nfa_state = config.get_state();
@@ -530,8 +1531,7 @@ auto Dfa<TypedDfaState, TypedNfaState>::new_state(
                         );
                     }
                 } else {
-                    // Note: `config` must have a reg for this tag so we just call `at`.
-                    auto const prev_reg_id{config.get_tag_id_to_reg_ids().at(tag_id)};
+                    auto const prev_reg_id{config.get_reg_ids()[tag_id]};
                     dfa_state->add_accepting_op(
                             RegisterOperation::create_copy_operation(final_reg_id, prev_reg_id)
                     );
@@ -616,5 +1616,152 @@ auto Dfa<TypedDfaState, TypedNfaState>::serialize() const -> std::optional<std::
     }
     return fmt::format("{}\n", fmt::join(serialized_states, "\n"));
 }
+
+template <typename TypedDfaState, typename TypedNfaState>
+auto Dfa<TypedDfaState, TypedNfaState>::serialize_binary(BinaryWriter& writer) const -> void {
+    writer.write(m_byte_class_map->get_byte_to_class_id());
+    std::vector<uint8_t> const multi_valued_regs(
+            m_multi_valued_regs.cbegin(),
+            m_multi_valued_regs.cend()
+    );
+    writer.write_vector(multi_valued_regs);
+    writer.write(static_cast<uint64_t>(m_tag_id_to_final_reg_id.size()));
+    for (auto const& [tag_id, reg_id] : m_tag_id_to_final_reg_id) {
+        writer.write(tag_id);
+        writer.write(reg_id);
+    }
+
+    auto const state_ids{get_state_ids()};
+    writer.write(static_cast<uint64_t>(m_states.size()));
+    for (auto const& state : m_states) {
+        writer.write_vector(state->get_matching_variable_ids());
+        serialize_reg_ops(state->get_accepting_reg_ops(), writer);
+        for (auto const& optional_transition : state->get_class_transitions()) {
+            if (false == optional_transition.has_value()) {
+                writer.write(cNoTransition);
+                continue;
+            }
+            writer.write(state_ids.at(optional_transition->get_dest_state()));
+            serialize_reg_ops(optional_transition->get_reg_ops(), writer);
+        }
+    }
+}
+
+template <typename TypedDfaState, typename TypedNfaState>
+auto Dfa<TypedDfaState, TypedNfaState>::load_binary(BinaryReader& reader) -> std::unique_ptr<Dfa> {
+    std::unique_ptr<Dfa> dfa{new Dfa()};
+
+    // Class IDs follow the order of the classes' smallest bytes, so refining a map by the IDs
+    // reproduces them unless they're invalid.
+    auto const byte_to_class_id{reader.read<std::array<ByteClassMap::class_id_t, cSizeOfByte>>()};
+    std::array<uint32_t, cSizeOfByte> byte_keys{};
+    std::copy(byte_to_class_id.cbegin(), byte_to_class_id.cend(), byte_keys.begin());
+    dfa->m_byte_class_map = std::make_unique<ByteClassMap>();
+    dfa->m_byte_class_map->refine(byte_keys);
+    if (dfa->m_byte_class_map->get_byte_to_class_id() != byte_to_class_id) {
+        throw std::runtime_error("Binary DFA has invalid byte classes.");
+    }
+
+    auto const multi_valued_regs{reader.read_vector<uint8_t>()};
+    if (multi_valued_regs.size() > std::numeric_limits<reg_id_t>::max()) {
+        throw std::runtime_error("Binary DFA has too many registers.");
+    }
+    for (auto const multi_valued : multi_valued_regs) {
+        if (multi_valued > 1) {
+            throw std::runtime_error("Binary DFA has a register of an invalid kind.");
+        }
+        dfa->m_multi_valued_regs.push_back(1 == multi_valued);
+    }
+    dfa->m_num_regs = multi_valued_regs.size();
+    auto const num_tags{reader.read_size(sizeof(tag_id_t) + sizeof(reg_id_t))};
+    for (size_t i{0}; i < num_tags; ++i) {
+        auto const tag_id{reader.read<tag_id_t>()};
+        auto const reg_id{reader.read<reg_id_t>()};
+        if (reg_id >= dfa->m_num_regs) {
+            throw std::runtime_error("Binary DFA has an invalid final register.");
+        }
+        dfa->m_tag_id_to_final_reg_id.emplace(tag_id, reg_id);
+    }
+    dfa->reset_registers();
+
+    auto const num_states{reader.read_size(1)};
+    if (0 == num_states) {
+        throw std::runtime_error("Binary DFA has no root.");
+    }
+    dfa->m_states.reserve(num_states);
+    for (size_t i{0}; i < num_states; ++i) {
+        dfa->m_states.emplace_back(std::make_unique<TypedDfaState>(*dfa->m_byte_class_map));
+    }
+    auto const num_classes{dfa->m_byte_class_map->get_num_classes()};
+    for (auto& state : dfa->m_states) {
+        for (auto const variable_id : reader.read_vector<uint32_t>()) {
+            state->add_matching_variable_id(variable_id);
+        }
+        state->set_accepting_ops(load_reg_ops(dfa->m_num_regs, reader));
+        for (uint32_t class_idx{0}; class_idx < num_classes; ++class_idx) {
+            auto const dest_state_id{reader.read<uint32_t>()};
+            if (cNoTransition == dest_state_id) {
+                continue;
+            }
+            if (dest_state_id >= num_states) {
+                throw std::runtime_error("Binary DFA has a transition to an invalid state.");
+            }
+            state->add_class_transition(
+                    static_cast<ByteClassMap::class_id_t>(class_idx),
+                    {load_reg_ops(dfa->m_num_regs, reader), dfa->m_states[dest_state_id].get()}
+            );
+        }
+    }
+    return dfa;
+}
+
+template <typename TypedDfaState, typename TypedNfaState>
+auto Dfa<TypedDfaState, TypedNfaState>::serialize_reg_ops(
+        std::vector<RegisterOperation> const& reg_ops,
+        BinaryWriter& writer
+) -> void {
+    writer.write(static_cast<uint64_t>(reg_ops.size()));
+    for (auto const& reg_op : reg_ops) {
+        writer.write(reg_op.get_type());
+        writer.write(reg_op.get_reg_id());
+        if (RegisterOperation::Type::Copy == reg_op.get_type()) {
+            writer.write(reg_op.get_copy_reg_id().value());
+        }
+    }
+}
+
+template <typename TypedDfaState, typename TypedNfaState>
+auto Dfa<TypedDfaState, TypedNfaState>::load_reg_ops(size_t const num_regs, BinaryReader& reader)
+        -> std::vector<RegisterOperation> {
+    auto const read_reg_id{[&]() -> reg_id_t {
+        auto const reg_id{reader.read<reg_id_t>()};
+        if (reg_id >= num_regs) {
+            throw std::runtime_error("Binary DFA has an operation on an invalid register.");
+        }
+        return reg_id;
+    }};
+
+    std::vector<RegisterOperation> reg_ops;
+    auto const num_reg_ops{reader.read_size(sizeof(RegisterOperation::Type) + sizeof(reg_id_t))};
+    reg_ops.reserve(num_reg_ops);
+    for (size_t i{0}; i < num_reg_ops; ++i) {
+        auto const type{reader.read<RegisterOperation::Type>()};
+        auto const reg_id{read_reg_id()};
+        switch (type) {
+            case RegisterOperation::Type::Copy:
+                reg_ops.push_back(RegisterOperation::create_copy_operation(reg_id, read_reg_id()));
+                break;
+            case RegisterOperation::Type::Set:
+                reg_ops.push_back(RegisterOperation::create_set_operation(reg_id));
+                break;
+            case RegisterOperation::Type::Negate:
+                reg_ops.push_back(RegisterOperation::create_negate_operation(reg_id));
+                break;
+            default:
+                throw std::runtime_error("Binary DFA has an invalid register operation.");
+        }
+    }
+    return reg_ops;
+}
 }  // namespace log_surgeon::finite_automata
 #endif  // LOG_SURGEON_FINITE_AUTOMATA_DFA_HPP
@@ -1,8 +1,8 @@
 #ifndef LOG_SURGEON_FINITE_AUTOMATA_DFA_STATE
 #define LOG_SURGEON_FINITE_AUTOMATA_DFA_STATE
 
-#include <array>
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <optional>
@@ -10,9 +10,11 @@
 #include <tuple>
 #include <type_traits>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <log_surgeon/Constants.hpp>
+#include <log_surgeon/finite_automata/ByteClassMap.hpp>
 #include <log_surgeon/finite_automata/DfaTransition.hpp>
 #include <log_surgeon/finite_automata/RegisterOperation.hpp>
 #include <log_surgeon/finite_automata/StateType.hpp>
@@ -33,7 +35,13 @@ class DfaState {
 public:
     using Tree = UnicodeIntervalTree<DfaState*>;
 
-    DfaState() = default;
+    /**
+     * @param byte_class_map The byte equivalence classes the state's transitions are indexed by.
+     * The map must outlive the state.
+     */
+    explicit DfaState(ByteClassMap const& byte_class_map)
+            : m_byte_class_map{&byte_class_map},
+              m_class_transitions(byte_class_map.get_num_classes()) {}
 
     auto add_matching_variable_id(uint32_t const variable_id) -> void {
         m_matching_variable_ids.push_back(variable_id);
@@ -47,14 +55,21 @@ public:
         return false == m_matching_variable_ids.empty();
     }
 
-    auto add_byte_transition(uint8_t const byte, DfaTransition<state_type> dfa_transition) -> void {
-        m_bytes_transition[byte] = dfa_transition;
+    auto add_class_transition(
+            ByteClassMap::class_id_t const class_id,
+            DfaTransition<state_type> dfa_transition
+    ) -> void {
+        m_class_transitions[class_id] = std::move(dfa_transition);
     }
 
     auto add_accepting_op(RegisterOperation const reg_op) -> void {
         m_accepting_ops.push_back(reg_op);
     }
 
+    auto set_accepting_ops(std::vector<RegisterOperation> reg_ops) -> void {
+        m_accepting_ops = std::move(reg_ops);
+    }
+
     /**
      * @param state_ids A map of states to their unique identifiers.
      * @return A string representation of the DFA state.
@@ -75,10 +90,29 @@ public:
         return m_accepting_ops;
     }
 
+    [[nodiscard]] auto get_byte_class_map() const -> ByteClassMap const& {
+        return *m_byte_class_map;
+    }
+
+    /**
+     * @return The state's transitions, indexed by byte class ID.
+     */
+    [[nodiscard]] auto get_class_transitions() const
+            -> std::vector<std::optional<DfaTransition<state_type>>> const& {
+        return m_class_transitions;
+    }
+
+    /**
+     * @return The number of bytes used by the state and the heap memory it owns. The byte class
+     * map, which is shared by all states, is not included.
+     */
+    [[nodiscard]] auto get_num_bytes() const -> size_t;
+
 private:
+    ByteClassMap const* m_byte_class_map;
     std::vector<uint32_t> m_matching_variable_ids;
     std::vector<RegisterOperation> m_accepting_ops;
-    std::array<std::optional<DfaTransition<state_type>>, cSizeOfByte> m_bytes_transition;
+    std::vector<std::optional<DfaTransition<state_type>>> m_class_transitions;
     // NOTE: We don't need m_tree_transitions for the `state_type == StateType::Byte` case, so we
     // use an empty class (`std::tuple<>`) in that case.
     std::conditional_t<state_type == StateType::Utf8, Tree, std::tuple<>> m_tree_transitions;
@@ -88,7 +122,23 @@ private:
 template <>
 [[nodiscard]] inline auto DfaState<StateType::Byte>::get_transition(uint8_t const character) const
         -> std::optional<DfaTransition<StateType::Byte>> const& {
-    return m_bytes_transition[character];
+    return m_class_transitions[m_byte_class_map->get_class_id(character)];
+}
+
+template <StateType state_type>
+auto DfaState<state_type>::get_num_bytes() const -> size_t {
+    auto num_bytes{
+            sizeof(*this) + m_matching_variable_ids.capacity() * sizeof(uint32_t)
+            + m_accepting_ops.capacity() * sizeof(RegisterOperation)
+            + m_class_transitions.capacity()
+                      * sizeof(std::optional<DfaTransition<state_type>>)
+    };
+    for (auto const& optional_transition : m_class_transitions) {
+        if (optional_transition.has_value()) {
+            num_bytes += optional_transition->get_reg_ops().capacity() * sizeof(RegisterOperation);
+        }
+    }
+    return num_bytes;
 }
 
 template <StateType state_type>
@@ -118,10 +168,11 @@ auto DfaState<state_type>::serialize(
 
     std::vector<std::string> transition_strings;
     for (uint32_t idx{0}; idx < cSizeOfByte; ++idx) {
-        if (false == m_bytes_transition[idx].has_value()) {
+        auto const& optional_transition{m_class_transitions[m_byte_class_map->get_class_id(idx)]};
+        if (false == optional_transition.has_value()) {
             continue;
         }
-        auto const optional_byte_transition_string{m_bytes_transition[idx]->serialize(state_ids)};
+        auto const optional_byte_transition_string{optional_transition->serialize(state_ids)};
         if (false == optional_byte_transition_string.has_value()) {
             return std::nullopt;
         }
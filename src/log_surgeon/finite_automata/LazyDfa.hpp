@@ -0,0 +1,344 @@
+#ifndef LOG_SURGEON_FINITE_AUTOMATA_LAZY_DFA_HPP
+#define LOG_SURGEON_FINITE_AUTOMATA_LAZY_DFA_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <log_surgeon/Constants.hpp>
+#include <log_surgeon/finite_automata/Nfa.hpp>
+#include <log_surgeon/finite_automata/RuntimeDfa.hpp>
+
+namespace log_surgeon::finite_automata {
+/**
+ * Determinizes an NFA on demand, in the style of RE2's DFA, instead of building the whole DFA up
+ * front. The determinized states are cached in a `RuntimeDfa`, which is simulated exactly like a
+ * fully built one, except that a transition leading to `RuntimeDfa::cUnexploredState` must be
+ * determinized with `get_next_state` first. Only the states an input actually reaches are built, so
+ * rules whose DFA is exponentially larger than their NFA stay cheap on typical inputs.
+ *
+ * The cache holds at most a fixed number of states. When it's full, every state is removed
+ * (flushed) and determinization continues from the current state. If flushes keep happening after
+ * only a few bytes per cached state, the input reaches too many distinct states for caching to pay
+ * off, and the DFA falls back to simulating the NFA: each transition is then computed from the NFA
+ * without being cached.
+ *
+ * Register operations aren't supported, so the NFA must not contain any tags.
+ *
+ * @tparam TypedNfaState The type representing an NFA state.
+ */
+template <typename TypedNfaState>
+class LazyDfa {
+public:
+    using state_id_t = RuntimeDfa::state_id_t;
+
+    static constexpr size_t cDefaultMaxNumCachedStates{10'000};
+    // A flush after fewer scanned bytes per cached state than this is considered unproductive
+    static constexpr uint64_t cMinNumScannedBytesPerState{10};
+    // Consecutive unproductive flushes after which the NFA is simulated instead
+    static constexpr uint32_t cMaxNumUnproductiveFlushes{3};
+
+    /**
+     * Creates the root state in `cache`, which must have been created with the byte classes of
+     * `nfa` and must not be modified by anything else.
+     * @param nfa The NFA to determinize, which must not contain any tags.
+     * @param cache The table to cache the determinized states in.
+     * @param max_num_cached_states The maximum number of states in `cache`, including the dead
+     * state. At least 4 states are always allowed.
+     */
+    LazyDfa(std::unique_ptr<Nfa<TypedNfaState>> nfa,
+            RuntimeDfa& cache,
+            size_t max_num_cached_states = cDefaultMaxNumCachedStates);
+
+    /**
+     * Determinizes the transition out of `state` on `byte`, and caches it unless the NFA is being
+     * simulated.
+     * @param state Returns the ID of the same state after flushing the cache, if it was flushed.
+     * @param byte
+     * @param num_scanned_bytes The number of bytes the caller has scanned so far, which decides
+     * whether a flush was productive.
+     * @return The state the transition leads to.
+     */
+    auto get_next_state(state_id_t& state, uint8_t byte, uint64_t num_scanned_bytes)
+            -> state_id_t;
+
+    /**
+     * @return Whether each byte leads out of the root to any state other than the dead state.
+     */
+    [[nodiscard]] auto get_bytes_leaving_root() const -> std::array<bool, cSizeOfByte>;
+
+    /**
+     * @param state A state other than the dead state.
+     * @return A key for the set of NFA states `state` represents, which, unlike the state's ID,
+     * stays the same when the cache is flushed or while the NFA is simulated, until
+     * `clear_state_keys` is called.
+     */
+    [[nodiscard]] auto get_state_key(state_id_t const state) -> uint32_t {
+        return m_state_keys
+                .try_emplace(
+                        m_state_sets[state & RuntimeDfa::cStateIndexMask],
+                        static_cast<uint32_t>(m_state_keys.size())
+                )
+                .first->second;
+    }
+
+    /**
+     * Forgets the keys returned by `get_state_key`.
+     */
+    auto clear_state_keys() -> void { m_state_keys.clear(); }
+
+    [[nodiscard]] auto get_num_flushes() const -> uint64_t { return m_num_flushes; }
+
+    [[nodiscard]] auto is_simulating_nfa() const -> bool { return m_is_simulating_nfa; }
+
+private:
+    // A set of NFA states, as their IDs in ascending order
+    using StateSet = std::vector<uint32_t>;
+
+    struct StateSetHash {
+        auto operator()(StateSet const& state_set) const -> size_t {
+            auto seed{state_set.size()};
+            for (auto const id : state_set) {
+                seed = seed * 31 + id;
+            }
+            return seed;
+        }
+    };
+
+    // While simulating the NFA, the current state alternates between these two states
+    static constexpr state_id_t cFirstScratchState{2};
+    static constexpr state_id_t cSecondScratchState{3};
+
+    /**
+     * Computes the states reachable from `state_set` on `byte`, followed by any number of
+     * spontaneous transitions.
+     * @param state_set
+     * @param byte
+     * @param next_state_set Returns the reachable states.
+     */
+    auto get_next_state_set(StateSet const& state_set, uint8_t byte, StateSet& next_state_set)
+            -> void;
+
+    /**
+     * Adds the states reachable from `nfa_state` via spontaneous transitions, including itself, to
+     * `state_set`, unless they're already marked in `m_is_in_state_set`.
+     * @param nfa_state
+     * @param state_set Returns the set with the reachable states appended.
+     */
+    auto add_spontaneous_closure(TypedNfaState const* nfa_state, StateSet& state_set) -> void;
+
+    /**
+     * @param state_set
+     * @return The variables matched by `state_set`, in the order of their accepting NFA states.
+     */
+    [[nodiscard]] auto get_matching_variable_ids(StateSet const& state_set) const
+            -> std::vector<uint32_t>;
+
+    /**
+     * Adds a state for `state_set` to the cache.
+     * @param state_set
+     * @return The ID of the new state.
+     */
+    auto add_state(StateSet state_set) -> state_id_t;
+
+    /**
+     * Removes every state from the cache except the dead state and the root, and then re-adds
+     * `state`. Switches to simulating the NFA if this was the last unproductive flush allowed.
+     * @param state Returns the ID of the same state in the flushed cache.
+     * @param num_scanned_bytes
+     */
+    auto flush(state_id_t& state, uint64_t num_scanned_bytes) -> void;
+
+    std::unique_ptr<Nfa<TypedNfaState>> m_nfa;
+    RuntimeDfa& m_cache;
+    size_t m_max_num_cached_states;
+    // Indexed by NFA state ID
+    std::vector<TypedNfaState const*> m_nfa_states;
+    StateSet m_root_state_set;
+    // Indexed by the index of each cached state
+    std::vector<StateSet> m_state_sets;
+    std::unordered_map<StateSet, state_id_t, StateSetHash> m_state_ids;
+    // Not cleared on a flush (see `get_state_key`)
+    std::unordered_map<StateSet, uint32_t, StateSetHash> m_state_keys;
+    // Scratch space for `get_next_state_set`, indexed by NFA state ID
+    std::vector<bool> m_is_in_state_set;
+    std::vector<TypedNfaState const*> m_unexplored_nfa_states;
+    StateSet m_next_state_set;
+    uint64_t m_num_flushes{0};
+    uint64_t m_num_scanned_bytes_at_flush{0};
+    uint32_t m_num_unproductive_flushes{0};
+    bool m_is_simulating_nfa{false};
+};
+
+template <typename TypedNfaState>
+LazyDfa<TypedNfaState>::LazyDfa(
+        std::unique_ptr<Nfa<TypedNfaState>> nfa,
+        RuntimeDfa& cache,
+        size_t const max_num_cached_states
+)
+        : m_nfa{std::move(nfa)},
+          m_cache{cache},
+          m_max_num_cached_states{std::max<size_t>(max_num_cached_states, 4)},
+          m_nfa_states(m_nfa->get_num_states(), nullptr),
+          m_is_in_state_set(m_nfa->get_num_states(), false) {
+    for (auto const* nfa_state : m_nfa->get_bfs_traversal_order()) {
+        m_nfa_states[nfa_state->get_id()] = nfa_state;
+    }
+    add_spontaneous_closure(m_nfa->get_root(), m_root_state_set);
+    for (auto const id : m_root_state_set) {
+        m_is_in_state_set[id] = false;
+    }
+    std::sort(m_root_state_set.begin(), m_root_state_set.end());
+
+    m_cache.remove_states();
+    m_state_sets.resize(1);
+    m_cache.set_root(add_state(m_root_state_set));
+}
+
+template <typename TypedNfaState>
+auto LazyDfa<TypedNfaState>::get_next_state(
+        state_id_t& state,
+        uint8_t const byte,
+        uint64_t const num_scanned_bytes
+) -> state_id_t {
+    get_next_state_set(m_state_sets[state & RuntimeDfa::cStateIndexMask], byte, m_next_state_set);
+    if (m_is_simulating_nfa) {
+        if (m_next_state_set.empty()) {
+            return RuntimeDfa::cDeadState;
+        }
+        auto const scratch_state{
+                cFirstScratchState == (state & RuntimeDfa::cStateIndexMask) ? cSecondScratchState
+                                                                            : cFirstScratchState
+        };
+        auto const matching_variable_ids{get_matching_variable_ids(m_next_state_set)};
+        std::swap(m_state_sets[scratch_state], m_next_state_set);
+        return m_cache.set_matching_variable_ids(scratch_state, matching_variable_ids);
+    }
+
+    auto next_state{RuntimeDfa::cDeadState};
+    if (false == m_next_state_set.empty()) {
+        if (auto const it{m_state_ids.find(m_next_state_set)}; m_state_ids.end() != it) {
+            next_state = it->second;
+        } else {
+            if (m_cache.get_num_states() >= m_max_num_cached_states) {
+                flush(state, num_scanned_bytes);
+                if (m_is_simulating_nfa) {
+                    return get_next_state(state, byte, num_scanned_bytes);
+                }
+            }
+            next_state = add_state(std::move(m_next_state_set));
+        }
+    }
+    m_cache.set_next_state(m_cache.get_transition_idx(state, byte), next_state);
+    return next_state;
+}
+
+template <typename TypedNfaState>
+auto LazyDfa<TypedNfaState>::get_bytes_leaving_root() const -> std::array<bool, cSizeOfByte> {
+    std::array<bool, cSizeOfByte> is_leaving_root{};
+    for (auto const id : m_root_state_set) {
+        for (auto const& interval : m_nfa_states[id]->get_byte_transition_intervals()) {
+            std::fill(
+                    is_leaving_root.begin() + interval.m_first,
+                    is_leaving_root.begin() + interval.m_last + 1,
+                    true
+            );
+        }
+    }
+    return is_leaving_root;
+}
+
+template <typename TypedNfaState>
+auto LazyDfa<TypedNfaState>::get_next_state_set(
+        StateSet const& state_set,
+        uint8_t const byte,
+        StateSet& next_state_set
+) -> void {
+    next_state_set.clear();
+    for (auto const id : state_set) {
+        for (auto const* dest_state : m_nfa_states[id]->get_byte_transitions(byte)) {
+            add_spontaneous_closure(dest_state, next_state_set);
+        }
+    }
+    for (auto const id : next_state_set) {
+        m_is_in_state_set[id] = false;
+    }
+    std::sort(next_state_set.begin(), next_state_set.end());
+}
+
+template <typename TypedNfaState>
+auto LazyDfa<TypedNfaState>::add_spontaneous_closure(
+        TypedNfaState const* nfa_state,
+        StateSet& state_set
+) -> void {
+    m_unexplored_nfa_states.push_back(nfa_state);
+    while (false == m_unexplored_nfa_states.empty()) {
+        auto const* current_state{m_unexplored_nfa_states.back()};
+        m_unexplored_nfa_states.pop_back();
+        if (m_is_in_state_set[current_state->get_id()]) {
+            continue;
+        }
+        m_is_in_state_set[current_state->get_id()] = true;
+        state_set.push_back(current_state->get_id());
+        for (auto const& spontaneous_transition : current_state->get_spontaneous_transitions()) {
+            m_unexplored_nfa_states.push_back(spontaneous_transition.get_dest_state());
+        }
+    }
+}
+
+template <typename TypedNfaState>
+auto LazyDfa<TypedNfaState>::get_matching_variable_ids(StateSet const& state_set) const
+        -> std::vector<uint32_t> {
+    std::vector<uint32_t> matching_variable_ids;
+    for (auto const id : state_set) {
+        if (m_nfa_states[id]->is_accepting()) {
+            matching_variable_ids.push_back(m_nfa_states[id]->get_matching_variable_id());
+        }
+    }
+    return matching_variable_ids;
+}
+
+template <typename TypedNfaState>
+auto LazyDfa<TypedNfaState>::add_state(StateSet state_set) -> state_id_t {
+    auto const state{m_cache.add_state(get_matching_variable_ids(state_set))};
+    m_state_ids.try_emplace(state_set, state);
+    m_state_sets.push_back(std::move(state_set));
+    return state;
+}
+
+template <typename TypedNfaState>
+auto LazyDfa<TypedNfaState>::flush(state_id_t& state, uint64_t const num_scanned_bytes) -> void {
+    if (num_scanned_bytes - m_num_scanned_bytes_at_flush
+        < cMinNumScannedBytesPerState * m_cache.get_num_states())
+    {
+        ++m_num_unproductive_flushes;
+    } else {
+        m_num_unproductive_flushes = 0;
+    }
+    m_num_scanned_bytes_at_flush = num_scanned_bytes;
+    ++m_num_flushes;
+
+    auto const is_root{m_cache.get_root() == state};
+    auto state_set{std::move(m_state_sets[state & RuntimeDfa::cStateIndexMask])};
+    m_cache.remove_states();
+    m_state_sets.resize(1);
+    m_state_ids.clear();
+    m_cache.set_root(add_state(m_root_state_set));
+    state = is_root ? m_cache.get_root() : add_state(std::move(state_set));
+
+    if (m_num_unproductive_flushes >= cMaxNumUnproductiveFlushes) {
+        // Neither the scratch states' nor the root's transitions are cached from now on
+        m_is_simulating_nfa = true;
+        while (m_cache.get_num_states() <= cSecondScratchState) {
+            add_state({});
+        }
+    }
+}
+}  // namespace log_surgeon::finite_automata
+
+#endif  // LOG_SURGEON_FINITE_AUTOMATA_LAZY_DFA_HPP
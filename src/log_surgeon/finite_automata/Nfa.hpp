@@ -99,6 +99,8 @@ public:
 
     auto get_root() const -> TypedNfaState* { return m_root; }
 
+    [[nodiscard]] auto get_num_states() const -> size_t { return m_states.size(); }
+
     [[nodiscard]] auto get_num_tags() const -> uint32_t { return m_tag_id_generator.get_num_ids(); }
 
     [[nodiscard]] auto get_capture_to_tag_id_pair() const
@@ -106,6 +108,12 @@ public:
         return m_capture_to_tag_id_pair;
     }
 
+    /**
+     * @return Whether each tag, indexed by ID, is multi-valued, i.e., whether any of its operations
+     * is in a repetition, so that a match may need more than one of its positions.
+     */
+    [[nodiscard]] auto get_multi_valued_tags() const -> std::vector<bool>;
+
 private:
     /**
      * Creates start and end tags for the specified capture if they don't currently exist.
@@ -236,8 +244,8 @@ auto Nfa<TypedNfaState>::get_bfs_traversal_order() const -> std::vector<TypedNfa
         visited_order.push_back(current_state);
         state_queue.pop();
         // TODO: handle the utf8 case
-        for (uint32_t idx{0}; idx < cSizeOfByte; ++idx) {
-            for (auto const* dest_state : current_state->get_byte_transitions(idx)) {
+        for (auto const& interval : current_state->get_byte_transition_intervals()) {
+            for (auto const* dest_state : interval.m_dest_states) {
                 add_to_queue_and_visited(dest_state);
             }
         }
@@ -248,6 +256,21 @@ auto Nfa<TypedNfaState>::get_bfs_traversal_order() const -> std::vector<TypedNfa
     return visited_order;
 }
 
+template <typename TypedNfaState>
+auto Nfa<TypedNfaState>::get_multi_valued_tags() const -> std::vector<bool> {
+    std::vector<bool> multi_valued_tags(get_num_tags(), false);
+    for (auto const& state : m_states) {
+        for (auto const& spontaneous_transition : state->get_spontaneous_transitions()) {
+            for (auto const tag_op : spontaneous_transition.get_tag_ops()) {
+                if (tag_op.is_multi_valued()) {
+                    multi_valued_tags[tag_op.get_tag_id()] = true;
+                }
+            }
+        }
+    }
+    return multi_valued_tags;
+}
+
 template <typename TypedNfaState>
 auto Nfa<TypedNfaState>::serialize() const -> std::optional<std::string> {
     auto const traversal_order = get_bfs_traversal_order();
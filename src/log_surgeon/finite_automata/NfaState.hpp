@@ -4,6 +4,7 @@
 #include <algorithm>
 #include <array>
 #include <cstdint>
+#include <iterator>
 #include <memory>
 #include <optional>
 #include <string>
@@ -48,6 +49,15 @@ class NfaState {
 public:
     using Tree = UnicodeIntervalTree<NfaState*>;
 
+    /**
+     * The transitions on every byte in [m_first, m_last], which all lead to the same states.
+     */
+    struct ByteTransitionInterval {
+        uint8_t m_first;
+        uint8_t m_last;
+        std::vector<NfaState*> m_dest_states;
+    };
+
     explicit NfaState(state_id_t const id) : m_id{id} {}
 
     NfaState(state_id_t const id, uint32_t const matching_variable_id)
@@ -84,10 +94,19 @@ public:
         m_spontaneous_transitions.emplace_back(std::move(tag_ops), dest_state);
     }
 
-    auto add_byte_transition(uint8_t byte, NfaState* dest_state) -> void {
-        m_bytes_transitions.at(byte).push_back(dest_state);
+    auto add_byte_transition(uint8_t const byte, NfaState* dest_state) -> void {
+        add_byte_interval(byte, byte, dest_state);
     }
 
+    /**
+     * Adds a transition on every byte in [first, last], splitting the existing intervals that
+     * partially overlap it.
+     * @param first
+     * @param last
+     * @param dest_state
+     */
+    auto add_byte_interval(uint8_t first, uint8_t last, NfaState* dest_state) -> void;
+
     /**
      * Adds an interval-based transition to the appropriate transition set.
      * @param interval The interval representing the transition condition.
@@ -118,10 +137,21 @@ public:
         return m_spontaneous_transitions;
     }
 
-    [[nodiscard]] auto get_byte_transitions(uint8_t byte) const -> std::vector<NfaState*> const& {
-        return m_bytes_transitions.at(byte);
+    /**
+     * @return The byte transitions as disjoint intervals in ascending order. Bytes without any
+     * transitions aren't in any interval.
+     */
+    [[nodiscard]] auto get_byte_transition_intervals() const
+            -> std::vector<ByteTransitionInterval> const& {
+        return m_byte_transition_intervals;
     }
 
+    /**
+     * @param byte
+     * @return The destination states of the transitions on `byte`, in the order they were added.
+     */
+    [[nodiscard]] auto get_byte_transitions(uint8_t byte) const -> std::vector<NfaState*> const&;
+
     [[nodiscard]] auto get_tree_transitions() -> Tree const& { return m_tree_transitions; }
 
 private:
@@ -129,19 +159,92 @@ private:
     bool m_accepting{false};
     uint32_t m_matching_variable_id{0};
     std::vector<NfaSpontaneousTransition<NfaState>> m_spontaneous_transitions;
-    std::array<std::vector<NfaState*>, cSizeOfByte> m_bytes_transitions;
+    std::vector<ByteTransitionInterval> m_byte_transition_intervals;
     // NOTE: We don't need `m_tree_transitions` for the `stateType == StateType::Byte`, so we us an
     // empty class (`std::tuple<>`) in that case.
     std::conditional_t<state_type == StateType::Utf8, Tree, std::tuple<>> m_tree_transitions;
 };
 
+template <StateType state_type>
+auto NfaState<state_type>::add_byte_interval(
+        uint8_t const first,
+        uint8_t const last,
+        NfaState* dest_state
+) -> void {
+    std::vector<ByteTransitionInterval> intervals;
+    intervals.reserve(m_byte_transition_intervals.size() + 2);
+    // The first byte in [first, last] that isn't covered by `intervals` yet
+    uint32_t next_uncovered{first};
+    for (auto& interval : m_byte_transition_intervals) {
+        if (interval.m_last < first) {
+            intervals.push_back(std::move(interval));
+            continue;
+        }
+        if (interval.m_first > last) {
+            if (next_uncovered <= last) {
+                intervals.push_back({static_cast<uint8_t>(next_uncovered), last, {dest_state}});
+                next_uncovered = last + 1U;
+            }
+            intervals.push_back(std::move(interval));
+            continue;
+        }
+        if (interval.m_first < first) {
+            intervals.push_back(
+                    {interval.m_first, static_cast<uint8_t>(first - 1U), interval.m_dest_states}
+            );
+        } else if (next_uncovered < interval.m_first) {
+            intervals.push_back(
+                    {static_cast<uint8_t>(next_uncovered),
+                     static_cast<uint8_t>(interval.m_first - 1U),
+                     {dest_state}}
+            );
+        }
+        auto const overlap_last{std::min(interval.m_last, last)};
+        auto overlap_dest_states{interval.m_dest_states};
+        overlap_dest_states.push_back(dest_state);
+        intervals.push_back(
+                {std::max(interval.m_first, first), overlap_last, std::move(overlap_dest_states)}
+        );
+        if (interval.m_last > last) {
+            intervals.push_back(
+                    {static_cast<uint8_t>(last + 1U),
+                     interval.m_last,
+                     std::move(interval.m_dest_states)}
+            );
+        }
+        next_uncovered = overlap_last + 1U;
+    }
+    if (next_uncovered <= last) {
+        intervals.push_back({static_cast<uint8_t>(next_uncovered), last, {dest_state}});
+    }
+    m_byte_transition_intervals = std::move(intervals);
+}
+
+template <StateType state_type>
+auto NfaState<state_type>::get_byte_transitions(uint8_t const byte) const
+        -> std::vector<NfaState*> const& {
+    static std::vector<NfaState*> const cNoDestStates;
+    auto const it{std::upper_bound(
+            m_byte_transition_intervals.cbegin(),
+            m_byte_transition_intervals.cend(),
+            byte,
+            [](uint8_t const lhs, ByteTransitionInterval const& rhs) { return lhs < rhs.m_first; }
+    )};
+    if (m_byte_transition_intervals.cbegin() == it || std::prev(it)->m_last < byte) {
+        return cNoDestStates;
+    }
+    return std::prev(it)->m_dest_states;
+}
+
 template <StateType state_type>
 auto NfaState<state_type>::add_interval(Interval interval, NfaState* dest_state) -> void {
     if (interval.first < cSizeOfByte) {
         uint32_t const bound = std::min(interval.second, cSizeOfByte - 1);
-        for (uint32_t i = interval.first; i <= bound; i++) {
-            add_byte_transition(i, dest_state);
-        }
+        add_byte_interval(
+                static_cast<uint8_t>(interval.first),
+                static_cast<uint8_t>(bound),
+                dest_state
+        );
         interval.first = bound + 1;
     }
     if constexpr (StateType::Utf8 == state_type) {
@@ -191,11 +294,13 @@ auto NfaState<state_type>::serialize(
     };
 
     std::vector<std::string> byte_transitions;
-    for (uint32_t idx{0}; idx < cSizeOfByte; ++idx) {
-        for (auto const* dest_state : m_bytes_transitions.at(idx)) {
-            byte_transitions.emplace_back(
-                    fmt::format("{}-->{}", static_cast<char>(idx), state_ids.at(dest_state))
-            );
+    for (auto const& [first, last, dest_states] : m_byte_transition_intervals) {
+        for (uint32_t idx{first}; idx <= last; ++idx) {
+            for (auto const* dest_state : dest_states) {
+                byte_transitions.emplace_back(
+                        fmt::format("{}-->{}", static_cast<char>(idx), state_ids.at(dest_state))
+                );
+            }
         }
     }
 
@@ -49,6 +49,11 @@ public:
 
     [[nodiscard]] auto size() const -> size_t { return m_nodes.size(); }
 
+    /**
+     * Removes every node except the root, keeping the allocated storage for reuse.
+     */
+    auto reset() -> void { m_nodes.erase(m_nodes.begin() + 1, m_nodes.end()); }
+
     /**
      * @param node_id The index of the node.
      * @return A vector containing positions in order from the given index up to but not including
@@ -57,6 +62,15 @@ public:
      */
     [[nodiscard]] auto get_reversed_positions(id_t node_id) const -> std::vector<position_t>;
 
+    /**
+     * Like `get_reversed_positions`, but appends the positions to an existing vector.
+     * @param node_id The index of the node.
+     * @param reversed_positions Returns the vector with the positions appended.
+     * @throw std::out_of_range if the index is out of range.
+     */
+    auto append_reversed_positions(id_t node_id, std::vector<position_t>& reversed_positions) const
+            -> void;
+
 private:
     class Node {
     public:
@@ -6,6 +6,7 @@
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <memory>
 #include <ranges>
 #include <stdexcept>
@@ -28,6 +29,11 @@ namespace log_surgeon::finite_automata {
 template <typename TypedNfaState>
 class Nfa;
 
+/**
+ * Sets of bytes such that a string must contain at least one byte from each set.
+ */
+using RequiredByteSets = std::vector<std::array<bool, cSizeOfByte>>;
+
 // TODO: rename `RegexAST` to `RegexASTNode`
 /**
  * Base class for a Regex AST node.
@@ -97,6 +103,29 @@ public:
      */
     [[nodiscard]] virtual auto serialize() const -> std::u32string = 0;
 
+    /**
+     * Derives byte sets that every string matched by the AST must contain at least one byte of,
+     * e.g., "must contain `=`" or "must contain a digit". The sets are only a necessary condition
+     * for a match. To hold for both byte and UTF-8 lexing, only ASCII characters are considered.
+     * @return The required byte sets, of which there are at most `cMaxNumRequiredByteSets`.
+     */
+    [[nodiscard]] virtual auto get_required_byte_sets() const -> RequiredByteSets = 0;
+
+    /**
+     * Computes the number of states `add_to_nfa` adds to an NFA without building them, so that
+     * oversized rules (e.g., nested counted repetitions) can be rejected before construction.
+     * @return The number of NFA states, saturating at `cMaxNumNfaStates`.
+     */
+    [[nodiscard]] virtual auto get_num_nfa_states() const -> uint64_t = 0;
+
+    /**
+     * @return The number of NFA states `add_to_nfa_with_negative_captures` adds to an NFA,
+     * saturating at `cMaxNumNfaStates`.
+     */
+    [[nodiscard]] auto get_num_nfa_states_with_negative_captures() const -> uint64_t {
+        return add_num_nfa_states(get_num_nfa_states(), m_negative_captures.empty() ? 0 : 1);
+    }
+
     [[nodiscard]] auto get_subtree_positive_captures() const -> std::vector<Capture const*> const& {
         return m_subtree_positive_captures;
     }
@@ -151,6 +180,29 @@ public:
         }
     }
 
+    static constexpr size_t cMaxNumRequiredByteSets{8};
+    static constexpr uint64_t cMaxNumNfaStates{std::numeric_limits<uint64_t>::max()};
+
+    /**
+     * @param lhs
+     * @param rhs
+     * @return `lhs + rhs`, saturating at `cMaxNumNfaStates`.
+     */
+    [[nodiscard]] static auto add_num_nfa_states(uint64_t const lhs, uint64_t const rhs)
+            -> uint64_t {
+        return lhs > cMaxNumNfaStates - rhs ? cMaxNumNfaStates : lhs + rhs;
+    }
+
+    /**
+     * @param lhs
+     * @param rhs
+     * @return `lhs * rhs`, saturating at `cMaxNumNfaStates`.
+     */
+    [[nodiscard]] static auto multiply_num_nfa_states(uint64_t const lhs, uint64_t const rhs)
+            -> uint64_t {
+        return 0 != rhs && lhs > cMaxNumNfaStates / rhs ? cMaxNumNfaStates : lhs * rhs;
+    }
+
 protected:
     RegexAST(RegexAST const& rhs) = default;
     auto operator=(RegexAST const& rhs) -> RegexAST& = default;
@@ -177,6 +229,13 @@ protected:
         );
     }
 
+    /**
+     * Removes duplicate and redundant sets, keeping at most `cMaxNumRequiredByteSets` of the
+     * smallest sets, as they are the least likely to be satisfied by chance.
+     * @param required_byte_sets
+     */
+    static auto limit_required_byte_sets(RequiredByteSets& required_byte_sets) -> void;
+
 private:
     std::vector<Capture const*> m_subtree_positive_captures;
     std::vector<Capture const*> m_negative_captures;
@@ -218,6 +277,10 @@ public:
     }
 
     [[nodiscard]] auto serialize() const -> std::u32string override;
+
+    [[nodiscard]] auto get_required_byte_sets() const -> RequiredByteSets override { return {}; }
+
+    [[nodiscard]] auto get_num_nfa_states() const -> uint64_t override { return 0; }
 };
 
 template <typename TypedNfaState>
@@ -261,6 +324,10 @@ public:
 
     [[nodiscard]] auto serialize() const -> std::u32string override;
 
+    [[nodiscard]] auto get_required_byte_sets() const -> RequiredByteSets override;
+
+    [[nodiscard]] auto get_num_nfa_states() const -> uint64_t override { return 0; }
+
     [[nodiscard]] auto get_character() const -> uint32_t const& { return m_character; }
 
 private:
@@ -312,6 +379,10 @@ public:
 
     [[nodiscard]] auto serialize() const -> std::u32string override;
 
+    [[nodiscard]] auto get_required_byte_sets() const -> RequiredByteSets override;
+
+    [[nodiscard]] auto get_num_nfa_states() const -> uint64_t override { return 0; }
+
     [[nodiscard]] auto get_digits() const -> std::vector<uint32_t> const& { return m_digits; }
 
     [[nodiscard]] auto get_digit(uint32_t i) const -> uint32_t const& { return m_digits[i]; }
@@ -418,6 +489,10 @@ public:
 
     [[nodiscard]] auto serialize() const -> std::u32string override;
 
+    [[nodiscard]] auto get_required_byte_sets() const -> RequiredByteSets override;
+
+    [[nodiscard]] auto get_num_nfa_states() const -> uint64_t override { return 0; }
+
     auto add_range(uint32_t min, uint32_t max) -> void { m_ranges.emplace_back(min, max); }
 
     auto add_literal(uint32_t literal) -> void { m_ranges.emplace_back(literal, literal); }
@@ -503,6 +578,15 @@ public:
 
     [[nodiscard]] auto serialize() const -> std::u32string override;
 
+    [[nodiscard]] auto get_required_byte_sets() const -> RequiredByteSets override;
+
+    [[nodiscard]] auto get_num_nfa_states() const -> uint64_t override {
+        return RegexAST<TypedNfaState>::add_num_nfa_states(
+                m_left->get_num_nfa_states_with_negative_captures(),
+                m_right->get_num_nfa_states_with_negative_captures()
+        );
+    }
+
     [[nodiscard]] auto get_left() const -> RegexAST<TypedNfaState> const* { return m_left.get(); }
 
     [[nodiscard]] auto get_right() const -> RegexAST<TypedNfaState> const* { return m_right.get(); }
@@ -564,6 +648,19 @@ public:
 
     [[nodiscard]] auto serialize() const -> std::u32string override;
 
+    [[nodiscard]] auto get_required_byte_sets() const -> RequiredByteSets override;
+
+    // The state between the left and right operands, and the states of the operands
+    [[nodiscard]] auto get_num_nfa_states() const -> uint64_t override {
+        return RegexAST<TypedNfaState>::add_num_nfa_states(
+                1,
+                RegexAST<TypedNfaState>::add_num_nfa_states(
+                        m_left->get_num_nfa_states_with_negative_captures(),
+                        m_right->get_num_nfa_states_with_negative_captures()
+                )
+        );
+    }
+
     [[nodiscard]] auto get_left() const -> RegexAST<TypedNfaState> const* { return m_left.get(); }
 
     [[nodiscard]] auto get_right() const -> RegexAST<TypedNfaState> const* { return m_right.get(); }
@@ -618,6 +715,16 @@ public:
         m_operand->remove_delimiters_from_wildcard(delimiters);
     }
 
+    /**
+     * Adds the repetition to the NFA. A bounded repetition of an operand without captures is built
+     * as a chain of `m_max` operand copies, where every copy from the `m_min`th one on can skip to
+     * `end_state`. Otherwise, every optional repetition needs two copies of the operand, one
+     * leading to `end_state` and one leading to the next repetition, so that the tags of every
+     * repetition are tracked separately.
+     * @param nfa
+     * @param end_state
+     * @param descendent_of_repetition
+     */
     auto add_to_nfa(
             Nfa<TypedNfaState>* nfa,
             TypedNfaState* end_state,
@@ -626,6 +733,15 @@ public:
 
     [[nodiscard]] auto serialize() const -> std::u32string override;
 
+    [[nodiscard]] auto get_num_nfa_states() const -> uint64_t override;
+
+    [[nodiscard]] auto get_required_byte_sets() const -> RequiredByteSets override {
+        if (0 == m_min) {
+            return {};
+        }
+        return m_operand->get_required_byte_sets();
+    }
+
     [[nodiscard]] auto is_infinite() const -> bool { return m_max == 0; }
 
     [[nodiscard]] auto get_operand() const -> std::unique_ptr<RegexAST<TypedNfaState>> const& {
@@ -636,6 +752,13 @@ public:
 
     [[nodiscard]] auto get_max() const -> uint32_t { return m_max; }
 
+    /**
+     * @return Whether the repetition is built as a chain of operand copies (see `add_to_nfa`).
+     */
+    [[nodiscard]] auto is_chained() const -> bool {
+        return false == is_infinite() && m_operand->get_subtree_positive_captures().empty();
+    }
+
 private:
     std::unique_ptr<RegexAST<TypedNfaState>> m_operand;
     uint32_t m_min;
@@ -722,6 +845,18 @@ public:
 
     [[nodiscard]] auto serialize() const -> std::u32string override;
 
+    [[nodiscard]] auto get_required_byte_sets() const -> RequiredByteSets override {
+        return m_capture_regex_ast->get_required_byte_sets();
+    }
+
+    // The states that set the start and end tags, and the states of the captured regex
+    [[nodiscard]] auto get_num_nfa_states() const -> uint64_t override {
+        return RegexAST<TypedNfaState>::add_num_nfa_states(
+                2,
+                m_capture_regex_ast->get_num_nfa_states_with_negative_captures()
+        );
+    }
+
     [[nodiscard]] auto get_capture_name() const -> std::string_view {
         return m_capture->get_name();
     }
@@ -736,6 +871,37 @@ private:
     std::unique_ptr<Capture> m_capture;
 };
 
+template <typename TypedNfaState>
+auto RegexAST<TypedNfaState>::limit_required_byte_sets(RequiredByteSets& required_byte_sets)
+        -> void {
+    auto const get_size{[](std::array<bool, cSizeOfByte> const& byte_set) -> size_t {
+        return std::ranges::count(byte_set, true);
+    }};
+    std::ranges::stable_sort(required_byte_sets, {}, get_size);
+    RequiredByteSets limited_byte_sets;
+    for (auto const& byte_set : required_byte_sets) {
+        if (cMaxNumRequiredByteSets == limited_byte_sets.size()) {
+            break;
+        }
+        // A superset of an already required set is implied by it
+        auto const is_implied{std::ranges::any_of(
+                limited_byte_sets,
+                [&](std::array<bool, cSizeOfByte> const& subset) -> bool {
+                    for (size_t byte{0}; byte < cSizeOfByte; ++byte) {
+                        if (subset[byte] && false == byte_set[byte]) {
+                            return false;
+                        }
+                    }
+                    return true;
+                }
+        )};
+        if (false == is_implied) {
+            limited_byte_sets.push_back(byte_set);
+        }
+    }
+    required_byte_sets = std::move(limited_byte_sets);
+}
+
 template <typename TypedNfaState>
 [[nodiscard]] auto RegexASTEmpty<TypedNfaState>::serialize() const -> std::u32string {
     return fmt::format(U"{}", RegexAST<TypedNfaState>::serialize_negative_captures());
@@ -762,6 +928,16 @@ template <typename TypedNfaState>
     );
 }
 
+template <typename TypedNfaState>
+auto RegexASTLiteral<TypedNfaState>::get_required_byte_sets() const -> RequiredByteSets {
+    if (m_character > cAsciiMax) {
+        return {};
+    }
+    std::array<bool, cSizeOfByte> byte_set{};
+    byte_set[m_character] = true;
+    return {byte_set};
+}
+
 template <typename TypedNfaState>
 RegexASTInteger<TypedNfaState>::RegexASTInteger(uint32_t digit) {
     digit = digit - '0';
@@ -794,6 +970,18 @@ template <typename TypedNfaState>
     );
 }
 
+template <typename TypedNfaState>
+auto RegexASTInteger<TypedNfaState>::get_required_byte_sets() const -> RequiredByteSets {
+    RequiredByteSets required_byte_sets;
+    for (auto const digit : m_digits) {
+        std::array<bool, cSizeOfByte> byte_set{};
+        byte_set['0' + digit] = true;
+        required_byte_sets.push_back(byte_set);
+    }
+    RegexAST<TypedNfaState>::limit_required_byte_sets(required_byte_sets);
+    return required_byte_sets;
+}
+
 template <typename TypedNfaState>
 RegexASTOr<TypedNfaState>::RegexASTOr(
         std::unique_ptr<RegexAST<TypedNfaState>> left,
@@ -829,6 +1017,24 @@ template <typename TypedNfaState>
     );
 }
 
+template <typename TypedNfaState>
+auto RegexASTOr<TypedNfaState>::get_required_byte_sets() const -> RequiredByteSets {
+    // A string matched by either side contains a byte from the union of one set from each side
+    auto const left_byte_sets{m_left->get_required_byte_sets()};
+    auto const right_byte_sets{m_right->get_required_byte_sets()};
+    RequiredByteSets required_byte_sets;
+    for (auto const& left_byte_set : left_byte_sets) {
+        for (auto const& right_byte_set : right_byte_sets) {
+            auto& byte_set{required_byte_sets.emplace_back()};
+            for (size_t byte{0}; byte < cSizeOfByte; ++byte) {
+                byte_set[byte] = left_byte_set[byte] || right_byte_set[byte];
+            }
+        }
+    }
+    RegexAST<TypedNfaState>::limit_required_byte_sets(required_byte_sets);
+    return required_byte_sets;
+}
+
 template <typename TypedNfaState>
 RegexASTCat<TypedNfaState>::RegexASTCat(
         std::unique_ptr<RegexAST<TypedNfaState>> left,
@@ -866,6 +1072,19 @@ template <typename TypedNfaState>
     );
 }
 
+template <typename TypedNfaState>
+auto RegexASTCat<TypedNfaState>::get_required_byte_sets() const -> RequiredByteSets {
+    auto required_byte_sets{m_left->get_required_byte_sets()};
+    auto const right_byte_sets{m_right->get_required_byte_sets()};
+    required_byte_sets.insert(
+            required_byte_sets.end(),
+            right_byte_sets.cbegin(),
+            right_byte_sets.cend()
+    );
+    RegexAST<TypedNfaState>::limit_required_byte_sets(required_byte_sets);
+    return required_byte_sets;
+}
+
 template <typename TypedNfaState>
 RegexASTMultiplication<TypedNfaState>::RegexASTMultiplication(
         std::unique_ptr<RegexAST<TypedNfaState>> operand,
@@ -887,6 +1106,18 @@ void RegexASTMultiplication<TypedNfaState>::add_to_nfa(
         [[maybe_unused]] bool const descendent_of_repetition
 ) const {
     TypedNfaState* saved_root = nfa->get_root();
+    if (is_chained()) {
+        for (uint32_t i{0}; i < m_max; ++i) {
+            if (i >= m_min) {
+                nfa->get_root()->add_spontaneous_transition(end_state);
+            }
+            auto* next_state{i + 1 == m_max ? end_state : nfa->new_state()};
+            m_operand->add_to_nfa_with_negative_captures(nfa, next_state, true);
+            nfa->set_root(next_state);
+        }
+        nfa->set_root(saved_root);
+        return;
+    }
     if (m_min == 0) {
         nfa->get_root()->add_spontaneous_transition(end_state);
     } else {
@@ -917,6 +1148,32 @@ void RegexASTMultiplication<TypedNfaState>::add_to_nfa(
     nfa->set_root(saved_root);
 }
 
+template <typename TypedNfaState>
+auto RegexASTMultiplication<TypedNfaState>::get_num_nfa_states() const -> uint64_t {
+    auto const add{RegexAST<TypedNfaState>::add_num_nfa_states};
+    auto const multiply{RegexAST<TypedNfaState>::multiply_num_nfa_states};
+    auto const num_operand_states{m_operand->get_num_nfa_states_with_negative_captures()};
+    if (is_chained()) {
+        // `m_max` operand copies with a state between every two consecutive ones
+        return add(multiply(m_max, num_operand_states), m_max - 1);
+    }
+
+    // Mirrors the copies and intermediate states added by `add_to_nfa`
+    uint64_t num_copies{m_min};
+    uint64_t num_intermediate_states{0 == m_min ? 0 : m_min - 1};
+    if (is_infinite()) {
+        ++num_copies;
+    } else if (m_max > m_min) {
+        if (0 != m_min) {
+            ++num_copies;
+            ++num_intermediate_states;
+        }
+        num_copies += 2 * static_cast<uint64_t>(m_max - m_min - 1) + 1;
+        num_intermediate_states += m_max - m_min - 1;
+    }
+    return add(multiply(num_copies, num_operand_states), num_intermediate_states);
+}
+
 template <typename TypedNfaState>
 [[nodiscard]] auto RegexASTMultiplication<TypedNfaState>::serialize() const -> std::u32string {
     auto const min_string = std::to_string(m_min);
@@ -1127,6 +1384,26 @@ void RegexASTGroup<TypedNfaState>::add_to_nfa(
     }
 }
 
+template <typename TypedNfaState>
+auto RegexASTGroup<TypedNfaState>::get_required_byte_sets() const -> RequiredByteSets {
+    auto merged_ranges{m_ranges};
+    std::sort(merged_ranges.begin(), merged_ranges.end());
+    merged_ranges = merge(merged_ranges);
+    if (m_negate) {
+        merged_ranges = complement(merged_ranges);
+    }
+    std::array<bool, cSizeOfByte> byte_set{};
+    for (auto const& [begin, end] : merged_ranges) {
+        if (end > cAsciiMax) {
+            return {};
+        }
+        for (uint32_t i{begin}; i <= end; ++i) {
+            byte_set[i] = true;
+        }
+    }
+    return {byte_set};
+}
+
 template <typename TypedNfaState>
 [[nodiscard]] auto RegexASTGroup<TypedNfaState>::serialize() const -> std::u32string {
     std::u32string ranges_serialized;
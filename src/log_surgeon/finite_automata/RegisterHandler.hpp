@@ -1,10 +1,14 @@
 #ifndef LOG_SURGEON_FINITE_AUTOMATA_REGISTER_HANDLER_HPP
 #define LOG_SURGEON_FINITE_AUTOMATA_REGISTER_HANDLER_HPP
 
+#include <algorithm>
 #include <cstdint>
+#include <span>
+#include <stdexcept>
 #include <vector>
 
 #include <log_surgeon/finite_automata/PrefixTree.hpp>
+#include <log_surgeon/finite_automata/RegisterOperation.hpp>
 #include <log_surgeon/types.hpp>
 
 namespace log_surgeon::finite_automata {
@@ -13,21 +17,28 @@ namespace log_surgeon::finite_automata {
  * The register handler also contains a vector of registers, and performs the set, copy, and append
  * operations for these registers.
  *
+ * A multi-valued register holds a node of the prefix tree, so that appending a position keeps the
+ * previous ones. A single-valued register, i.e., one whose tag isn't in a repetition, only needs
+ * its last position, so it holds the position itself and appending replaces it without touching
+ * the prefix tree.
+ *
  * NOTE: For efficiency, registers are not initialized when lexing a new string; instead, it is the
  * DFA's responsibility to set the register values when needed.
  */
 class RegisterHandler {
 public:
-    auto add_registers(uint32_t const num_reg_to_add) -> std::vector<uint32_t> {
+    auto add_registers(uint32_t const num_reg_to_add, bool const multi_valued = true)
+            -> std::vector<uint32_t> {
         std::vector<uint32_t> added_registers;
         for (uint32_t i{0}; i < num_reg_to_add; ++i) {
-            added_registers.emplace_back(add_register());
+            added_registers.emplace_back(add_register(multi_valued));
         }
         return added_registers;
     }
 
-    auto add_register() -> reg_id_t {
+    auto add_register(bool const multi_valued = true) -> reg_id_t {
         m_registers.emplace_back(PrefixTree::cRootId);
+        m_multi_valued_regs.push_back(multi_valued);
         return m_registers.size() - 1;
     }
 
@@ -36,21 +47,102 @@ public:
     }
 
     auto append_position(reg_id_t const reg_id, PrefixTree::position_t const position) -> void {
-        auto const node_id{m_registers.at(reg_id)};
-        m_registers.at(reg_id) = m_prefix_tree.insert(node_id, position);
+        auto& value{m_registers.at(reg_id)};
+        if (m_multi_valued_regs[reg_id]) {
+            value = m_prefix_tree.insert(value, position);
+        } else {
+            value = static_cast<PrefixTree::id_t>(position) + cSingleValueOffset;
+        }
     }
 
+    /**
+     * Applies register operations in order.
+     * @param reg_ops The register operations to apply.
+     * @param curr_pos The position set operations append.
+     * @throws `std::logic_error` if copy operation has no source register.
+     * @throws `std::logic_error` if register operation has unhandlded type.
+     */
+    auto process_reg_ops(std::span<RegisterOperation const> reg_ops, uint32_t curr_pos) -> void;
+
     [[nodiscard]] auto get_reversed_positions(reg_id_t const reg_id) const
             -> std::vector<PrefixTree::position_t> {
-        return m_prefix_tree.get_reversed_positions(m_registers.at(reg_id));
+        std::vector<PrefixTree::position_t> reversed_positions;
+        append_reversed_positions(reg_id, reversed_positions);
+        return reversed_positions;
+    }
+
+    /**
+     * Like `get_reversed_positions`, but appends the positions to an existing vector.
+     * @param reg_id
+     * @param reversed_positions Returns the vector with the positions appended.
+     */
+    auto append_reversed_positions(
+            reg_id_t const reg_id,
+            std::vector<PrefixTree::position_t>& reversed_positions
+    ) const -> void {
+        auto const value{m_registers.at(reg_id)};
+        if (m_multi_valued_regs[reg_id]) {
+            m_prefix_tree.append_reversed_positions(value, reversed_positions);
+        } else if (PrefixTree::cRootId != value) {
+            reversed_positions.push_back(
+                    static_cast<PrefixTree::position_t>(value - cSingleValueOffset)
+            );
+        }
     }
 
     [[nodiscard]] auto get_num_regs() const -> size_t { return m_registers.size(); }
 
+    [[nodiscard]] auto is_multi_valued(reg_id_t const reg_id) const -> bool {
+        return m_multi_valued_regs.at(reg_id);
+    }
+
+    /**
+     * Resets every register to the root of an emptied prefix tree, without releasing any storage.
+     */
+    auto reset() -> void {
+        m_prefix_tree.reset();
+        std::fill(m_registers.begin(), m_registers.end(), PrefixTree::cRootId);
+    }
+
 private:
+    // A single-valued register holds its position plus this offset, so that an empty register
+    // holds `PrefixTree::cRootId` whatever its kind, and a negated position is still nonzero
+    static constexpr PrefixTree::id_t cSingleValueOffset{2};
+
     PrefixTree m_prefix_tree;
     std::vector<PrefixTree::id_t> m_registers;
+    std::vector<bool> m_multi_valued_regs;
 };
+
+inline auto RegisterHandler::process_reg_ops(
+        std::span<RegisterOperation const> const reg_ops,
+        uint32_t const curr_pos
+) -> void {
+    for (auto const& reg_op : reg_ops) {
+        switch (reg_op.get_type()) {
+            case RegisterOperation::Type::Set: {
+                append_position(reg_op.get_reg_id(), curr_pos);
+                break;
+            }
+            case RegisterOperation::Type::Negate: {
+                append_position(reg_op.get_reg_id(), -1);
+                break;
+            }
+            case RegisterOperation::Type::Copy: {
+                auto copy_reg_id_optional{reg_op.get_copy_reg_id()};
+                if (copy_reg_id_optional.has_value()) {
+                    copy_register(reg_op.get_reg_id(), copy_reg_id_optional.value());
+                } else {
+                    throw std::logic_error("Copy operation does not specify register to copy.");
+                }
+                break;
+            }
+            default: {
+                throw std::logic_error("Unhandled register operation type when simulating DFA.");
+            }
+        }
+    }
+}
 }  // namespace log_surgeon::finite_automata
 
 #endif  // LOG_SURGEON_FINITE_AUTOMATA_REGISTER_HANDLER_HPP
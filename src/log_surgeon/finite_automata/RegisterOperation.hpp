@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <optional>
 #include <string>
+#include <tuple>
 
 #include <log_surgeon/types.hpp>
 
@@ -29,6 +30,11 @@ public:
                && m_copy_reg_id == rhs.m_copy_reg_id;
     }
 
+    [[nodiscard]] auto operator<(RegisterOperation const& rhs) const -> bool {
+        return std::tie(m_reg_id, m_type, m_copy_reg_id)
+               < std::tie(rhs.m_reg_id, rhs.m_type, rhs.m_copy_reg_id);
+    }
+
     static auto create_set_operation(reg_id_t const reg_id) -> RegisterOperation {
         return {reg_id, Type::Set};
     }
@@ -0,0 +1,87 @@
+#ifndef LOG_SURGEON_FINITE_AUTOMATA_REGISTER_REPLAYER_HPP
+#define LOG_SURGEON_FINITE_AUTOMATA_REGISTER_REPLAYER_HPP
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <log_surgeon/finite_automata/RegisterHandler.hpp>
+#include <log_surgeon/finite_automata/RegisterSnapshots.hpp>
+#include <log_surgeon/finite_automata/RuntimeDfa.hpp>
+
+namespace log_surgeon::finite_automata {
+/**
+ * Computes the registers of a token that was lexed without tracking tags, by running the DFA again
+ * over only the token's bytes, this time applying the register operations. Since the registers are
+ * empty when a match starts, and the token's bytes lead the DFA from the state the match started in
+ * to the accepting state the token was matched in, this yields the registers tracking tags would
+ * have.
+ */
+class RegisterReplayer {
+public:
+    /**
+     * @param dfa The DFA the tokens were lexed with, which must outlive the replayer.
+     * @param multi_valued_regs Whether each register of the DFA, indexed by ID, is multi-valued.
+     */
+    RegisterReplayer(RuntimeDfa const& dfa, std::vector<bool> const& multi_valued_regs)
+            : m_dfa{&dfa} {
+        for (auto const multi_valued : multi_valued_regs) {
+            m_reg_handler.add_register(multi_valued);
+        }
+    }
+
+    /**
+     * Replays the DFA over the token in [`start_pos`, `end_pos`) of a circular buffer, recording
+     * the same positions as the lexer would have.
+     * @param start_state The state the match started in.
+     * @param buffer
+     * @param buffer_size
+     * @param start_pos
+     * @param end_pos
+     * @param reg_ids The registers to save, e.g., those of the captures of the token's rules.
+     * @param snapshots Returns with the registers at the end of the token saved.
+     * @return A view of the saved registers.
+     */
+    auto replay(
+            RuntimeDfa::state_id_t start_state,
+            char const* buffer,
+            uint32_t buffer_size,
+            uint32_t start_pos,
+            uint32_t end_pos,
+            std::span<reg_id_t const> reg_ids,
+            RegisterSnapshots& snapshots
+    ) -> RegisterSnapshot;
+
+private:
+    RuntimeDfa const* m_dfa;
+    RegisterHandler m_reg_handler;
+};
+
+inline auto RegisterReplayer::replay(
+        RuntimeDfa::state_id_t const start_state,
+        char const* const buffer,
+        uint32_t const buffer_size,
+        uint32_t const start_pos,
+        uint32_t const end_pos,
+        std::span<reg_id_t const> const reg_ids,
+        RegisterSnapshots& snapshots
+) -> RegisterSnapshot {
+    m_reg_handler.reset();
+    auto state{start_state};
+    for (auto pos{start_pos}; end_pos != pos && RuntimeDfa::cDeadState != state;
+         pos = pos + 1 == buffer_size ? 0 : pos + 1)
+    {
+        auto const transition_idx{
+                m_dfa->get_transition_idx(state, static_cast<uint8_t>(buffer[pos]))
+        };
+        m_reg_handler.process_reg_ops(m_dfa->get_transition_reg_ops(transition_idx), pos);
+        state = m_dfa->get_next_state(transition_idx);
+    }
+    if (RuntimeDfa::is_accepting(state)) {
+        m_reg_handler.process_reg_ops(m_dfa->get_accepting_reg_ops(state), end_pos);
+    }
+    return snapshots.save(m_reg_handler, reg_ids);
+}
+}  // namespace log_surgeon::finite_automata
+
+#endif  // LOG_SURGEON_FINITE_AUTOMATA_REGISTER_REPLAYER_HPP
@@ -0,0 +1,116 @@
+#ifndef LOG_SURGEON_FINITE_AUTOMATA_REGISTER_SNAPSHOTS_HPP
+#define LOG_SURGEON_FINITE_AUTOMATA_REGISTER_SNAPSHOTS_HPP
+
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <log_surgeon/finite_automata/PrefixTree.hpp>
+#include <log_surgeon/finite_automata/RegisterHandler.hpp>
+#include <log_surgeon/types.hpp>
+
+namespace log_surgeon::finite_automata {
+class RegisterSnapshots;
+
+/**
+ * A view of the registers saved by `RegisterSnapshots::save`, which is only valid until the
+ * snapshots are cleared. A default-constructed view has no registers.
+ */
+class RegisterSnapshot {
+public:
+    RegisterSnapshot() = default;
+
+    RegisterSnapshot(RegisterSnapshots const* snapshots, uint32_t const id)
+            : m_snapshots{snapshots},
+              m_id{id} {}
+
+    /**
+     * @param reg_id
+     * @return The positions in the register, from the last to the first.
+     * @throw std::out_of_range if the register wasn't saved in the snapshot.
+     */
+    [[nodiscard]] auto get_reversed_positions(reg_id_t reg_id) const
+            -> std::span<PrefixTree::position_t const>;
+
+private:
+    RegisterSnapshots const* m_snapshots{nullptr};
+    uint32_t m_id{0};
+};
+
+/**
+ * Saves the values of some of a register handler's registers so that they can be read after the
+ * handler is reset, e.g., the registers of the captures of the tokens a lexer returns.
+ *
+ * The positions of all the snapshots are stored contiguously and `clear` keeps the storage, so once
+ * the storage has grown to fit the snapshots taken between two calls to `clear`, saving a snapshot
+ * doesn't allocate.
+ */
+class RegisterSnapshots {
+public:
+    /**
+     * Saves the values of the given registers in `reg_handler`.
+     * @param reg_handler
+     * @param reg_ids The registers to save, which are few enough to be searched linearly.
+     * @return A view of the saved registers.
+     * @throw std::out_of_range if `reg_handler` has no such register.
+     */
+    auto save(RegisterHandler const& reg_handler, std::span<reg_id_t const> const reg_ids)
+            -> RegisterSnapshot {
+        auto const id{static_cast<uint32_t>(m_offsets.size())};
+        m_offsets.push_back(static_cast<uint32_t>(reg_ids.size()));
+        m_offsets.insert(m_offsets.end(), reg_ids.begin(), reg_ids.end());
+        for (auto const reg_id : reg_ids) {
+            m_offsets.push_back(static_cast<uint32_t>(m_positions.size()));
+            reg_handler.append_reversed_positions(reg_id, m_positions);
+        }
+        m_offsets.push_back(static_cast<uint32_t>(m_positions.size()));
+        return {this, id};
+    }
+
+    /**
+     * @param id
+     * @param reg_id
+     * @return The positions in the register, from the last to the first.
+     * @throw std::out_of_range if the register wasn't saved in the snapshot.
+     */
+    [[nodiscard]] auto get_reversed_positions(uint32_t const id, reg_id_t const reg_id) const
+            -> std::span<PrefixTree::position_t const> {
+        auto const num_regs{m_offsets.at(id)};
+        auto const* reg_ids{m_offsets.data() + id + 1};
+        auto const* reg_offsets{reg_ids + num_regs};
+        for (uint32_t i{0}; i < num_regs; ++i) {
+            if (reg_id == reg_ids[i]) {
+                return {m_positions.data() + reg_offsets[i],
+                        m_positions.data() + reg_offsets[i + 1]};
+            }
+        }
+        throw std::out_of_range("Register ID out of range.");
+    }
+
+    /**
+     * Removes every snapshot, keeping the allocated storage for reuse.
+     */
+    auto clear() -> void {
+        m_positions.clear();
+        m_offsets.clear();
+    }
+
+private:
+    std::vector<PrefixTree::position_t> m_positions;
+    // For each snapshot, its number of registers, followed by their IDs, followed by the offset in
+    // `m_positions` of each register's positions, followed by the offset of the end of the last
+    // register's positions
+    std::vector<uint32_t> m_offsets;
+};
+
+inline auto RegisterSnapshot::get_reversed_positions(reg_id_t const reg_id) const
+        -> std::span<PrefixTree::position_t const> {
+    if (nullptr == m_snapshots) {
+        throw std::out_of_range("Register ID out of range.");
+    }
+    return m_snapshots->get_reversed_positions(m_id, reg_id);
+}
+}  // namespace log_surgeon::finite_automata
+
+#endif  // LOG_SURGEON_FINITE_AUTOMATA_REGISTER_SNAPSHOTS_HPP
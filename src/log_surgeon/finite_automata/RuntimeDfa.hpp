@@ -0,0 +1,652 @@
+#ifndef LOG_SURGEON_FINITE_AUTOMATA_RUNTIME_DFA_HPP
+#define LOG_SURGEON_FINITE_AUTOMATA_RUNTIME_DFA_HPP
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include <log_surgeon/BinarySerialization.hpp>
+#include <log_surgeon/ByteSet.hpp>
+#include <log_surgeon/Constants.hpp>
+#include <log_surgeon/finite_automata/ByteClassMap.hpp>
+#include <log_surgeon/finite_automata/Dfa.hpp>
+#include <log_surgeon/finite_automata/RegisterOperation.hpp>
+
+namespace log_surgeon::finite_automata {
+/**
+ * A compiled, read-only form of a `Dfa` laid out for simulation during lexing.
+ *
+ * The transition function is stored as a single contiguous `num_states x num_classes` table of
+ * state IDs, where `num_classes` is the number of byte equivalence classes of the DFA. A transition
+ * is therefore a lookup in the 256-entry class map followed by a single indexed load. State 0 is a
+ * dead state whose transitions all lead back to itself, and state 1 is the root. The accepting
+ * flag of a state is packed into the most significant bit of its ID, so whether the current state
+ * is accepting can be checked without touching any other memory.
+ *
+ * Register operations are kept out of the transition table. Each table entry has a transition ID
+ * that indexes a list of operations stored in a flat side table, with ID 0 reserved for the empty
+ * list.
+ *
+ * States can optionally be accelerated (see `accelerate_states`), which is flagged in the second
+ * most significant bit of their ID.
+ *
+ * A table can also be filled in on demand (see `LazyDfa`), in which case it starts out with only
+ * the dead state, and transitions that haven't been determinized yet lead to `cUnexploredState`.
+ * The lists of matching variable IDs are interned and never removed, so references to them stay
+ * valid even if the states are removed.
+ *
+ * Since the tables are flat arrays indexed by state ID, they can also be written to an image (see
+ * `serialize_image`) and read in place from it (see `load_image`), e.g., from a file mapped by
+ * several processes, which then share the tables' pages. Only the lists of matching variable IDs,
+ * which tokens refer to as vectors, and the small tables of register operations and exit sets,
+ * which are written as explicit records rather than their in-memory layout, are copied. A table
+ * read from an image can't be modified.
+ */
+class RuntimeDfa {
+public:
+    using state_id_t = uint32_t;
+    using reg_ops_id_t = uint32_t;
+
+    static constexpr state_id_t cAcceptingFlag{1U << 31U};
+    static constexpr state_id_t cAcceleratedFlag{1U << 30U};
+    static constexpr state_id_t cStateIndexMask{~(cAcceptingFlag | cAcceleratedFlag)};
+    static constexpr state_id_t cDeadState{0};
+    static constexpr state_id_t cUnexploredState{cStateIndexMask};
+    static constexpr reg_ops_id_t cEmptyRegOpsId{0};
+    static constexpr uint32_t cMaxAcceleratedExitSetSize{32};
+
+    /**
+     * Compiles `dfa` into its runtime form. States are numbered in the BFS order of `dfa`.
+     * @param dfa The DFA to compile.
+     */
+    template <typename TypedDfaState, typename TypedNfaState>
+    explicit RuntimeDfa(Dfa<TypedDfaState, TypedNfaState> const& dfa);
+
+    /**
+     * Creates a table with only the dead state, to be filled in with `add_state` and
+     * `set_next_state`.
+     * @param byte_class_map The byte classes the table is indexed by.
+     */
+    explicit RuntimeDfa(ByteClassMap const& byte_class_map)
+            : m_byte_to_class_id{byte_class_map.get_byte_to_class_id()},
+              m_num_classes{byte_class_map.get_num_classes()} {
+        remove_states();
+    }
+
+    // The tables may point into the table's own vectors, which moving keeps valid but copying
+    // doesn't
+    RuntimeDfa(RuntimeDfa const&) = delete;
+    RuntimeDfa(RuntimeDfa&&) noexcept = default;
+    auto operator=(RuntimeDfa const&) -> RuntimeDfa& = delete;
+    auto operator=(RuntimeDfa&&) noexcept -> RuntimeDfa& = default;
+    ~RuntimeDfa() = default;
+
+    /**
+     * Writes the table to an image, aligned such that `load_image` can read the table in place.
+     * @param writer
+     */
+    auto serialize_image(BinaryWriter& writer) const -> void;
+
+    /**
+     * Reads a table written by `serialize_image` in place.
+     * @param reader A reader of an image, which must stay valid and unchanged while the returned
+     * table is in use. The image must be aligned to at least 16 bytes.
+     * @param num_registers The number of registers the register operations may refer to.
+     * @return The table.
+     * @throw std::runtime_error if the image is truncated, misaligned, or its tables are
+     * inconsistent, i.e., any ID, register operation type, or flag in them is out of range.
+     */
+    [[nodiscard]] static auto load_image(BinaryReader& reader, size_t num_registers)
+            -> std::unique_ptr<RuntimeDfa>;
+
+    /**
+     * @return Whether the table was read from an image, in which case it can't be modified.
+     */
+    [[nodiscard]] auto is_from_image() const -> bool { return m_is_from_image; }
+
+    [[nodiscard]] static auto is_accepting(state_id_t const state) -> bool {
+        return 0 != (state & cAcceptingFlag);
+    }
+
+    [[nodiscard]] static auto is_accelerated(state_id_t const state) -> bool {
+        return 0 != (state & cAcceleratedFlag);
+    }
+
+    /**
+     * Flags every state that loops back to itself, without any register operations, on all but at
+     * most `cMaxAcceleratedExitSetSize` bytes. While in such a state, a simulation can skip ahead to
+     * the next byte in the state's exit set using a vectorized search, instead of transitioning on
+     * every byte. Any previously flagged state is unflagged first.
+     * @param stop_bytes Bytes to add to every exit set, even if they loop back to the state, as the
+     * caller needs to observe them.
+     */
+    auto accelerate_states(std::array<bool, cSizeOfByte> const& stop_bytes) -> void;
+
+    /**
+     * @param state An accelerated state.
+     * @return The bytes that leave the state, or that must be observed while in the state.
+     */
+    [[nodiscard]] auto get_exit_bytes(state_id_t const state) const -> ByteSet const& {
+        return m_tables.m_exit_bytes[m_tables.m_exit_bytes_ids[state & cStateIndexMask]];
+    }
+
+    [[nodiscard]] auto get_root() const -> state_id_t { return m_root; }
+
+    [[nodiscard]] auto get_num_states() const -> size_t {
+        return m_tables.m_accepting_reg_ops_ids.size();
+    }
+
+    [[nodiscard]] auto get_num_classes() const -> uint32_t { return m_num_classes; }
+
+    /**
+     * @param state The source state.
+     * @param byte The byte to transition on.
+     * @return The index of the transition in the transition table.
+     */
+    [[nodiscard]] auto get_transition_idx(state_id_t const state, uint8_t const byte) const
+            -> size_t {
+        return static_cast<size_t>(state & cStateIndexMask) * m_num_classes
+               + m_byte_to_class_id[byte];
+    }
+
+    [[nodiscard]] auto get_next_state(size_t const transition_idx) const -> state_id_t {
+        return m_tables.m_next_states[transition_idx];
+    }
+
+    [[nodiscard]] auto get_next_state(state_id_t const state, uint8_t const byte) const
+            -> state_id_t {
+        return m_tables.m_next_states[get_transition_idx(state, byte)];
+    }
+
+    [[nodiscard]] auto get_transition_reg_ops(size_t const transition_idx) const
+            -> std::span<RegisterOperation const> {
+        return get_reg_ops(m_tables.m_transition_reg_ops_ids[transition_idx]);
+    }
+
+    [[nodiscard]] auto get_accepting_reg_ops(state_id_t const state) const
+            -> std::span<RegisterOperation const> {
+        return get_reg_ops(m_tables.m_accepting_reg_ops_ids[state & cStateIndexMask]);
+    }
+
+    [[nodiscard]] auto get_matching_variable_ids(state_id_t const state) const
+            -> std::vector<uint32_t> const& {
+        return m_matching_variable_id_lists
+                [m_tables.m_matching_variable_ids_ids[state & cStateIndexMask]];
+    }
+
+    /**
+     * Adds a state without any register operations, all of whose transitions lead to
+     * `cUnexploredState`.
+     * @param matching_variable_ids The variables the state matches, if it's accepting.
+     * @return The ID of the new state.
+     */
+    auto add_state(std::vector<uint32_t> const& matching_variable_ids) -> state_id_t;
+
+    /**
+     * Replaces the matching variables of a state added by `add_state`, keeping its transitions.
+     * @param state
+     * @param matching_variable_ids
+     * @return The ID of the state, whose accepting flag may have changed.
+     */
+    auto set_matching_variable_ids(
+            state_id_t state,
+            std::vector<uint32_t> const& matching_variable_ids
+    ) -> state_id_t;
+
+    auto set_next_state(size_t const transition_idx, state_id_t const next_state) -> void {
+        assert(false == m_is_from_image);
+        m_next_states[transition_idx] = next_state;
+    }
+
+    auto set_root(state_id_t const root) -> void { m_root = root; }
+
+    /**
+     * Removes every state except the dead state.
+     */
+    auto remove_states() -> void;
+
+private:
+    // The tables read while lexing, which point either into the vectors below or into an image
+    struct Tables {
+        std::span<state_id_t const> m_next_states;
+        std::span<reg_ops_id_t const> m_transition_reg_ops_ids;
+        std::span<reg_ops_id_t const> m_accepting_reg_ops_ids;
+        std::span<uint32_t const> m_matching_variable_ids_ids;
+        std::span<RegisterOperation const> m_reg_ops;
+        std::span<uint64_t const> m_reg_ops_offsets;
+        std::span<uint32_t const> m_exit_bytes_ids;
+        std::span<ByteSet const> m_exit_bytes;
+    };
+
+    // A register operation as written to an image, which, unlike `RegisterOperation`, has no
+    // padding or unset members, so that the same table is always written as the same bytes
+    struct RegOpRecord {
+        reg_id_t m_reg_id;
+        reg_id_t m_copy_reg_id;
+        uint8_t m_type;
+        uint8_t m_has_copy_reg_id;
+        std::array<uint8_t, 2> m_padding;
+    };
+
+    // An exit set as written to an image, with one bit per byte
+    using ExitBytesRecord = std::array<uint64_t, cSizeOfByte / 64>;
+
+    static_assert(std::has_unique_object_representations_v<RegOpRecord>);
+    static_assert(std::has_unique_object_representations_v<ExitBytesRecord>);
+
+    RuntimeDfa() = default;
+
+    /**
+     * Points the tables at the vectors, which must be called whenever the vectors may have been
+     * reallocated.
+     */
+    auto update_tables() -> void {
+        m_tables = {m_next_states,
+                    m_transition_reg_ops_ids,
+                    m_accepting_reg_ops_ids,
+                    m_matching_variable_ids_ids,
+                    m_reg_ops,
+                    m_reg_ops_offsets,
+                    m_exit_bytes_ids,
+                    m_exit_bytes};
+    }
+
+    [[nodiscard]] auto get_reg_ops(reg_ops_id_t const reg_ops_id) const
+            -> std::span<RegisterOperation const> {
+        auto const begin_idx{m_tables.m_reg_ops_offsets[reg_ops_id]};
+        return m_tables.m_reg_ops.subspan(
+                begin_idx,
+                m_tables.m_reg_ops_offsets[reg_ops_id + 1] - begin_idx
+        );
+    }
+
+    /**
+     * @param num_registers The number of registers the register operations may refer to.
+     * @return Whether every ID in the tables is in range, which `load_image` requires before the
+     * tables are used.
+     */
+    [[nodiscard]] auto are_tables_consistent(size_t num_registers) const -> bool;
+
+    /**
+     * Appends a list of register operations to the side table.
+     * @param reg_ops The register operations.
+     * @return The ID of the appended list, or `cEmptyRegOpsId` if `reg_ops` is empty.
+     */
+    auto add_reg_ops(std::vector<RegisterOperation> const& reg_ops) -> reg_ops_id_t;
+
+    /**
+     * @param matching_variable_ids
+     * @return The index of the interned copy of `matching_variable_ids`.
+     */
+    auto intern_matching_variable_ids(std::vector<uint32_t> const& matching_variable_ids)
+            -> uint32_t;
+
+    state_id_t m_root{cDeadState};
+    std::array<ByteClassMap::class_id_t, cSizeOfByte> m_byte_to_class_id{};
+    uint32_t m_num_classes{0};
+    Tables m_tables;
+    bool m_is_from_image{false};
+    // The storage of `m_tables`, unless the table was read from an image
+    std::vector<state_id_t> m_next_states;
+    std::vector<reg_ops_id_t> m_transition_reg_ops_ids;
+    std::vector<reg_ops_id_t> m_accepting_reg_ops_ids;
+    std::vector<uint32_t> m_matching_variable_ids_ids;
+    // A deque, so that references to the lists stay valid while lists are added
+    std::deque<std::vector<uint32_t>> m_matching_variable_id_lists;
+    std::map<std::vector<uint32_t>, uint32_t> m_matching_variable_id_list_ids;
+    std::vector<RegisterOperation> m_reg_ops;
+    std::vector<uint64_t> m_reg_ops_offsets{0, 0};
+    std::vector<uint32_t> m_exit_bytes_ids;
+    std::vector<ByteSet> m_exit_bytes;
+};
+
+template <typename TypedDfaState, typename TypedNfaState>
+RuntimeDfa::RuntimeDfa(Dfa<TypedDfaState, TypedNfaState> const& dfa)
+        : m_byte_to_class_id{dfa.get_byte_class_map().get_byte_to_class_id()},
+          m_num_classes{dfa.get_byte_class_map().get_num_classes()} {
+    auto const& byte_class_map{dfa.get_byte_class_map()};
+    auto const traversal_order{dfa.get_bfs_traversal_order()};
+    auto const num_states{traversal_order.size() + 1};
+
+    std::unordered_map<TypedDfaState const*, state_id_t> state_ids;
+    state_ids.reserve(traversal_order.size());
+    for (auto const* state : traversal_order) {
+        state_id_t state_id{static_cast<state_id_t>(state_ids.size() + 1)};
+        if (state->is_accepting()) {
+            state_id |= cAcceptingFlag;
+        }
+        state_ids.emplace(state, state_id);
+    }
+    m_root = state_ids.at(dfa.get_root());
+
+    m_next_states.assign(num_states * m_num_classes, cDeadState);
+    m_transition_reg_ops_ids.assign(num_states * m_num_classes, cEmptyRegOpsId);
+    m_accepting_reg_ops_ids.assign(num_states, cEmptyRegOpsId);
+    m_matching_variable_ids_ids.assign(num_states, intern_matching_variable_ids({}));
+    for (auto const* state : traversal_order) {
+        auto const state_id{state_ids.at(state)};
+        m_accepting_reg_ops_ids[state_id & cStateIndexMask]
+                = add_reg_ops(state->get_accepting_reg_ops());
+        m_matching_variable_ids_ids[state_id & cStateIndexMask]
+                = intern_matching_variable_ids(state->get_matching_variable_ids());
+
+        for (uint32_t class_idx{0}; class_idx < m_num_classes; ++class_idx) {
+            auto const class_id{static_cast<ByteClassMap::class_id_t>(class_idx)};
+            auto const representative{byte_class_map.get_representative(class_id)};
+            auto const& optional_transition{state->get_transition(representative)};
+            if (false == optional_transition.has_value()) {
+                continue;
+            }
+            auto const transition_idx{get_transition_idx(state_id, representative)};
+            m_next_states[transition_idx] = state_ids.at(optional_transition->get_dest_state());
+            m_transition_reg_ops_ids[transition_idx]
+                    = add_reg_ops(optional_transition->get_reg_ops());
+        }
+    }
+    update_tables();
+}
+
+inline auto RuntimeDfa::serialize_image(BinaryWriter& writer) const -> void {
+    writer.write(m_root);
+    writer.write(m_num_classes);
+    writer.write(m_byte_to_class_id);
+    writer.write_aligned_span(m_tables.m_next_states);
+    writer.write_aligned_span(m_tables.m_transition_reg_ops_ids);
+    writer.write_aligned_span(m_tables.m_accepting_reg_ops_ids);
+    writer.write_aligned_span(m_tables.m_matching_variable_ids_ids);
+    std::vector<RegOpRecord> reg_op_records;
+    reg_op_records.reserve(m_tables.m_reg_ops.size());
+    for (auto const& reg_op : m_tables.m_reg_ops) {
+        auto const optional_copy_reg_id{reg_op.get_copy_reg_id()};
+        reg_op_records.push_back(
+                {reg_op.get_reg_id(),
+                 optional_copy_reg_id.value_or(0),
+                 static_cast<uint8_t>(reg_op.get_type()),
+                 static_cast<uint8_t>(optional_copy_reg_id.has_value()),
+                 {}}
+        );
+    }
+    writer.write_vector(reg_op_records);
+    writer.write_aligned_span(m_tables.m_reg_ops_offsets);
+    writer.write_aligned_span(m_tables.m_exit_bytes_ids);
+    std::vector<ExitBytesRecord> exit_bytes_records;
+    exit_bytes_records.reserve(m_tables.m_exit_bytes.size());
+    for (auto const& exit_bytes : m_tables.m_exit_bytes) {
+        auto& record{exit_bytes_records.emplace_back()};
+        for (uint32_t byte{0}; byte < cSizeOfByte; ++byte) {
+            if (exit_bytes.contains(static_cast<uint8_t>(byte))) {
+                record[byte / 64] |= uint64_t{1} << (byte % 64);
+            }
+        }
+    }
+    writer.write_vector(exit_bytes_records);
+    writer.write(static_cast<uint64_t>(m_matching_variable_id_lists.size()));
+    for (auto const& matching_variable_ids : m_matching_variable_id_lists) {
+        writer.write_vector(matching_variable_ids);
+    }
+}
+
+inline auto RuntimeDfa::load_image(BinaryReader& reader, size_t const num_registers)
+        -> std::unique_ptr<RuntimeDfa> {
+    // `RuntimeDfa`'s default constructor is private
+    std::unique_ptr<RuntimeDfa> runtime_dfa{new RuntimeDfa()};
+    runtime_dfa->m_is_from_image = true;
+    runtime_dfa->m_root = reader.read<state_id_t>();
+    runtime_dfa->m_num_classes = reader.read<uint32_t>();
+    runtime_dfa->m_byte_to_class_id
+            = reader.read<std::array<ByteClassMap::class_id_t, cSizeOfByte>>();
+    auto& tables{runtime_dfa->m_tables};
+    tables.m_next_states = reader.read_aligned_span<state_id_t>();
+    tables.m_transition_reg_ops_ids = reader.read_aligned_span<reg_ops_id_t>();
+    tables.m_accepting_reg_ops_ids = reader.read_aligned_span<reg_ops_id_t>();
+    tables.m_matching_variable_ids_ids = reader.read_aligned_span<uint32_t>();
+    for (auto const& record : reader.read_vector<RegOpRecord>()) {
+        // Only copies have a source register, and every unused byte is zero
+        auto const type{static_cast<RegisterOperation::Type>(record.m_type)};
+        auto const is_copy{RegisterOperation::Type::Copy == type};
+        if (static_cast<uint8_t>(is_copy) != record.m_has_copy_reg_id
+            || (false == is_copy && 0 != record.m_copy_reg_id) || 0 != record.m_padding[0]
+            || 0 != record.m_padding[1])
+        {
+            throw std::runtime_error("DFA image has an invalid register operation.");
+        }
+        switch (type) {
+            case RegisterOperation::Type::Copy:
+                runtime_dfa->m_reg_ops.push_back(RegisterOperation::create_copy_operation(
+                        record.m_reg_id,
+                        record.m_copy_reg_id
+                ));
+                break;
+            case RegisterOperation::Type::Set:
+                runtime_dfa->m_reg_ops.push_back(
+                        RegisterOperation::create_set_operation(record.m_reg_id)
+                );
+                break;
+            case RegisterOperation::Type::Negate:
+                runtime_dfa->m_reg_ops.push_back(
+                        RegisterOperation::create_negate_operation(record.m_reg_id)
+                );
+                break;
+            default:
+                throw std::runtime_error("DFA image has an invalid register operation.");
+        }
+    }
+    tables.m_reg_ops = runtime_dfa->m_reg_ops;
+    tables.m_reg_ops_offsets = reader.read_aligned_span<uint64_t>();
+    tables.m_exit_bytes_ids = reader.read_aligned_span<uint32_t>();
+    for (auto const& record : reader.read_vector<ExitBytesRecord>()) {
+        std::array<bool, cSizeOfByte> is_exit_byte{};
+        for (uint32_t byte{0}; byte < cSizeOfByte; ++byte) {
+            is_exit_byte[byte] = 0 != (record[byte / 64] >> (byte % 64) & 1U);
+        }
+        runtime_dfa->m_exit_bytes.emplace_back(is_exit_byte);
+    }
+    tables.m_exit_bytes = runtime_dfa->m_exit_bytes;
+    auto const num_lists{reader.read_size(sizeof(uint64_t))};
+    for (size_t i{0}; i < num_lists; ++i) {
+        runtime_dfa->m_matching_variable_id_lists.push_back(reader.read_vector<uint32_t>());
+    }
+
+    if (false == runtime_dfa->are_tables_consistent(num_registers)) {
+        throw std::runtime_error("DFA image has inconsistent tables.");
+    }
+    return runtime_dfa;
+}
+
+inline auto RuntimeDfa::are_tables_consistent(size_t const num_registers) const -> bool {
+    auto const num_states{m_tables.m_accepting_reg_ops_ids.size()};
+    if (0 == m_num_classes || m_num_classes > cSizeOfByte || 0 == num_states
+        || m_tables.m_next_states.size() != num_states * m_num_classes
+        || m_tables.m_transition_reg_ops_ids.size() != num_states * m_num_classes
+        || m_tables.m_matching_variable_ids_ids.size() != num_states
+        || m_tables.m_reg_ops_offsets.size() < 2
+        || m_tables.m_reg_ops.size() != m_tables.m_reg_ops_offsets.back()
+        || (false == m_tables.m_exit_bytes_ids.empty()
+            && m_tables.m_exit_bytes_ids.size() != num_states)
+        || m_matching_variable_id_lists.empty())
+    {
+        return false;
+    }
+    for (auto const class_id : m_byte_to_class_id) {
+        if (class_id >= m_num_classes) {
+            return false;
+        }
+    }
+
+    for (size_t i{1}; i < m_tables.m_reg_ops_offsets.size(); ++i) {
+        if (m_tables.m_reg_ops_offsets[i - 1] > m_tables.m_reg_ops_offsets[i]) {
+            return false;
+        }
+    }
+    for (auto const& reg_op : m_tables.m_reg_ops) {
+        auto const type{reg_op.get_type()};
+        if (reg_op.get_reg_id() >= num_registers
+            || (RegisterOperation::Type::Copy != type && RegisterOperation::Type::Set != type
+                && RegisterOperation::Type::Negate != type))
+        {
+            return false;
+        }
+        if (RegisterOperation::Type::Copy == type) {
+            auto const optional_copy_reg_id{reg_op.get_copy_reg_id()};
+            if (false == optional_copy_reg_id.has_value()
+                || optional_copy_reg_id.value() >= num_registers)
+            {
+                return false;
+            }
+        }
+    }
+    auto const num_reg_ops_lists{m_tables.m_reg_ops_offsets.size() - 1};
+    auto const is_valid_reg_ops_id{[&](reg_ops_id_t const reg_ops_id) -> bool {
+        return reg_ops_id < num_reg_ops_lists;
+    }};
+    if (false == std::ranges::all_of(m_tables.m_transition_reg_ops_ids, is_valid_reg_ops_id)
+        || false == std::ranges::all_of(m_tables.m_accepting_reg_ops_ids, is_valid_reg_ops_id))
+    {
+        return false;
+    }
+    for (auto const matching_variable_ids_id : m_tables.m_matching_variable_ids_ids) {
+        if (matching_variable_ids_id >= m_matching_variable_id_lists.size()) {
+            return false;
+        }
+    }
+    // States that aren't accelerated have exit set ID 0, even if there are no exit sets
+    for (auto const exit_bytes_id : m_tables.m_exit_bytes_ids) {
+        if (0 != exit_bytes_id && exit_bytes_id >= m_tables.m_exit_bytes.size()) {
+            return false;
+        }
+    }
+
+    // The flags of every reference to a state must match the state's matching variables and exit
+    // set
+    auto const is_valid_state_reference{[&](state_id_t const state) -> bool {
+        auto const state_idx{state & cStateIndexMask};
+        if (state_idx >= num_states) {
+            return false;
+        }
+        auto const& matching_variable_ids{
+                m_matching_variable_id_lists[m_tables.m_matching_variable_ids_ids[state_idx]]
+        };
+        if (is_accepting(state) == matching_variable_ids.empty()) {
+            return false;
+        }
+        return false == is_accelerated(state)
+               || (false == m_tables.m_exit_bytes_ids.empty()
+                   && m_tables.m_exit_bytes_ids[state_idx] < m_tables.m_exit_bytes.size());
+    }};
+    return is_valid_state_reference(m_root)
+           && std::ranges::all_of(m_tables.m_next_states, is_valid_state_reference);
+}
+
+inline auto RuntimeDfa::accelerate_states(std::array<bool, cSizeOfByte> const& stop_bytes)
+        -> void {
+    assert(false == m_is_from_image);
+    auto const num_states{get_num_states()};
+    m_exit_bytes_ids.assign(num_states, 0);
+    m_exit_bytes.clear();
+    std::vector<bool> is_state_accelerated(num_states, false);
+    for (state_id_t state_idx{1}; state_idx < num_states; ++state_idx) {
+        std::array<bool, cSizeOfByte> is_exit_byte{};
+        uint32_t num_exit_bytes{0};
+        for (uint32_t byte{0}; byte < cSizeOfByte; ++byte) {
+            auto const transition_idx{get_transition_idx(state_idx, static_cast<uint8_t>(byte))};
+            is_exit_byte[byte] = stop_bytes[byte]
+                                 || state_idx != (m_next_states[transition_idx] & cStateIndexMask)
+                                 || cEmptyRegOpsId != m_transition_reg_ops_ids[transition_idx];
+            if (is_exit_byte[byte]) {
+                ++num_exit_bytes;
+            }
+        }
+        if (num_exit_bytes > cMaxAcceleratedExitSetSize) {
+            continue;
+        }
+        is_state_accelerated[state_idx] = true;
+        m_exit_bytes_ids[state_idx] = static_cast<uint32_t>(m_exit_bytes.size());
+        m_exit_bytes.emplace_back(is_exit_byte);
+    }
+
+    auto const flag_state{[&](state_id_t& state) -> void {
+        state &= ~cAcceleratedFlag;
+        if (is_state_accelerated[state & cStateIndexMask]) {
+            state |= cAcceleratedFlag;
+        }
+    }};
+    flag_state(m_root);
+    for (auto& next_state : m_next_states) {
+        flag_state(next_state);
+    }
+    update_tables();
+}
+
+inline auto RuntimeDfa::add_state(std::vector<uint32_t> const& matching_variable_ids)
+        -> state_id_t {
+    assert(false == m_is_from_image);
+    auto const state_idx{static_cast<state_id_t>(get_num_states())};
+    m_next_states.resize(m_next_states.size() + m_num_classes, cUnexploredState);
+    m_transition_reg_ops_ids.resize(
+            m_transition_reg_ops_ids.size() + m_num_classes,
+            cEmptyRegOpsId
+    );
+    m_accepting_reg_ops_ids.push_back(cEmptyRegOpsId);
+    m_matching_variable_ids_ids.push_back(0);
+    update_tables();
+    return set_matching_variable_ids(state_idx, matching_variable_ids);
+}
+
+inline auto RuntimeDfa::set_matching_variable_ids(
+        state_id_t const state,
+        std::vector<uint32_t> const& matching_variable_ids
+) -> state_id_t {
+    assert(false == m_is_from_image);
+    auto const state_idx{state & cStateIndexMask};
+    m_matching_variable_ids_ids[state_idx] = intern_matching_variable_ids(matching_variable_ids);
+    return matching_variable_ids.empty() ? state_idx : state_idx | cAcceptingFlag;
+}
+
+inline auto RuntimeDfa::remove_states() -> void {
+    assert(false == m_is_from_image);
+    m_root = cDeadState;
+    m_next_states.assign(m_num_classes, cDeadState);
+    m_transition_reg_ops_ids.assign(m_num_classes, cEmptyRegOpsId);
+    m_accepting_reg_ops_ids.assign(1, cEmptyRegOpsId);
+    m_matching_variable_ids_ids.assign(1, intern_matching_variable_ids({}));
+    m_exit_bytes_ids.clear();
+    m_exit_bytes.clear();
+    update_tables();
+}
+
+inline auto RuntimeDfa::intern_matching_variable_ids(
+        std::vector<uint32_t> const& matching_variable_ids
+) -> uint32_t {
+    auto const [it, inserted]{m_matching_variable_id_list_ids.try_emplace(
+            matching_variable_ids,
+            static_cast<uint32_t>(m_matching_variable_id_lists.size())
+    )};
+    if (inserted) {
+        m_matching_variable_id_lists.push_back(matching_variable_ids);
+    }
+    return it->second;
+}
+
+inline auto RuntimeDfa::add_reg_ops(std::vector<RegisterOperation> const& reg_ops)
+        -> reg_ops_id_t {
+    if (reg_ops.empty()) {
+        return cEmptyRegOpsId;
+    }
+    m_reg_ops.insert(m_reg_ops.end(), reg_ops.begin(), reg_ops.end());
+    m_reg_ops_offsets.push_back(m_reg_ops.size());
+    update_tables();
+    return static_cast<reg_ops_id_t>(m_reg_ops_offsets.size() - 2);
+}
+}  // namespace log_surgeon::finite_automata
+
+#endif  // LOG_SURGEON_FINITE_AUTOMATA_RUNTIME_DFA_HPP
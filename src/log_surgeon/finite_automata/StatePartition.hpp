@@ -0,0 +1,139 @@
+#ifndef LOG_SURGEON_FINITE_AUTOMATA_STATE_PARTITION_HPP
+#define LOG_SURGEON_FINITE_AUTOMATA_STATE_PARTITION_HPP
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace log_surgeon::finite_automata {
+/**
+ * A partition of the states `[0, num_states)` into blocks that can be refined in time proportional
+ * to the number of states marked, as used by Hopcroft's minimization algorithm.
+ *
+ * The states are kept in one array in which every block is a contiguous range. Marking a state
+ * moves it to the front of its block, so a block can be split into its marked and unmarked states
+ * without touching the unmarked ones.
+ */
+class StatePartition {
+public:
+    /**
+     * @param initial_block_ids The block of each state. The IDs must be in `[0, num_blocks)`.
+     * @param num_blocks
+     */
+    StatePartition(std::vector<uint32_t> const& initial_block_ids, uint32_t num_blocks);
+
+    [[nodiscard]] auto get_num_blocks() const -> uint32_t {
+        return static_cast<uint32_t>(m_block_begins.size());
+    }
+
+    [[nodiscard]] auto get_block_id(uint32_t const state) const -> uint32_t {
+        return m_block_ids[state];
+    }
+
+    [[nodiscard]] auto get_block_size(uint32_t const block_id) const -> uint32_t {
+        return m_block_ends[block_id] - m_block_begins[block_id];
+    }
+
+    /**
+     * @param block_id
+     * @return The block's states as a range of pointers. Marking a state may reorder them.
+     */
+    [[nodiscard]] auto get_block(uint32_t const block_id) const
+            -> std::pair<uint32_t const*, uint32_t const*> {
+        return {m_states.data() + m_block_begins[block_id],
+                m_states.data() + m_block_ends[block_id]};
+    }
+
+    /**
+     * Marks a state for the next call to `split`. Marking a state twice has no effect.
+     * @param state
+     */
+    auto mark(uint32_t state) -> void;
+
+    /**
+     * Splits every block with both marked and unmarked states in two, moving its marked states
+     * into a new block, and then unmarks all states.
+     * @return The (old, new) block ID pairs of the blocks split.
+     */
+    auto split() -> std::vector<std::pair<uint32_t, uint32_t>>;
+
+private:
+    std::vector<uint32_t> m_states;
+    std::vector<uint32_t> m_positions;
+    std::vector<uint32_t> m_block_ids;
+    std::vector<uint32_t> m_block_begins;
+    std::vector<uint32_t> m_block_ends;
+    // The end of the marked states at the front of each block
+    std::vector<uint32_t> m_marked_ends;
+    std::vector<uint32_t> m_touched_block_ids;
+};
+
+inline StatePartition::StatePartition(
+        std::vector<uint32_t> const& initial_block_ids,
+        uint32_t const num_blocks
+)
+        : m_states(initial_block_ids.size()),
+          m_positions(initial_block_ids.size()),
+          m_block_ids{initial_block_ids},
+          m_block_begins(num_blocks, 0),
+          m_block_ends(num_blocks, 0) {
+    for (auto const block_id : initial_block_ids) {
+        ++m_block_ends[block_id];
+    }
+    uint32_t begin{0};
+    for (uint32_t block_id{0}; block_id < num_blocks; ++block_id) {
+        m_block_begins[block_id] = begin;
+        begin += m_block_ends[block_id];
+        m_block_ends[block_id] = m_block_begins[block_id];
+    }
+    for (uint32_t state{0}; state < initial_block_ids.size(); ++state) {
+        auto& end{m_block_ends[initial_block_ids[state]]};
+        m_states[end] = state;
+        m_positions[state] = end;
+        ++end;
+    }
+    m_marked_ends = m_block_begins;
+}
+
+inline auto StatePartition::mark(uint32_t const state) -> void {
+    auto const block_id{m_block_ids[state]};
+    auto const position{m_positions[state]};
+    auto& marked_end{m_marked_ends[block_id]};
+    if (position < marked_end) {
+        return;
+    }
+    if (m_block_begins[block_id] == marked_end) {
+        m_touched_block_ids.push_back(block_id);
+    }
+    auto const other_state{m_states[marked_end]};
+    std::swap(m_states[position], m_states[marked_end]);
+    m_positions[other_state] = position;
+    m_positions[state] = marked_end;
+    ++marked_end;
+}
+
+inline auto StatePartition::split() -> std::vector<std::pair<uint32_t, uint32_t>> {
+    std::vector<std::pair<uint32_t, uint32_t>> splits;
+    for (auto const block_id : m_touched_block_ids) {
+        auto const marked_end{m_marked_ends[block_id]};
+        m_marked_ends[block_id] = m_block_begins[block_id];
+        if (marked_end == m_block_ends[block_id]) {
+            continue;
+        }
+        auto const new_block_id{static_cast<uint32_t>(m_block_begins.size())};
+        m_block_begins.push_back(m_block_begins[block_id]);
+        m_block_ends.push_back(marked_end);
+        m_marked_ends.push_back(m_block_begins[block_id]);
+        for (auto position{m_block_begins[block_id]}; position < marked_end; ++position) {
+            m_block_ids[m_states[position]] = new_block_id;
+        }
+        m_block_begins[block_id] = marked_end;
+        m_marked_ends[block_id] = marked_end;
+        splits.emplace_back(block_id, new_block_id);
+    }
+    m_touched_block_ids.clear();
+    return splits;
+}
+}  // namespace log_surgeon::finite_automata
+
+#endif  // LOG_SURGEON_FINITE_AUTOMATA_STATE_PARTITION_HPP
@@ -1,3 +1,15 @@
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <memory>
+#include <random>
+#include <span>
+#include <stdexcept>
 #include <string>
 #include <string_view>
 #include <unordered_map>
@@ -5,24 +17,48 @@
 #include <vector>
 
 #include <log_surgeon/BufferParser.hpp>
+#include <log_surgeon/ByteSet.hpp>
 #include <log_surgeon/Constants.hpp>
+#include <log_surgeon/DelimiterBitmap.hpp>
+#include <log_surgeon/finite_automata/Dfa.hpp>
+#include <log_surgeon/finite_automata/NfaState.hpp>
+#include <log_surgeon/finite_automata/RegexAST.hpp>
 #include <log_surgeon/Lexer.hpp>
 #include <log_surgeon/LogEvent.hpp>
 #include <log_surgeon/LogParser.hpp>
+#include <log_surgeon/MappedFile.hpp>
+#include <log_surgeon/ParserInputBuffer.hpp>
+#include <log_surgeon/Reader.hpp>
 #include <log_surgeon/Schema.hpp>
 #include <log_surgeon/SchemaParser.hpp>
+#include <log_surgeon/Token.hpp>
+#include <log_surgeon/TokenSideStorage.hpp>
 #include <log_surgeon/types.hpp>
 
 #include <catch2/catch_test_macros.hpp>
 #include <fmt/core.h>
 
 using log_surgeon::BufferParser;
+using log_surgeon::ByteSet;
+using log_surgeon::CaptureRegisters;
 using log_surgeon::capture_id_t;
+using log_surgeon::DelimiterBitmap;
 using log_surgeon::ErrorCode;
+using log_surgeon::LexingMode;
+using log_surgeon::ParserInputBuffer;
+using log_surgeon::Reader;
+using log_surgeon::SchemaVarAST;
+using log_surgeon::finite_automata::ByteNfaState;
+using log_surgeon::finite_automata::DfaStateLimitExceeded;
 using log_surgeon::finite_automata::PrefixTree;
+using log_surgeon::finite_automata::RegexASTLiteral;
+using log_surgeon::lexers::ByteLexer;
 using log_surgeon::rule_id_t;
 using log_surgeon::Schema;
 using log_surgeon::SymbolId;
+using log_surgeon::Token;
+using log_surgeon::TokenCapture;
+using log_surgeon::TokenSideStorage;
 using std::string;
 using std::string_view;
 using std::unordered_map;
@@ -68,6 +104,37 @@ auto parse_and_validate(
  */
 [[nodiscard]] auto serialize_id_symbol_map(unordered_map<rule_id_t, string> const& map) -> string;
 
+/**
+ * Parses the entire input and serializes every token of every event, including its position, line,
+ * type, and the positions of its captures.
+ * @param buffer_parser The buffer parser to parse the input with.
+ * @param input The input to parse.
+ * @return The serialized tokens.
+ */
+[[nodiscard]] auto parse_and_serialize(BufferParser& buffer_parser, string& input)
+        -> vector<string>;
+
+/**
+ * Sets up a lexer like `LogParser` does, with a rule for each variable schema and a rule for
+ * newlines, but without prepending a delimiter to the variables.
+ * @param lexer Returns the generated lexer, which must be configured before the call.
+ * @param delimiters
+ * @param var_schemas
+ */
+auto generate_lexer(
+        ByteLexer& lexer,
+        string_view delimiters,
+        vector<string_view> const& var_schemas
+) -> void;
+
+/**
+ * Lexes the entire input and serializes every token, including its position and type.
+ * @param lexer The lexer to lex the input with.
+ * @param input The input to lex, which must not be empty.
+ * @return The serialized tokens.
+ */
+[[nodiscard]] auto lex_and_serialize(ByteLexer& lexer, string& input) -> vector<string>;
+
 auto parse_and_validate(
         BufferParser& buffer_parser,
         std::string_view input,
@@ -153,6 +220,98 @@ auto parse_and_validate(
     REQUIRE(buffer_parser.done());
 }
 
+auto parse_and_serialize(BufferParser& buffer_parser, string& input) -> vector<string> {
+    buffer_parser.reset();
+    auto const& lexer{buffer_parser.get_log_parser().m_lexer};
+    vector<string> serialized_tokens;
+    size_t buffer_offset{0};
+    while (false == buffer_parser.done()) {
+        auto const err{
+                buffer_parser.parse_next_event(input.data(), input.size(), buffer_offset, true)
+        };
+        REQUIRE(ErrorCode::Success == err);
+        auto const& output_buffer{
+                buffer_parser.get_log_parser().get_log_event_view().get_log_output_buffer()
+        };
+        // Without a timestamp, the first token is stored at index 1
+        uint32_t const first_token_idx{output_buffer->has_timestamp() ? 0U : 1U};
+        for (auto i{first_token_idx}; i < output_buffer->pos(); ++i) {
+            auto token{output_buffer->get_token(i)};
+            auto const token_type{token.m_type_ids_ptr->at(0)};
+            auto serialized_token{fmt::format(
+                    "{}:{}-{}@{}:{}",
+                    token.to_string(),
+                    token.m_start_pos,
+                    token.m_end_pos,
+                    token.m_line,
+                    token_type
+            )};
+            for (auto const capture_id :
+                 lexer.get_capture_ids_from_rule_id(token_type).value_or(vector<capture_id_t>{}))
+            {
+                auto const [start_reg_id, end_reg_id]{
+                        lexer.get_reg_ids_from_capture_id(capture_id).value()
+                };
+                for (auto const reg_id : {start_reg_id, end_reg_id}) {
+                    for (auto const position : token.get_reversed_reg_positions(reg_id)) {
+                        serialized_token += fmt::format(",{}", position);
+                    }
+                }
+            }
+            serialized_tokens.emplace_back(std::move(serialized_token));
+        }
+    }
+    return serialized_tokens;
+}
+
+auto generate_lexer(
+        ByteLexer& lexer,
+        string_view delimiters,
+        vector<string_view> const& var_schemas
+) -> void {
+    lexer.set_delimiters(vector<uint32_t>(delimiters.begin(), delimiters.end()));
+    lexer.add_rule(
+            static_cast<rule_id_t>(SymbolId::TokenNewline),
+            std::make_unique<RegexASTLiteral<ByteNfaState>>('\n')
+    );
+    Schema schema;
+    for (auto const& var_schema : var_schemas) {
+        schema.add_variable(var_schema, -1);
+    }
+    auto const schema_ast{schema.release_schema_ast_ptr()};
+    rule_id_t rule_id{static_cast<rule_id_t>(SymbolId::TokenNewline) + 1};
+    for (auto const& schema_var : schema_ast->m_schema_vars) {
+        auto& var_ast{dynamic_cast<SchemaVarAST&>(*schema_var)};
+        lexer.add_rule(rule_id++, std::move(var_ast.m_regex_ptr));
+    }
+    lexer.generate();
+}
+
+auto lex_and_serialize(ByteLexer& lexer, string& input) -> vector<string> {
+    ParserInputBuffer input_buffer;
+    input_buffer.set_storage(input.data(), input.size(), 0, true);
+    lexer.reset();
+    lexer.prepend_start_of_file_char(input_buffer);
+    vector<string> serialized_tokens;
+    while (true) {
+        auto [err, optional_token]{lexer.scan(input_buffer)};
+        REQUIRE(ErrorCode::Success == err);
+        REQUIRE(optional_token.has_value());
+        auto& token{optional_token.value()};
+        auto const token_type{token.m_type_ids_ptr->at(0)};
+        serialized_tokens.emplace_back(fmt::format(
+                "{}:{}-{}:{}",
+                token.to_string(),
+                token.m_start_pos,
+                token.m_end_pos,
+                token_type
+        ));
+        if (static_cast<uint32_t>(SymbolId::TokenEnd) == token_type) {
+            return serialized_tokens;
+        }
+    }
+}
+
 auto serialize_id_symbol_map(unordered_map<rule_id_t, string> const& map) -> string {
     string serialized_map;
     for (auto const& [id, symbol] : map) {
@@ -301,6 +460,42 @@ TEST_CASE("single_line_with_capture", "[BufferParser]") {
     parse_and_validate(buffer_parser, cInput, {expected_event});
 }
 
+/**
+ * @ingroup test_buffer_parser_capture
+ * @brief Tests that a failed match of a variable with captures doesn't change the capture
+ * positions of the next match, whether it's in the same input or the next one, in every lexing
+ * mode.
+ */
+TEST_CASE("registers_reset_between_matches", "[BufferParser]") {
+    constexpr string_view cDelimitersSchema{R"(delimiters: \n\r\[:,)"};
+    constexpr string_view cVarSchema{R"(list:(x(?<item>[a-c]+))+y)"};
+    string unmatched_input{"xa"};
+    string input{"xbxcy z"};
+    string input_after_unmatched{"xa xbxcy z"};
+    vector<string> const expected_tokens{"xbxcy:0-5@0:8,3,4,2", " z:5-7@0:1"};
+    vector<string> const expected_tokens_after_unmatched{
+            "xa:0-2@0:1",
+            " xbxcy:2-8@0:8,6,7,5",
+            " z:8-10@0:1"
+    };
+
+    Schema schema;
+    schema.add_delimiters(cDelimitersSchema);
+    schema.add_variable(cVarSchema, -1);
+    BufferParser buffer_parser{std::move(schema.release_schema_ast_ptr())};
+    for (auto const lexing_mode :
+         {LexingMode::Incremental, LexingMode::Linear})
+    {
+        CAPTURE(lexing_mode);
+        buffer_parser.set_lexing_mode(lexing_mode);
+        REQUIRE(expected_tokens == parse_and_serialize(buffer_parser, input));
+        REQUIRE(expected_tokens_after_unmatched
+                == parse_and_serialize(buffer_parser, input_after_unmatched));
+        REQUIRE(false == parse_and_serialize(buffer_parser, unmatched_input).empty());
+        REQUIRE(expected_tokens == parse_and_serialize(buffer_parser, input));
+    }
+}
+
 /**
  * @defgroup test_buffer_parser_default_schema Buffer parser using the default schema.
  * @brief Tests for CLP's default variable schema: timestamp, int, float, hex, key-value pairs, etc.
@@ -853,3 +1048,833 @@ TEST_CASE("multi_line_with_delimited_vars", "[BufferParser]") {
 
     parse_and_validate(buffer_parser, cInput, {expected_event1, expected_event2});
 }
+
+/**
+ * @ingroup test_buffer_parser_no_capture
+ * @brief Tests that lexing in `LexingMode::Linear` produces the same tokens as
+ * `LexingMode::Incremental`.
+ *
+ * Random inputs are assembled from fragments that partially or fully match the variables of each
+ * schema, so that matches fail after crossing delimiters and newlines, and timestamps start new
+ * events. Every token of every event must be identical in every mode, including its position, line,
+ * type, and capture positions.
+ */
+TEST_CASE("linear_lexing_matches_incremental", "[BufferParser]") {
+    constexpr string_view cDelimitersSchema{R"(delimiters: \n\r\[:,)"};
+    constexpr uint32_t cNumInputs{300};
+    constexpr size_t cMaxNumFragments{40};
+    vector<vector<string_view>> const schemas_vars{
+            {R"(timestamp:[0-9]{4}\-[0-9]{2}\-[0-9]{2} [0-9]{2}:[0-9]{2}:[0-9]{2}[,\.][0-9]{0,3})",
+             R"(int:\-{0,1}[0-9]+)",
+             R"(float:\-{0,1}[0-9]+\.[0-9]+)",
+             R"(hex:[a-fA-F]+)",
+             R"(keyValuePair:[^ \r\n=]+=(?<val>[^ \r\n]*[A-Za-z0-9][^ \r\n]*))",
+             R"(hasNumber:={0,1}[^ \r\n=]*\d[^ \r\n=]*={0,1})"},
+            {"function:[A-Za-z]+::[A-Za-z]+1", R"(path:[a-zA-Z0-9_/\.\-]+/[a-zA-Z0-9_/\.\-]+)"},
+            {"myVar:userID=123"},
+            {"list:x( x)*y"}
+    };
+    vector<string_view> const fragments{
+            "2012-12-12 12:12:12.123",
+            "userID=",
+            "123",
+            "12.5",
+            "-7",
+            "abc",
+            "App",
+            "::",
+            "Action1",
+            "my/path",
+            "=",
+            " ",
+            " ",
+            ":",
+            ",",
+            "[",
+            "\n",
+            "\r",
+            "x",
+            " x x",
+            "y"
+    };
+
+    std::mt19937 generator{0};
+    std::uniform_int_distribution<size_t> fragment_distribution{0, fragments.size() - 1};
+    std::uniform_int_distribution<size_t> num_fragments_distribution{0, cMaxNumFragments};
+    for (auto const& vars : schemas_vars) {
+        Schema schema;
+        schema.add_delimiters(cDelimitersSchema);
+        for (auto const var : vars) {
+            schema.add_variable(var, -1);
+        }
+        BufferParser buffer_parser{std::move(schema.release_schema_ast_ptr())};
+
+        for (uint32_t input_idx{0}; input_idx < cNumInputs; ++input_idx) {
+            string input;
+            auto const num_fragments{num_fragments_distribution(generator)};
+            for (size_t i{0}; i < num_fragments; ++i) {
+                input += fragments[fragment_distribution(generator)];
+            }
+            CAPTURE(input);
+
+            buffer_parser.set_lexing_mode(LexingMode::Incremental);
+            auto const expected_tokens{parse_and_serialize(buffer_parser, input)};
+            buffer_parser.set_lexing_mode(LexingMode::Linear);
+            REQUIRE(expected_tokens == parse_and_serialize(buffer_parser, input));
+        }
+    }
+}
+
+/**
+ * @ingroup test_buffer_parser_capture
+ * @brief Tests that parsing with lazy captures produces the same tokens, capture positions, and
+ * logtypes as tracking the captures while lexing, in every lexing mode.
+ */
+TEST_CASE("lazy_captures_match_eager", "[BufferParser]") {
+    constexpr string_view cDelimitersSchema{R"(delimiters: \n\r\[:,)"};
+    constexpr uint32_t cNumInputs{200};
+    constexpr size_t cMaxNumFragments{40};
+    vector<string_view> const vars{
+            R"(int:\-{0,1}[0-9]+)",
+            R"(keyValuePair:[^ \r\n=]+=(?<val>[^ \r\n]*[A-Za-z0-9][^ \r\n]*))",
+            R"(hasNumber:={0,1}[^ \r\n=]*\d[^ \r\n=]*={0,1})",
+            R"(list:x(?<first>[a-c]+)( x(?<item>[a-c]+))*y)"
+    };
+    vector<string_view> const fragments{
+            "userID=", "123", "-7", "abc", "=", " ", " ", ":", ",", "\n", "xa", " xbc", " x", "y"
+    };
+
+    Schema schema;
+    schema.add_delimiters(cDelimitersSchema);
+    for (auto const var : vars) {
+        schema.add_variable(var, -1);
+    }
+    BufferParser buffer_parser{std::move(schema.release_schema_ast_ptr())};
+
+    std::mt19937 generator{0};
+    std::uniform_int_distribution<size_t> fragment_distribution{0, fragments.size() - 1};
+    std::uniform_int_distribution<size_t> num_fragments_distribution{0, cMaxNumFragments};
+    auto const parse_logtypes{[&](string& input) {
+        buffer_parser.reset();
+        vector<string> logtypes;
+        size_t buffer_offset{0};
+        while (false == buffer_parser.done()) {
+            auto const err{
+                    buffer_parser.parse_next_event(input.data(), input.size(), buffer_offset, true)
+            };
+            REQUIRE(ErrorCode::Success == err);
+            auto const& event{buffer_parser.get_log_parser().get_log_event_view()};
+            logtypes.emplace_back(event.get_logtype());
+        }
+        return logtypes;
+    }};
+    for (uint32_t input_idx{0}; input_idx < cNumInputs; ++input_idx) {
+        string input;
+        auto const num_fragments{num_fragments_distribution(generator)};
+        for (size_t i{0}; i < num_fragments; ++i) {
+            input += fragments[fragment_distribution(generator)];
+        }
+        CAPTURE(input);
+        for (auto const lexing_mode :
+             {LexingMode::Incremental, LexingMode::Linear})
+        {
+            buffer_parser.set_lexing_mode(lexing_mode);
+            buffer_parser.set_lazy_captures(false);
+            auto const expected_tokens{parse_and_serialize(buffer_parser, input)};
+            auto const expected_logtypes{parse_logtypes(input)};
+            buffer_parser.set_lazy_captures(true);
+            REQUIRE(expected_tokens == parse_and_serialize(buffer_parser, input));
+            REQUIRE(expected_logtypes == parse_logtypes(input));
+        }
+    }
+}
+
+/**
+ * @ingroup test_buffer_parser_capture
+ * @brief Tests that `Token::get_captures` yields the values of the matched captures in the order
+ * they start in the token, whatever order the captures are given in, both as a range and into a
+ * buffer too small for all of them.
+ */
+TEST_CASE("token_captures_in_positional_order", "[BufferParser]") {
+    constexpr string_view cDelimitersSchema{R"(delimiters: \n\r\[:,)"};
+    constexpr string_view cVarSchema{R"(pair:#(?<key>[a-z]+)=(?<val>\d+)(;(?<unit>[a-z]+)){0,1}#)"};
+    constexpr size_t cBufferSize{2};
+    vector<std::pair<string, vector<std::pair<string, string>>>> const inputs_and_captures{
+            {"event #ab=1# end", {{"key", "ab"}, {"val", "1"}}},
+            {"event #c=22;ms# end", {{"key", "c"}, {"val", "22"}, {"unit", "ms"}}}
+    };
+
+    Schema schema;
+    schema.add_delimiters(cDelimitersSchema);
+    schema.add_variable(cVarSchema, -1);
+    BufferParser buffer_parser{std::move(schema.release_schema_ast_ptr())};
+    auto const& lexer{buffer_parser.get_log_parser().m_lexer};
+    auto const rule_id{buffer_parser.get_log_parser().get_symbol_id("pair").value()};
+    auto const rule_capture_regs{lexer.get_capture_regs_from_rule_id(rule_id).value()};
+    vector<CaptureRegisters> const capture_regs{
+            rule_capture_regs.rbegin(),
+            rule_capture_regs.rend()
+    };
+
+    for (auto const& [input, expected_captures] : inputs_and_captures) {
+        for (auto const lazy_captures : {false, true}) {
+            CAPTURE(input);
+            CAPTURE(lazy_captures);
+            buffer_parser.reset();
+            buffer_parser.set_lazy_captures(lazy_captures);
+            string buffer{input};
+            size_t buffer_offset{0};
+            auto const err{buffer_parser.parse_next_event(
+                    buffer.data(),
+                    buffer.size(),
+                    buffer_offset,
+                    true
+            )};
+            REQUIRE(ErrorCode::Success == err);
+            auto const& output_buffer{
+                    buffer_parser.get_log_parser().get_log_event_view().get_log_output_buffer()
+            };
+            REQUIRE(2 < output_buffer->pos());
+            auto const& token{output_buffer->get_token(2)};
+            REQUIRE(rule_id == token.m_type_ids_ptr->at(0));
+
+            vector<std::pair<string, string>> actual_captures;
+            for (auto const& capture : token.get_captures(capture_regs)) {
+                REQUIRE(capture.m_wrapped_value.empty());
+                actual_captures.emplace_back(
+                        lexer.m_id_symbol.at(capture.m_capture_id),
+                        capture.m_value
+                );
+            }
+            REQUIRE(expected_captures == actual_captures);
+
+            std::array<TokenCapture, cBufferSize> captures{};
+            REQUIRE(expected_captures.size() == token.get_captures(capture_regs, captures));
+            for (size_t i{0}; i < cBufferSize; ++i) {
+                CAPTURE(i);
+                REQUIRE(expected_captures[i].first
+                        == lexer.m_id_symbol.at(captures[i].m_capture_id));
+                REQUIRE(expected_captures[i].second == captures[i].m_value);
+            }
+        }
+    }
+}
+
+/**
+ * @ingroup test_buffer_parser_no_capture
+ * @brief Tests that the value of a token wrapping around the end of the buffer is copied once for
+ * the token and its copies, however often it's viewed, and again only for a copy whose bounds
+ * differ.
+ */
+TEST_CASE("wrapped_token_value_copied_once", "[BufferParser]") {
+    constexpr string_view cBuffer{"cdeab"};
+    TokenSideStorage side_storage;
+    Token token{3, 2, cBuffer.data(), static_cast<uint32_t>(cBuffer.size()), 0, nullptr};
+    token.m_side_storage = &side_storage;
+    REQUIRE_THROWS_AS(token.to_string_view(), std::logic_error);
+    REQUIRE("abcd" == token.to_string());
+
+    token.m_side_entry_idx = side_storage.add_empty();
+    auto token_copy{token};
+    auto const value{token.to_string_view()};
+    REQUIRE("abcd" == value);
+    REQUIRE(value.data() == token.to_string_view().data());
+    REQUIRE(value.data() == token_copy.to_string_view().data());
+
+    auto shifted_token{token};
+    ++shifted_token.m_start_pos;
+    auto const shifted_value{shifted_token.to_string_view()};
+    REQUIRE("bcd" == shifted_value);
+    REQUIRE(shifted_value.data() == shifted_token.to_string_view().data());
+    REQUIRE("abcd" == value);
+}
+
+/**
+ * @ingroup test_buffer_parser_no_capture
+ * @brief Tests that a token scanned with wildcards that wraps around the end of the input buffer
+ * can be viewed contiguously, with its value copied once.
+ *
+ * The input buffer is read into a half at a time. The scan starts near the end of the second half,
+ * after which the first half is read into again with the rest of the input.
+ */
+TEST_CASE("wildcard_token_wrapping_buffer", "[BufferParser]") {
+    constexpr uint32_t cHalfSize{log_surgeon::cStaticByteBuffSize / 2};
+    constexpr uint32_t cScanStartPos{2 * cHalfSize - 100};
+    constexpr uint32_t cNumWrappedBytes{50};
+
+    ByteLexer lexer;
+    generate_lexer(lexer, " \n", {R"(word: [^ \n]+)"});
+
+    string input(cScanStartPos, 'x');
+    input += " ";
+    for (uint32_t i{1}; i < 2 * cHalfSize + cNumWrappedBytes - cScanStartPos; ++i) {
+        input += static_cast<char>('a' + i % 26);
+    }
+    size_t input_pos{0};
+    Reader reader{[&](char* buf, size_t const count, size_t& num_read) -> ErrorCode {
+        num_read = std::min(count, input.size() - input_pos);
+        if (0 == num_read) {
+            return ErrorCode::EndOfFile;
+        }
+        std::memcpy(buf, input.data() + input_pos, num_read);
+        input_pos += num_read;
+        return ErrorCode::Success;
+    }};
+
+    ParserInputBuffer input_buffer;
+    REQUIRE(ErrorCode::Success == input_buffer.read_if_safe(reader));
+    input_buffer.set_consumed_pos(1);
+    REQUIRE(ErrorCode::Success == input_buffer.read_if_safe(reader));
+    // Everything before the scan's start has been consumed, so the first half is read into again
+    input_buffer.set_pos(cScanStartPos);
+    input_buffer.set_consumed_pos(cScanStartPos - 1);
+    REQUIRE(ErrorCode::Success == input_buffer.read_if_safe(reader));
+    REQUIRE(input.size() == input_pos);
+
+    lexer.reset();
+    Token token;
+    REQUIRE(ErrorCode::Success == lexer.scan_with_wildcard(input_buffer, '*', token));
+    REQUIRE(cScanStartPos == token.m_start_pos);
+    REQUIRE(cNumWrappedBytes == token.m_end_pos);
+    auto const expected_value{string_view{input}.substr(cScanStartPos)};
+    REQUIRE(expected_value == token.to_string());
+    auto token_copy{token};
+    auto const value{token.to_string_view()};
+    REQUIRE(expected_value == value);
+    REQUIRE(value.data() == token_copy.to_string_view().data());
+}
+
+/**
+ * @ingroup test_buffer_parser_no_capture
+ * @brief Tests that an event with more tokens than fit in the static token buffer is parsed whole,
+ * with each token intact after the buffer grows.
+ */
+TEST_CASE("event_exceeding_static_token_buffer", "[BufferParser]") {
+    constexpr string_view cDelimitersSchema{R"(delimiters: \n\r\[:,)"};
+    constexpr string_view cVarSchema{R"(int:\-{0,1}[0-9]+)"};
+    constexpr uint32_t cNumInts{3 * log_surgeon::cStaticTokenBuffSize};
+
+    Schema schema;
+    schema.add_delimiters(cDelimitersSchema);
+    schema.add_variable(cVarSchema, -1);
+    BufferParser buffer_parser{std::move(schema.release_schema_ast_ptr())};
+    auto const int_id{buffer_parser.get_log_parser().get_symbol_id("int").value()};
+
+    string input{"event"};
+    for (uint32_t i{0}; i < cNumInts; ++i) {
+        input += fmt::format(" {}", i);
+    }
+    size_t buffer_offset{0};
+    auto const err{
+            buffer_parser.parse_next_event(input.data(), input.size(), buffer_offset, true)
+    };
+    REQUIRE(ErrorCode::Success == err);
+    auto const& event{buffer_parser.get_log_parser().get_log_event_view()};
+    REQUIRE(input == event.to_string());
+
+    // Without a timestamp, the first token is stored at index 1, followed by the ints
+    auto const& output_buffer{event.get_log_output_buffer()};
+    REQUIRE(cNumInts + 2 == output_buffer->pos());
+    for (uint32_t i{0}; i < cNumInts; ++i) {
+        CAPTURE(i);
+        auto token{output_buffer->get_token(i + 2)};
+        REQUIRE(int_id == token.m_type_ids_ptr->at(0));
+        REQUIRE(fmt::format(" {}", i) == token.to_string());
+    }
+}
+
+/**
+ * @ingroup test_buffer_parser_no_capture
+ * @brief Tests that `LexingMode::Linear` scans a constant number of bytes per input byte on an
+ * input that makes `LexingMode::Incremental` rescan it quadratically.
+ *
+ * Every match attempt of "list" runs to the end of the input before failing, after which the next
+ * attempt starts from the following delimiter.
+ */
+TEST_CASE("linear_lexing_bounds_scanned_bytes", "[BufferParser]") {
+    constexpr string_view cDelimitersSchema{R"(delimiters: \n\r\[:,)"};
+    constexpr string_view cVarSchema{"list:x( x)*y"};
+    constexpr uint32_t cMaxScannedBytesPerInputByte{8};
+
+    Schema schema;
+    schema.add_delimiters(cDelimitersSchema);
+    schema.add_variable(cVarSchema, -1);
+    BufferParser buffer_parser{std::move(schema.release_schema_ast_ptr())};
+
+    uint64_t prev_incremental_num_scanned_bytes_per_input_byte{0};
+    for (uint32_t const num_repetitions : {100U, 1000U, 4000U}) {
+        string input;
+        for (uint32_t i{0}; i < num_repetitions; ++i) {
+            input += " x";
+        }
+        CAPTURE(input.size());
+
+        buffer_parser.set_lexing_mode(LexingMode::Incremental);
+        auto const expected_tokens{parse_and_serialize(buffer_parser, input)};
+        auto const incremental_num_scanned_bytes_per_input_byte{
+                buffer_parser.get_log_parser().get_num_scanned_bytes() / input.size()
+        };
+        REQUIRE(incremental_num_scanned_bytes_per_input_byte
+                > prev_incremental_num_scanned_bytes_per_input_byte);
+        prev_incremental_num_scanned_bytes_per_input_byte
+                = incremental_num_scanned_bytes_per_input_byte;
+
+        buffer_parser.set_lexing_mode(LexingMode::Linear);
+        REQUIRE(expected_tokens == parse_and_serialize(buffer_parser, input));
+        REQUIRE(buffer_parser.get_log_parser().get_num_scanned_bytes()
+                <= input.size() * cMaxScannedBytesPerInputByte);
+    }
+    REQUIRE(prev_incremental_num_scanned_bytes_per_input_byte > cMaxScannedBytesPerInputByte);
+}
+
+/**
+ * @ingroup test_buffer_parser_no_capture
+ * @brief Tests that `LexingMode::Linear` doesn't repeat match attempts that fail before reaching
+ * another delimiter.
+ *
+ * Every match attempt of "int" fails at the "a" following its digit, after which
+ * `LexingMode::Incremental` repeats it from the delimiter it started at.
+ */
+TEST_CASE("linear_lexing_scans_failed_tokens_once", "[BufferParser]") {
+    constexpr string_view cDelimitersSchema{R"(delimiters: \n\r\[:,)"};
+    constexpr string_view cVarSchema{R"(int:\-{0,1}[0-9]+)"};
+    constexpr uint32_t cNumRepetitions{1000};
+
+    Schema schema;
+    schema.add_delimiters(cDelimitersSchema);
+    schema.add_variable(cVarSchema, -1);
+    BufferParser buffer_parser{std::move(schema.release_schema_ast_ptr())};
+
+    string input;
+    for (uint32_t i{0}; i < cNumRepetitions; ++i) {
+        input += " 1a";
+    }
+    buffer_parser.set_lexing_mode(LexingMode::Incremental);
+    auto const expected_tokens{parse_and_serialize(buffer_parser, input)};
+
+    buffer_parser.set_lexing_mode(LexingMode::Linear);
+    REQUIRE(expected_tokens == parse_and_serialize(buffer_parser, input));
+    // Marking the delimiters and scanning each byte once, besides looking ahead at the start of the
+    // input and at its end
+    REQUIRE(buffer_parser.get_log_parser().get_num_scanned_bytes() <= 2 * input.size() + 2);
+}
+
+/**
+ * @ingroup test_buffer_parser_no_capture
+ * @brief Tests that a delimiter bitmap built over an input buffer is only reused while the buffer's
+ * contents can't have changed.
+ */
+TEST_CASE("delimiter_bitmap_follows_input_buffer", "[BufferParser]") {
+    ByteSet delimiters;
+    delimiters.add(' ');
+    string input{"ab cd ef"};
+    auto const* begin{input.data()};
+    auto const* end{input.data() + input.size()};
+
+    ParserInputBuffer input_buffer;
+    DelimiterBitmap bitmap;
+    input_buffer.set_storage(input.data(), input.size(), 0, true);
+    REQUIRE(bitmap.build(delimiters, begin, end, input_buffer.get_generation()));
+    REQUIRE(begin + 2 == bitmap.find_next(begin));
+
+    // Storage promised to be unchanged keeps the bitmap
+    input_buffer.set_pos_in_unchanged_storage(3);
+    REQUIRE(3 == input_buffer.storage().pos());
+    REQUIRE(false == bitmap.build(delimiters, begin + 3, end, input_buffer.get_generation()));
+
+    // The same storage passed again may have been rewritten in place, so it doesn't
+    input = "abc d ef";
+    input_buffer.set_storage(input.data(), input.size(), 0, true);
+    REQUIRE(bitmap.build(delimiters, begin, end, input_buffer.get_generation()));
+    REQUIRE(begin + 3 == bitmap.find_next(begin));
+
+    // Neither does input that isn't finished yet, since more of it may be read into the storage
+    auto const generation{input_buffer.get_generation()};
+    input_buffer.set_storage(input.data(), input.size(), 0, false);
+    REQUIRE(generation != input_buffer.get_generation());
+    input_buffer.set_storage(input.data(), input.size(), 0, true);
+    REQUIRE(bitmap.build(delimiters, begin, end, input_buffer.get_generation()));
+}
+
+/**
+ * @ingroup test_buffer_parser_no_capture
+ * @brief Tests that events parsed from a buffer rewritten in place between calls reflect its new
+ * contents in every lexing mode, unless the caller promised not to rewrite it.
+ */
+TEST_CASE("buffer_rewritten_between_events", "[BufferParser]") {
+    constexpr string_view cDelimitersSchema{R"(delimiters: \n\r\[:,)"};
+    constexpr string_view cVarSchema{R"(int:\-{0,1}[0-9]+)"};
+    constexpr string_view cFirstEvent{"first 12 34\n"};
+    constexpr string_view cOriginalRest{"second 56 78\n"};
+    constexpr string_view cRewrittenRest{"second5 6 78\n"};
+
+    Schema schema;
+    schema.add_delimiters(cDelimitersSchema);
+    schema.add_variable(cVarSchema, -1);
+    BufferParser buffer_parser{std::move(schema.release_schema_ast_ptr())};
+
+    for (auto const lexing_mode :
+         {LexingMode::Incremental, LexingMode::Linear})
+    {
+        buffer_parser.set_lexing_mode(lexing_mode);
+        for (auto const input_unchanged_between_events : {false, true}) {
+            CAPTURE(lexing_mode);
+            CAPTURE(input_unchanged_between_events);
+            buffer_parser.set_input_unchanged_between_events(input_unchanged_between_events);
+            buffer_parser.reset();
+            string input{string{cFirstEvent} + string{cOriginalRest}};
+            size_t buffer_offset{0};
+            REQUIRE(ErrorCode::Success
+                    == buffer_parser.parse_next_event(
+                            input.data(),
+                            input.size(),
+                            buffer_offset,
+                            true
+                    ));
+            REQUIRE(cFirstEvent.size() == buffer_offset);
+
+            // Only rewrite the buffer when allowed
+            auto const& expected_rest{
+                    input_unchanged_between_events ? cOriginalRest : cRewrittenRest
+            };
+            input.replace(buffer_offset, expected_rest.size(), expected_rest);
+            REQUIRE(ErrorCode::Success
+                    == buffer_parser.parse_next_event(
+                            input.data(),
+                            input.size(),
+                            buffer_offset,
+                            true
+                    ));
+            auto const& event{buffer_parser.get_log_parser().get_log_event_view()};
+            REQUIRE(expected_rest == event.to_string());
+            auto const& output_buffer{event.get_log_output_buffer()};
+            string logtype;
+            for (uint32_t i{1}; i < output_buffer->pos(); ++i) {
+                auto token{output_buffer->get_token(i)};
+                logtype += token.to_string() + "|";
+            }
+            REQUIRE((input_unchanged_between_events ? "second| 56| 78|\n|"
+                                                     : "second5| 6| 78|\n|")
+                    == logtype);
+        }
+    }
+}
+
+/**
+ * @ingroup test_buffer_parser_no_capture
+ * @brief Tests that a lexer determinizing its DFA on demand produces the same tokens as one using a
+ * fully built DFA.
+ *
+ * The lazy lexers either cache every state, or only a few states, which forces them to flush their
+ * caches and eventually fall back to simulating the NFA.
+ */
+TEST_CASE("lazy_dfa_lexing_matches_eager", "[BufferParser]") {
+    constexpr string_view cDelimiters{" \n\r[:,"};
+    constexpr uint32_t cNumInputs{100};
+    constexpr size_t cMaxNumFragments{40};
+    vector<vector<string_view>> const schemas_vars{
+            {R"(int:\-{0,1}[0-9]+)",
+             R"(float:\-{0,1}[0-9]+\.[0-9]+)",
+             R"(hex:[a-fA-F]+)",
+             R"(hasNumber:={0,1}[^ \r\n=]*\d[^ \r\n=]*={0,1})"},
+            {"function:[A-Za-z]+::[A-Za-z]+1", R"(path:[a-zA-Z0-9_/\.\-]+/[a-zA-Z0-9_/\.\-]+)"},
+            {"list:x( x)*y"},
+            {"var:(a|b)*a(a|b){5}"}
+    };
+    vector<string_view> const fragments{
+            "123",
+            "12.5",
+            "-7",
+            "abc",
+            "App",
+            "::",
+            "Action1",
+            "my/path",
+            "=",
+            " ",
+            " ",
+            ":",
+            ",",
+            "[",
+            "\n",
+            "\r",
+            "x",
+            " x x",
+            "y",
+            "a",
+            "b",
+            "ba",
+            "ab"
+    };
+
+    std::mt19937 generator{0};
+    std::uniform_int_distribution<size_t> fragment_distribution{0, fragments.size() - 1};
+    std::uniform_int_distribution<size_t> num_fragments_distribution{1, cMaxNumFragments};
+    bool is_any_simulating_nfa{false};
+    for (auto const& vars : schemas_vars) {
+        ByteLexer eager_lexer;
+        generate_lexer(eager_lexer, cDelimiters, vars);
+        REQUIRE(nullptr == eager_lexer.get_lazy_dfa());
+        vector<std::unique_ptr<ByteLexer>> lazy_lexers;
+        for (auto const max_num_lazy_dfa_states :
+             {ByteLexer::cDefaultMaxNumLazyDfaStates, size_t{6}})
+        {
+            auto& lazy_lexer{*lazy_lexers.emplace_back(std::make_unique<ByteLexer>())};
+            lazy_lexer.set_lazy_dfa(true);
+            lazy_lexer.set_max_num_lazy_dfa_states(max_num_lazy_dfa_states);
+            generate_lexer(lazy_lexer, cDelimiters, vars);
+            REQUIRE(nullptr == lazy_lexer.get_dfa());
+            REQUIRE(nullptr != lazy_lexer.get_lazy_dfa());
+        }
+
+        for (uint32_t input_idx{0}; input_idx < cNumInputs; ++input_idx) {
+            string input;
+            auto const num_fragments{num_fragments_distribution(generator)};
+            for (size_t i{0}; i < num_fragments; ++i) {
+                input += fragments[fragment_distribution(generator)];
+            }
+            CAPTURE(input);
+
+            auto const expected_tokens{lex_and_serialize(eager_lexer, input)};
+            for (auto const& lazy_lexer : lazy_lexers) {
+                for (auto const lexing_mode :
+                     {LexingMode::Incremental, LexingMode::Linear})
+                {
+                    lazy_lexer->set_lexing_mode(lexing_mode);
+                    REQUIRE(expected_tokens == lex_and_serialize(*lazy_lexer, input));
+                }
+            }
+        }
+        REQUIRE(0 == lazy_lexers.front()->get_lazy_dfa()->get_num_flushes());
+        is_any_simulating_nfa |= lazy_lexers.back()->get_lazy_dfa()->is_simulating_nfa();
+    }
+    REQUIRE(is_any_simulating_nfa);
+}
+
+/**
+ * @ingroup test_buffer_parser_budget
+ * @brief Rejects schemas with oversized counted repetitions before building their automata.
+ */
+TEST_CASE("oversized_counted_repetition", "[BufferParser]") {
+    constexpr string_view cDelimitersSchema{R"(delimiters: \n\r\[:,)"};
+
+    Schema schema;
+    schema.add_delimiters(cDelimitersSchema);
+    schema.add_variable("hex:[0-9a-f]{32}", -1);
+    schema.add_variable("blob:(.{0,1000}x){0,1000}", -1);
+    REQUIRE_THROWS_AS(
+            BufferParser{std::move(schema.release_schema_ast_ptr())},
+            std::invalid_argument
+    );
+}
+
+/**
+ * @ingroup test_buffer_parser_budget
+ * @brief Tests that exceeding the maximum number of DFA states fails with `DfaStateLimitExceeded`
+ * unless the lazy DFA is enabled for rules without captures.
+ *
+ * The lazy DFA must keep `LexingMode::Linear`'s bound on the number of scanned bytes, even when its
+ * cache is flushed.
+ */
+TEST_CASE("dfa_state_limit", "[BufferParser]") {
+    constexpr string_view cDelimiters{" \n\r[:,"};
+    constexpr size_t cMaxNumDfaStates{4};
+    constexpr uint32_t cNumRepetitions{1000};
+    constexpr uint32_t cMaxScannedBytesPerInputByte{8};
+
+    ByteLexer eager_lexer;
+    eager_lexer.set_max_num_dfa_states(cMaxNumDfaStates);
+    REQUIRE_THROWS_AS(
+            generate_lexer(eager_lexer, cDelimiters, {"var:(a|b)*a(a|b){3}"}),
+            DfaStateLimitExceeded
+    );
+
+    ByteLexer lexer;
+    lexer.set_max_num_dfa_states(cMaxNumDfaStates);
+    lexer.set_lazy_dfa(true);
+    generate_lexer(lexer, cDelimiters, {"var:(a|b)*a(a|b){3}"});
+    REQUIRE(nullptr == lexer.get_dfa());
+    REQUIRE(nullptr != lexer.get_lazy_dfa());
+
+    // The rules start with their delimiter, so that every failed attempt of "list" runs to the end
+    // of the input, while matching "var" flushes the cache between them
+    ByteLexer linear_lexer;
+    linear_lexer.set_max_num_dfa_states(cMaxNumDfaStates);
+    linear_lexer.set_lazy_dfa(true);
+    linear_lexer.set_max_num_lazy_dfa_states(cMaxNumDfaStates);
+    generate_lexer(linear_lexer, cDelimiters, {"var: (a|b)*a(a|b){3}", "list: x( x)*y"});
+    REQUIRE(nullptr != linear_lexer.get_lazy_dfa());
+    string input;
+    for (uint32_t i{1}; i <= cNumRepetitions; ++i) {
+        input += 0 == i % 100 ? " abbbaabab" : " x";
+    }
+    linear_lexer.set_lexing_mode(LexingMode::Incremental);
+    auto const expected_tokens{lex_and_serialize(linear_lexer, input)};
+    linear_lexer.set_lexing_mode(LexingMode::Linear);
+    REQUIRE(expected_tokens == lex_and_serialize(linear_lexer, input));
+    REQUIRE(linear_lexer.get_num_scanned_bytes() <= input.size() * cMaxScannedBytesPerInputByte);
+    REQUIRE(0 < linear_lexer.get_lazy_dfa()->get_num_flushes());
+
+    ByteLexer capture_lexer;
+    capture_lexer.set_max_num_dfa_states(cMaxNumDfaStates);
+    capture_lexer.set_lazy_dfa(true);
+    REQUIRE_THROWS_AS(
+            generate_lexer(capture_lexer, cDelimiters, {"var:(a|b)*a(?<tail>(a|b){3})"}),
+            DfaStateLimitExceeded
+    );
+}
+
+/**
+ * @ingroup test_buffer_parser_no_capture
+ * @brief Tests that counted repetitions match exactly the lengths their bounds allow.
+ */
+TEST_CASE("counted_repetition_bounds", "[BufferParser]") {
+    constexpr string_view cDelimitersSchema{R"(delimiters: \n\r\[:,)"};
+    constexpr size_t cMaxNumDigits{19};
+
+    Schema schema;
+    schema.add_delimiters(cDelimitersSchema);
+    schema.add_variable(R"(digits:\d{1,19})", -1);
+    schema.add_variable("bs:a{0,3}b", -1);
+    BufferParser buffer_parser{std::move(schema.release_schema_ast_ptr())};
+
+    for (size_t num_digits{1}; num_digits <= cMaxNumDigits + 1; ++num_digits) {
+        CAPTURE(num_digits);
+        string const input(num_digits, '7');
+        bool const is_match{num_digits <= cMaxNumDigits};
+        ExpectedEvent const expected_event{
+                .m_logtype{is_match ? string_view{"<digits>"} : string_view{input}},
+                .m_timestamp_raw{""},
+                .m_tokens{{{input, is_match ? "digits" : "", {}}}}
+        };
+        parse_and_validate(buffer_parser, input, {expected_event});
+    }
+
+    constexpr string_view cInput{"b ab aaab aaaab"};
+    ExpectedEvent const expected_event{
+            .m_logtype{"<bs> <bs> <bs> aaaab"},
+            .m_timestamp_raw{""},
+            .m_tokens{
+                    {{"b", "bs", {}}, {" ab", "bs", {}}, {" aaab", "bs", {}}, {" aaaab", "", {}}}
+            }
+    };
+    parse_and_validate(buffer_parser, cInput, {expected_event});
+}
+
+/**
+ * @ingroup test_buffer_parser_capture
+ * @brief Tests that parsers constructed from a serialized lexer, or from a mapped file of a lexer
+ * image, parse like the parser whose lexer was serialized, and that invalid serialized lexers and
+ * images are rejected.
+ */
+TEST_CASE("serialized_lexer_parses_like_generated", "[BufferParser]") {
+    constexpr string_view cDelimitersSchema{R"(delimiters: \n\r\[:,)"};
+    constexpr uint32_t cNumInputs{100};
+    constexpr size_t cMaxNumFragments{40};
+    vector<string_view> const vars{
+            R"(timestamp:[0-9]{4}\-[0-9]{2}\-[0-9]{2} [0-9]{2}:[0-9]{2}:[0-9]{2}[,\.][0-9]{0,3})",
+            R"(int:\-{0,1}[0-9]+)",
+            R"(keyValuePair:[^ \r\n=]+=(?<val>[^ \r\n]*[A-Za-z0-9][^ \r\n]*))",
+            R"(hasNumber:={0,1}[^ \r\n=]*\d[^ \r\n=]*={0,1})",
+            "list:x( x)*y"
+    };
+    vector<string_view> const fragments{
+            "2012-12-12 12:12:12.123",
+            "userID=",
+            "123",
+            "-7",
+            "abc",
+            "=",
+            " ",
+            ":",
+            "\n",
+            "x",
+            " x x",
+            "y"
+    };
+
+    Schema schema;
+    schema.add_delimiters(cDelimitersSchema);
+    for (auto const var : vars) {
+        schema.add_variable(var, -1);
+    }
+    BufferParser buffer_parser{std::move(schema.release_schema_ast_ptr())};
+    auto const serialized_lexer{buffer_parser.get_log_parser().serialize_lexer()};
+    BufferParser loaded_buffer_parser{serialized_lexer};
+    REQUIRE(serialized_lexer == loaded_buffer_parser.get_log_parser().serialize_lexer());
+    for (auto const var : vars) {
+        auto const name{string{var.substr(0, var.find(':'))}};
+        REQUIRE(buffer_parser.get_log_parser().get_symbol_id(name)
+                == loaded_buffer_parser.get_log_parser().get_symbol_id(name));
+    }
+
+    auto const lexer_image{buffer_parser.get_log_parser().serialize_lexer_image()};
+    {
+        // Images only depend on the schema, so independently generated lexers have the same image
+        Schema same_schema;
+        same_schema.add_delimiters(cDelimitersSchema);
+        for (auto const var : vars) {
+            same_schema.add_variable(var, -1);
+        }
+        BufferParser const same_buffer_parser{std::move(same_schema.release_schema_ast_ptr())};
+        REQUIRE(lexer_image == same_buffer_parser.get_log_parser().serialize_lexer_image());
+    }
+    auto const lexer_image_path{
+            std::filesystem::temp_directory_path() / "log-surgeon-test-lexer-image.bin"
+    };
+    {
+        std::ofstream lexer_image_file{lexer_image_path, std::ios::binary};
+        lexer_image_file.write(
+                reinterpret_cast<char const*>(lexer_image.data()),
+                static_cast<std::streamsize>(lexer_image.size())
+        );
+    }
+    BufferParser mapped_buffer_parser{
+            std::make_shared<log_surgeon::MappedFile const>(lexer_image_path.string())
+    };
+    std::filesystem::remove(lexer_image_path);
+    REQUIRE(nullptr == mapped_buffer_parser.get_log_parser().m_lexer.get_dfa());
+    REQUIRE(lexer_image == mapped_buffer_parser.get_log_parser().serialize_lexer_image());
+
+    std::mt19937 generator{0};
+    std::uniform_int_distribution<size_t> fragment_distribution{0, fragments.size() - 1};
+    std::uniform_int_distribution<size_t> num_fragments_distribution{0, cMaxNumFragments};
+    for (uint32_t input_idx{0}; input_idx < cNumInputs; ++input_idx) {
+        string input;
+        auto const num_fragments{num_fragments_distribution(generator)};
+        for (size_t i{0}; i < num_fragments; ++i) {
+            input += fragments[fragment_distribution(generator)];
+        }
+        CAPTURE(input);
+        for (auto const lexing_mode :
+             {LexingMode::Incremental, LexingMode::Linear})
+        {
+            buffer_parser.set_lexing_mode(lexing_mode);
+            loaded_buffer_parser.set_lexing_mode(lexing_mode);
+            mapped_buffer_parser.set_lexing_mode(lexing_mode);
+            auto const serialized_tokens{parse_and_serialize(buffer_parser, input)};
+            REQUIRE(serialized_tokens == parse_and_serialize(loaded_buffer_parser, input));
+            REQUIRE(serialized_tokens == parse_and_serialize(mapped_buffer_parser, input));
+        }
+    }
+
+    auto corrupted_lexer{serialized_lexer};
+    corrupted_lexer.back() ^= 1U;
+    REQUIRE_THROWS_AS(BufferParser{corrupted_lexer}, std::runtime_error);
+    auto const truncated_lexer{std::span{serialized_lexer}.first(serialized_lexer.size() / 2)};
+    REQUIRE_THROWS_AS(BufferParser{truncated_lexer}, std::runtime_error);
+    auto newer_lexer{serialized_lexer};
+    ++newer_lexer[sizeof(uint32_t)];
+    REQUIRE_THROWS_AS(BufferParser{newer_lexer}, std::runtime_error);
+
+    ByteLexer image_lexer;
+    REQUIRE_THROWS_AS(image_lexer.load_image(serialized_lexer), std::runtime_error);
+    REQUIRE_THROWS_AS(image_lexer.load_binary(lexer_image), std::runtime_error);
+    auto corrupted_image{lexer_image};
+    corrupted_image.back() ^= 1U;
+    REQUIRE_THROWS_AS(image_lexer.load_image(corrupted_image), std::runtime_error);
+    REQUIRE_THROWS_AS(
+            image_lexer.load_image(std::span{lexer_image}.first(lexer_image.size() / 2)),
+            std::runtime_error
+    );
+}
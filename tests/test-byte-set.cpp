@@ -0,0 +1,155 @@
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <log_surgeon/ByteSet.hpp>
+#include <log_surgeon/Constants.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+/**
+ * @defgroup unit_tests_byte_set Byte set unit tests.
+ * @brief Byte set related unit tests.
+
+ * These unit tests contain the `ByteSet` tag.
+ */
+
+using log_surgeon::ByteSet;
+using log_surgeon::cSizeOfByte;
+
+namespace {
+/**
+ * @param byte_set
+ * @param begin
+ * @param end
+ * @return A pointer to the first member of `byte_set` in [begin, end), or `end` if there is none.
+ */
+[[nodiscard]] auto find_first_expected(ByteSet const& byte_set, char const* begin, char const* end)
+        -> char const*;
+
+auto find_first_expected(ByteSet const& byte_set, char const* begin, char const* end)
+        -> char const* {
+    for (auto const* pos{begin}; pos < end; ++pos) {
+        if (byte_set.contains(static_cast<uint8_t>(*pos))) {
+            return pos;
+        }
+    }
+    return end;
+}
+}  // namespace
+
+/**
+ * @ingroup unit_tests_byte_set
+ * @brief Tests that every supported kernel finds the first member of the set.
+ *
+ * The test covers the following cases:
+ * - Members at every offset of a block, including bytes with the most significant bit set.
+ * - Random sets and inputs of lengths that are not a multiple of the block size.
+ */
+TEST_CASE("find_first", "[ByteSet]") {
+    constexpr std::array cKernels{
+            ByteSet::Kernel::Scalar,
+            ByteSet::Kernel::Sse42,
+            ByteSet::Kernel::Avx2
+    };
+
+    SECTION("Finds every member at every offset") {
+        constexpr size_t cInputLength{70};
+        for (uint32_t member{0}; member < cSizeOfByte; ++member) {
+            std::array<bool, cSizeOfByte> is_member{};
+            is_member[member] = true;
+            ByteSet const byte_set{is_member};
+            REQUIRE(1 == byte_set.size());
+            auto const non_member{static_cast<char>(member + 1)};
+            for (size_t offset{0}; offset < cInputLength; ++offset) {
+                std::string input(cInputLength, non_member);
+                input[offset] = static_cast<char>(member);
+                auto const* begin{input.data()};
+                auto const* end{input.data() + input.size()};
+                for (auto const kernel : cKernels) {
+                    if (false == ByteSet::is_kernel_supported(kernel)) {
+                        continue;
+                    }
+                    REQUIRE(begin + offset == byte_set.find_first(begin, end, kernel));
+                    REQUIRE(end == byte_set.find_first(begin + offset + 1, end, kernel));
+                }
+            }
+        }
+    }
+
+    SECTION("Matches the scalar search on random sets") {
+        constexpr uint32_t cNumSets{64};
+        constexpr size_t cMaxInputLength{200};
+        std::mt19937 generator{0};
+        std::uniform_int_distribution<uint32_t> byte_distribution{0, cSizeOfByte - 1};
+        std::uniform_int_distribution<uint32_t> set_size_distribution{0, 8};
+        std::uniform_int_distribution<size_t> length_distribution{0, cMaxInputLength};
+        for (uint32_t set_idx{0}; set_idx < cNumSets; ++set_idx) {
+            ByteSet byte_set;
+            auto const set_size{set_size_distribution(generator)};
+            for (uint32_t i{0}; i < set_size; ++i) {
+                byte_set.add(static_cast<uint8_t>(byte_distribution(generator)));
+            }
+            std::string input(length_distribution(generator), '\0');
+            for (auto& c : input) {
+                c = static_cast<char>(byte_distribution(generator));
+            }
+            auto const* begin{input.data()};
+            auto const* end{input.data() + input.size()};
+            auto const* expected{find_first_expected(byte_set, begin, end)};
+            REQUIRE(expected == byte_set.find_first(begin, end));
+            for (auto const kernel : cKernels) {
+                if (ByteSet::is_kernel_supported(kernel)) {
+                    REQUIRE(expected == byte_set.find_first(begin, end, kernel));
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @ingroup unit_tests_byte_set
+ * @brief Tests that every supported kernel marks every member of the set in a bitmap.
+ */
+TEST_CASE("find_all", "[ByteSet]") {
+    constexpr std::array cKernels{
+            ByteSet::Kernel::Scalar,
+            ByteSet::Kernel::Sse42,
+            ByteSet::Kernel::Avx2
+    };
+    constexpr uint32_t cNumSets{64};
+    constexpr size_t cMaxInputLength{300};
+    constexpr size_t cBitsPerWord{64};
+    std::mt19937 generator{0};
+    std::uniform_int_distribution<uint32_t> byte_distribution{0, cSizeOfByte - 1};
+    std::uniform_int_distribution<uint32_t> set_size_distribution{0, 16};
+    std::uniform_int_distribution<size_t> length_distribution{0, cMaxInputLength};
+    for (uint32_t set_idx{0}; set_idx < cNumSets; ++set_idx) {
+        ByteSet byte_set;
+        auto const set_size{set_size_distribution(generator)};
+        for (uint32_t i{0}; i < set_size; ++i) {
+            byte_set.add(static_cast<uint8_t>(byte_distribution(generator)));
+        }
+        std::string input(length_distribution(generator), '\0');
+        for (auto& c : input) {
+            c = static_cast<char>(byte_distribution(generator));
+        }
+        std::vector<uint64_t> expected((input.size() + cBitsPerWord - 1) / cBitsPerWord, 0);
+        for (size_t i{0}; i < input.size(); ++i) {
+            if (byte_set.contains(static_cast<uint8_t>(input[i]))) {
+                expected[i / cBitsPerWord] |= uint64_t{1} << (i % cBitsPerWord);
+            }
+        }
+        for (auto const kernel : cKernels) {
+            if (false == ByteSet::is_kernel_supported(kernel)) {
+                continue;
+            }
+            std::vector<uint64_t> bitmap(expected.size(), 0);
+            byte_set.find_all(input.data(), input.data() + input.size(), bitmap.data(), kernel);
+            REQUIRE(expected == bitmap);
+        }
+    }
+}
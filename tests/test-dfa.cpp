@@ -1,12 +1,30 @@
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <random>
+#include <set>
+#include <span>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include <log_surgeon/BinarySerialization.hpp>
+#include <log_surgeon/ByteSet.hpp>
+#include <log_surgeon/Constants.hpp>
+#include <log_surgeon/finite_automata/ByteClassMap.hpp>
 #include <log_surgeon/finite_automata/Dfa.hpp>
 #include <log_surgeon/finite_automata/DfaState.hpp>
+#include <log_surgeon/finite_automata/LazyDfa.hpp>
 #include <log_surgeon/finite_automata/Nfa.hpp>
 #include <log_surgeon/finite_automata/NfaState.hpp>
+#include <log_surgeon/finite_automata/RegisterOperation.hpp>
+#include <log_surgeon/finite_automata/RuntimeDfa.hpp>
 #include <log_surgeon/LexicalRule.hpp>
 #include <log_surgeon/Schema.hpp>
 #include <log_surgeon/SchemaParser.hpp>
@@ -20,10 +38,21 @@
  * These unit tests contain the `DFA` tag.
  */
 
+using log_surgeon::BinaryReader;
+using log_surgeon::BinaryWriter;
+using log_surgeon::ByteSet;
+using log_surgeon::finite_automata::ByteClassMap;
 using log_surgeon::finite_automata::ByteDfaState;
 using log_surgeon::finite_automata::ByteNfaState;
+using log_surgeon::finite_automata::DfaMinimizationStats;
+using log_surgeon::finite_automata::DfaStats;
+using log_surgeon::finite_automata::LazyDfa;
+using log_surgeon::finite_automata::RegisterOperation;
+using log_surgeon::finite_automata::RuntimeDfa;
+using log_surgeon::reg_id_t;
 using log_surgeon::Schema;
 using log_surgeon::SchemaVarAST;
+using log_surgeon::tag_id_t;
 using std::string;
 using std::stringstream;
 using std::vector;
@@ -33,6 +62,18 @@ using ByteLexicalRule = log_surgeon::LexicalRule<ByteNfaState>;
 using ByteNfa = log_surgeon::finite_automata::Nfa<ByteNfaState>;
 
 namespace {
+/**
+ * @param var_schemas Vector of variable schemas from which to construct the rules.
+ * @return The lexical rules for the given variable schemas, with variable IDs in schema order.
+ */
+auto get_rules(std::vector<string> const& var_schemas) -> vector<ByteLexicalRule>;
+
+/**
+ * @param var_schemas Vector of variable schemas from which to construct the NFA.
+ * @return The NFA for the given variable schemas.
+ */
+auto get_nfa(std::vector<string> const& var_schemas) -> ByteNfa;
+
 /**
  * Generates a DFA for the given variable schemas, then serializes the DFA and compares it with
  * `expected_serialized_dfa`.
@@ -43,8 +84,102 @@ namespace {
 auto test_dfa(std::vector<string> const& var_schemas, string const& expected_serialized_dfa)
         -> void;
 
-auto test_dfa(std::vector<string> const& var_schemas, string const& expected_serialized_dfa)
-        -> void {
+/**
+ * Generates a DFA for the given variable schemas and compiles it into a `RuntimeDfa`. Then, for
+ * every input, simulates both automata side by side and compares every transition, including its
+ * register operations, and every reached state's matching variables and accepting operations.
+ *
+ * @param var_schemas Vector of variable schemas from which to construct the DFA.
+ * @param inputs The inputs to simulate.
+ */
+auto test_runtime_dfa(std::vector<string> const& var_schemas, std::vector<string> const& inputs)
+        -> void;
+
+/**
+ * Generates a DFA for the given variable schemas and a minimized copy of it. Then, for every input,
+ * simulates both automata side by side and compares every transition's register operations, and
+ * every reached state's matching variables and accepting operations.
+ *
+ * @param var_schemas Vector of variable schemas from which to construct the DFA.
+ * @param inputs The inputs to simulate.
+ * @return The stats returned by `Dfa::minimize`.
+ */
+auto test_minimized_dfa(std::vector<string> const& var_schemas, std::vector<string> const& inputs)
+        -> DfaMinimizationStats;
+
+/**
+ * Generates a DFA for the given variable schemas and a copy of it with optimized registers, and
+ * checks that no transition reachable from an accepting state of the copy overwrites the final
+ * registers read there. Then, for every prefix of every input, simulates both automata from empty
+ * registers and, if the prefix is accepted, compares the positions each matching variable's tags
+ * are set to. Finally, for every input, simulates both automata like the lexer does, executing the
+ * accepting operations of every accepting state reached and continuing until the automata die, and
+ * compares the positions the tags of the last accepting state's variables are set to.
+ *
+ * @param var_schemas Vector of variable schemas from which to construct the DFA.
+ * @param inputs The inputs to simulate.
+ * @return The stats of the DFA before and after optimizing its registers.
+ */
+auto test_optimized_registers(
+        std::vector<string> const& var_schemas,
+        std::vector<string> const& inputs
+) -> std::pair<DfaStats, DfaStats>;
+
+/**
+ * Generates a DFA for the given variable schemas, and a lazy DFA for them that caches at most
+ * `max_num_cached_states` states. Then, for every input, simulates both automata side by side and
+ * compares every reached state's matching variables.
+ *
+ * @param var_schemas Vector of variable schemas from which to construct the DFAs.
+ * @param inputs The inputs to simulate.
+ * @param max_num_cached_states
+ * @return The lazy DFA's number of flushes, and whether it ended up simulating the NFA.
+ */
+auto test_lazy_dfa(
+        std::vector<string> const& var_schemas,
+        std::vector<string> const& inputs,
+        size_t max_num_cached_states
+) -> std::pair<uint64_t, bool>;
+
+/**
+ * Generates a DFA for the given variable schemas, serializes it in binary form, and loads it back.
+ * Then compares the loaded DFA's text serialization and final registers with the original's.
+ *
+ * @param var_schemas Vector of variable schemas from which to construct the DFA.
+ * @return The binary serialization of the DFA.
+ */
+auto test_binary_serialization(std::vector<string> const& var_schemas) -> vector<uint8_t>;
+
+/**
+ * Generates a DFA for the given variable schemas, compiles it into a `RuntimeDfa`, writes the
+ * runtime DFA to an image, and loads the image back. Then compares the loaded table's image with
+ * the original.
+ *
+ * @param var_schemas Vector of variable schemas from which to construct the DFA.
+ * @param accelerate Whether to accelerate the runtime DFA's states before writing the image.
+ * @return The image and the DFA's number of registers.
+ */
+auto test_runtime_dfa_image(std::vector<string> const& var_schemas, bool accelerate)
+        -> std::pair<vector<uint8_t>, size_t>;
+
+/**
+ * @param image An image written by `RuntimeDfa::serialize_image`.
+ * @return The offset of the root in the image, followed by the offsets of the image's tables in the
+ * order they are written.
+ */
+auto get_runtime_dfa_image_offsets(std::span<uint8_t const> image) -> vector<size_t>;
+
+/**
+ * Generates a DFA for the given variable schemas on a single thread, and again on `num_threads`
+ * threads. Then compares both DFAs' text and binary serializations and final registers.
+ *
+ * @param var_schemas Vector of variable schemas from which to construct the DFAs.
+ * @param num_threads
+ */
+auto test_parallel_determinization(std::vector<string> const& var_schemas, size_t num_threads)
+        -> void;
+
+auto get_rules(std::vector<string> const& var_schemas) -> vector<ByteLexicalRule> {
     Schema schema;
     for (auto const& var_schema : var_schemas) {
         schema.add_variable(var_schema, -1);
@@ -55,7 +190,16 @@ auto test_dfa(std::vector<string> const& var_schemas, string const& expected_ser
         auto& capture_rule_ast = dynamic_cast<SchemaVarAST&>(*schema_ast->m_schema_vars[i]);
         rules.emplace_back(i, std::move(capture_rule_ast.m_regex_ptr));
     }
-    ByteNfa const nfa{rules};
+    return rules;
+}
+
+auto get_nfa(std::vector<string> const& var_schemas) -> ByteNfa {
+    return ByteNfa{get_rules(var_schemas)};
+}
+
+auto test_dfa(std::vector<string> const& var_schemas, string const& expected_serialized_dfa)
+        -> void {
+    auto const nfa{get_nfa(var_schemas)};
     ByteDfa const dfa{nfa};
 
     // Compare expected and actual line-by-line
@@ -76,6 +220,346 @@ auto test_dfa(std::vector<string> const& var_schemas, string const& expected_ser
     getline(ss_expected, expected_line);
     REQUIRE(expected_line.empty());
 }
+
+auto test_runtime_dfa(std::vector<string> const& var_schemas, std::vector<string> const& inputs)
+        -> void {
+    auto const nfa{get_nfa(var_schemas)};
+    ByteDfa const dfa{nfa};
+    RuntimeDfa const runtime_dfa{dfa};
+    REQUIRE(dfa.get_bfs_traversal_order().size() + 1 == runtime_dfa.get_num_states());
+
+    for (auto const& input : inputs) {
+        CAPTURE(input);
+        auto const* state{dfa.get_root()};
+        auto runtime_state{runtime_dfa.get_root()};
+        for (auto const c : input) {
+            auto const byte{static_cast<uint8_t>(c)};
+            auto const& optional_transition{state->get_transition(byte)};
+            auto const transition_idx{runtime_dfa.get_transition_idx(runtime_state, byte)};
+            runtime_state = runtime_dfa.get_next_state(transition_idx);
+            if (false == optional_transition.has_value()) {
+                REQUIRE(RuntimeDfa::cDeadState == runtime_state);
+                REQUIRE(RuntimeDfa::cDeadState == runtime_dfa.get_next_state(runtime_state, byte));
+                break;
+            }
+            auto const runtime_reg_ops{runtime_dfa.get_transition_reg_ops(transition_idx)};
+            REQUIRE(optional_transition->get_reg_ops()
+                    == vector(runtime_reg_ops.begin(), runtime_reg_ops.end()));
+
+            state = optional_transition->get_dest_state();
+            REQUIRE(state->is_accepting() == RuntimeDfa::is_accepting(runtime_state));
+            REQUIRE(state->get_matching_variable_ids()
+                    == runtime_dfa.get_matching_variable_ids(runtime_state));
+            auto const runtime_accepting_ops{runtime_dfa.get_accepting_reg_ops(runtime_state)};
+            REQUIRE(state->get_accepting_reg_ops()
+                    == vector(runtime_accepting_ops.begin(), runtime_accepting_ops.end()));
+        }
+    }
+}
+
+auto test_minimized_dfa(std::vector<string> const& var_schemas, std::vector<string> const& inputs)
+        -> DfaMinimizationStats {
+    auto const nfa{get_nfa(var_schemas)};
+    ByteDfa const dfa{nfa};
+    ByteDfa minimized_dfa{nfa};
+    REQUIRE(false == minimized_dfa.get_minimization_stats().has_value());
+    auto const stats{minimized_dfa.minimize()};
+    REQUIRE(minimized_dfa.get_minimization_stats().has_value());
+    REQUIRE(dfa.get_stats().m_num_states == stats.m_before.m_num_states);
+    REQUIRE(dfa.get_stats().m_num_bytes == stats.m_before.m_num_bytes);
+    REQUIRE(minimized_dfa.get_stats().m_num_states == stats.m_after.m_num_states);
+    REQUIRE(minimized_dfa.get_bfs_traversal_order().size() == stats.m_after.m_num_states);
+
+    for (auto const& input : inputs) {
+        CAPTURE(input);
+        auto const* state{dfa.get_root()};
+        auto const* minimized_state{minimized_dfa.get_root()};
+        for (auto const c : input) {
+            auto const byte{static_cast<uint8_t>(c)};
+            auto const& optional_transition{state->get_transition(byte)};
+            auto const& optional_minimized_transition{minimized_state->get_transition(byte)};
+            REQUIRE(optional_transition.has_value() == optional_minimized_transition.has_value());
+            if (false == optional_transition.has_value()) {
+                break;
+            }
+            REQUIRE(optional_transition->get_reg_ops()
+                    == optional_minimized_transition->get_reg_ops());
+
+            state = optional_transition->get_dest_state();
+            minimized_state = optional_minimized_transition->get_dest_state();
+            REQUIRE(state->get_matching_variable_ids()
+                    == minimized_state->get_matching_variable_ids());
+            REQUIRE(state->get_accepting_reg_ops() == minimized_state->get_accepting_reg_ops());
+        }
+    }
+    return stats;
+}
+
+auto test_optimized_registers(
+        std::vector<string> const& var_schemas,
+        std::vector<string> const& inputs
+) -> std::pair<DfaStats, DfaStats> {
+    auto const rules{get_rules(var_schemas)};
+    ByteNfa const nfa{rules};
+    std::unordered_map<uint32_t, vector<tag_id_t>> variable_id_to_tag_ids;
+    for (auto const& rule : rules) {
+        auto& tag_ids{variable_id_to_tag_ids[rule.get_variable_id()]};
+        for (auto const* capture : rule.get_captures()) {
+            auto const [start_tag_id, end_tag_id]{nfa.get_capture_to_tag_id_pair().at(capture)};
+            tag_ids.push_back(start_tag_id);
+            tag_ids.push_back(end_tag_id);
+        }
+    }
+    ByteDfa dfa{nfa};
+    ByteDfa optimized_dfa{nfa};
+    optimized_dfa.optimize_registers(variable_id_to_tag_ids);
+
+    // No transition reachable from an accepting state may overwrite the final registers read
+    // there, since the lexer only reads them once the DFA dies
+    auto const& optimized_final_reg_ids{optimized_dfa.get_tag_id_to_final_reg_id()};
+    for (auto const* accepting_state : optimized_dfa.get_bfs_traversal_order()) {
+        std::set<reg_id_t> read_reg_ids;
+        for (auto const variable_id : accepting_state->get_matching_variable_ids()) {
+            for (auto const tag_id : variable_id_to_tag_ids.at(variable_id)) {
+                read_reg_ids.insert(optimized_final_reg_ids.at(tag_id));
+            }
+        }
+        if (read_reg_ids.empty()) {
+            continue;
+        }
+        std::set<ByteDfaState const*> visited_states{accepting_state};
+        vector<ByteDfaState const*> unvisited_states{accepting_state};
+        while (false == unvisited_states.empty()) {
+            auto const* state{unvisited_states.back()};
+            unvisited_states.pop_back();
+            for (auto const& optional_transition : state->get_class_transitions()) {
+                if (false == optional_transition.has_value()) {
+                    continue;
+                }
+                for (auto const& reg_op : optional_transition->get_reg_ops()) {
+                    REQUIRE_FALSE(read_reg_ids.contains(reg_op.get_reg_id()));
+                }
+                auto const* dest_state{optional_transition->get_dest_state()};
+                if (visited_states.insert(dest_state).second) {
+                    unvisited_states.push_back(dest_state);
+                }
+            }
+        }
+    }
+
+    for (auto const& input : inputs) {
+        for (size_t prefix_length{0}; prefix_length <= input.size(); ++prefix_length) {
+            CAPTURE(input.substr(0, prefix_length));
+            dfa.reset_reg_handler();
+            optimized_dfa.reset_reg_handler();
+            auto const* state{dfa.get_root()};
+            auto const* optimized_state{optimized_dfa.get_root()};
+            uint32_t pos{0};
+            for (; pos < prefix_length; ++pos) {
+                auto const byte{static_cast<uint8_t>(input[pos])};
+                auto const& optional_transition{state->get_transition(byte)};
+                auto const& optional_optimized_transition{optimized_state->get_transition(byte)};
+                REQUIRE(optional_transition.has_value()
+                        == optional_optimized_transition.has_value());
+                if (false == optional_transition.has_value()) {
+                    break;
+                }
+                dfa.process_reg_ops(optional_transition->get_reg_ops(), pos);
+                optimized_dfa.process_reg_ops(optional_optimized_transition->get_reg_ops(), pos);
+                state = optional_transition->get_dest_state();
+                optimized_state = optional_optimized_transition->get_dest_state();
+            }
+            if (pos < prefix_length || false == state->is_accepting()) {
+                continue;
+            }
+            dfa.process_reg_ops(state->get_accepting_reg_ops(), pos);
+            optimized_dfa.process_reg_ops(optimized_state->get_accepting_reg_ops(), pos);
+            auto const final_reg_ids{dfa.get_tag_id_to_final_reg_id()};
+            auto const optimized_final_reg_ids{optimized_dfa.get_tag_id_to_final_reg_id()};
+            auto const reg_handler{dfa.release_reg_handler()};
+            auto const optimized_reg_handler{optimized_dfa.release_reg_handler()};
+            for (auto const variable_id : state->get_matching_variable_ids()) {
+                for (auto const tag_id : variable_id_to_tag_ids.at(variable_id)) {
+                    CAPTURE(tag_id);
+                    REQUIRE(reg_handler.get_reversed_positions(final_reg_ids.at(tag_id))
+                            == optimized_reg_handler.get_reversed_positions(
+                                    optimized_final_reg_ids.at(tag_id)
+                            ));
+                }
+            }
+        }
+
+        CAPTURE(input);
+        dfa.reset_reg_handler();
+        optimized_dfa.reset_reg_handler();
+        auto const* state{dfa.get_root()};
+        auto const* optimized_state{optimized_dfa.get_root()};
+        ByteDfaState const* last_accepting_state{nullptr};
+        for (uint32_t pos{0}; true; ++pos) {
+            if (state->is_accepting()) {
+                dfa.process_reg_ops(state->get_accepting_reg_ops(), pos);
+                optimized_dfa.process_reg_ops(optimized_state->get_accepting_reg_ops(), pos);
+                last_accepting_state = state;
+            }
+            if (pos == input.size()) {
+                break;
+            }
+            auto const byte{static_cast<uint8_t>(input[pos])};
+            auto const& optional_transition{state->get_transition(byte)};
+            auto const& optional_optimized_transition{optimized_state->get_transition(byte)};
+            if (false == optional_transition.has_value()) {
+                break;
+            }
+            dfa.process_reg_ops(optional_transition->get_reg_ops(), pos);
+            optimized_dfa.process_reg_ops(optional_optimized_transition->get_reg_ops(), pos);
+            state = optional_transition->get_dest_state();
+            optimized_state = optional_optimized_transition->get_dest_state();
+        }
+        if (nullptr == last_accepting_state) {
+            continue;
+        }
+        auto const final_reg_ids{dfa.get_tag_id_to_final_reg_id()};
+        auto const optimized_final_reg_ids{optimized_dfa.get_tag_id_to_final_reg_id()};
+        auto const reg_handler{dfa.release_reg_handler()};
+        auto const optimized_reg_handler{optimized_dfa.release_reg_handler()};
+        for (auto const variable_id : last_accepting_state->get_matching_variable_ids()) {
+            for (auto const tag_id : variable_id_to_tag_ids.at(variable_id)) {
+                CAPTURE(tag_id);
+                REQUIRE(reg_handler.get_reversed_positions(final_reg_ids.at(tag_id))
+                        == optimized_reg_handler.get_reversed_positions(
+                                optimized_final_reg_ids.at(tag_id)
+                        ));
+            }
+        }
+    }
+    return {dfa.get_stats(), optimized_dfa.get_stats()};
+}
+
+auto test_lazy_dfa(
+        std::vector<string> const& var_schemas,
+        std::vector<string> const& inputs,
+        size_t const max_num_cached_states
+) -> std::pair<uint64_t, bool> {
+    auto const nfa{get_nfa(var_schemas)};
+    ByteDfa const dfa{nfa};
+    RuntimeDfa const runtime_dfa{dfa};
+
+    auto lazy_nfa{std::make_unique<ByteNfa>(get_rules(var_schemas))};
+    RuntimeDfa cache{ByteDfa::get_byte_classes(*lazy_nfa, {})};
+    LazyDfa<ByteNfaState> lazy_dfa{std::move(lazy_nfa), cache, max_num_cached_states};
+    REQUIRE(RuntimeDfa::is_accepting(runtime_dfa.get_root())
+            == RuntimeDfa::is_accepting(cache.get_root()));
+
+    uint64_t num_scanned_bytes{0};
+    for (auto const& input : inputs) {
+        CAPTURE(input);
+        auto runtime_state{runtime_dfa.get_root()};
+        auto lazy_state{cache.get_root()};
+        for (auto const c : input) {
+            auto const byte{static_cast<uint8_t>(c)};
+            runtime_state = runtime_dfa.get_next_state(runtime_state, byte);
+            auto next_lazy_state{cache.get_next_state(lazy_state, byte)};
+            if (RuntimeDfa::cUnexploredState == next_lazy_state) {
+                next_lazy_state = lazy_dfa.get_next_state(lazy_state, byte, num_scanned_bytes);
+            }
+            lazy_state = next_lazy_state;
+            ++num_scanned_bytes;
+            REQUIRE((RuntimeDfa::cDeadState == runtime_state)
+                    == (RuntimeDfa::cDeadState == lazy_state));
+            if (RuntimeDfa::cDeadState == runtime_state) {
+                break;
+            }
+            REQUIRE(RuntimeDfa::is_accepting(runtime_state)
+                    == RuntimeDfa::is_accepting(lazy_state));
+            REQUIRE(runtime_dfa.get_matching_variable_ids(runtime_state)
+                    == cache.get_matching_variable_ids(lazy_state));
+        }
+    }
+    REQUIRE(cache.get_num_states() <= std::max<size_t>(max_num_cached_states, 4));
+    return {lazy_dfa.get_num_flushes(), lazy_dfa.is_simulating_nfa()};
+}
+auto test_binary_serialization(std::vector<string> const& var_schemas) -> vector<uint8_t> {
+    auto const nfa{get_nfa(var_schemas)};
+    ByteDfa const dfa{nfa};
+    BinaryWriter writer;
+    dfa.serialize_binary(writer);
+    auto bytes{writer.release_bytes()};
+
+    BinaryReader reader{bytes};
+    auto const loaded_dfa{ByteDfa::load_binary(reader)};
+    REQUIRE(reader.is_done());
+    REQUIRE(dfa.serialize() == loaded_dfa->serialize());
+    REQUIRE(dfa.get_tag_id_to_final_reg_id() == loaded_dfa->get_tag_id_to_final_reg_id());
+    REQUIRE(dfa.get_multi_valued_regs() == loaded_dfa->get_multi_valued_regs());
+    REQUIRE(dfa.get_stats().m_num_states == loaded_dfa->get_stats().m_num_states);
+    REQUIRE(dfa.get_stats().m_num_regs == loaded_dfa->get_stats().m_num_regs);
+    REQUIRE(dfa.get_stats().m_num_reg_ops == loaded_dfa->get_stats().m_num_reg_ops);
+    return bytes;
+}
+
+auto test_runtime_dfa_image(std::vector<string> const& var_schemas, bool const accelerate)
+        -> std::pair<vector<uint8_t>, size_t> {
+    auto const nfa{get_nfa(var_schemas)};
+    ByteDfa const dfa{nfa};
+    RuntimeDfa runtime_dfa{dfa};
+    if (accelerate) {
+        runtime_dfa.accelerate_states({});
+    }
+    BinaryWriter writer;
+    runtime_dfa.serialize_image(writer);
+    auto image{writer.release_bytes()};
+    auto const num_regs{dfa.get_multi_valued_regs().size()};
+
+    BinaryReader reader{image};
+    auto const loaded_runtime_dfa{RuntimeDfa::load_image(reader, num_regs)};
+    REQUIRE(reader.is_done());
+    REQUIRE(loaded_runtime_dfa->is_from_image());
+    BinaryWriter loaded_writer;
+    loaded_runtime_dfa->serialize_image(loaded_writer);
+    REQUIRE(image == loaded_writer.get_bytes());
+    return {std::move(image), num_regs};
+}
+
+auto get_runtime_dfa_image_offsets(std::span<uint8_t const> const image) -> vector<size_t> {
+    auto const get_offset{[&](void const* data) -> size_t {
+        return static_cast<size_t>(static_cast<uint8_t const*>(data) - image.data());
+    }};
+    BinaryReader reader{image};
+    vector<size_t> offsets{get_offset(image.data())};
+    reader.read<RuntimeDfa::state_id_t>();
+    reader.read<uint32_t>();
+    reader.read<std::array<ByteClassMap::class_id_t, log_surgeon::cSizeOfByte>>();
+    offsets.push_back(get_offset(reader.read_aligned_span<RuntimeDfa::state_id_t>().data()));
+    offsets.push_back(get_offset(reader.read_aligned_span<RuntimeDfa::reg_ops_id_t>().data()));
+    offsets.push_back(get_offset(reader.read_aligned_span<RuntimeDfa::reg_ops_id_t>().data()));
+    auto const matching_variable_ids_ids{reader.read_aligned_span<uint32_t>()};
+    offsets.push_back(get_offset(matching_variable_ids_ids.data()));
+    // The register operations follow their number, as records of two register IDs, the type, a
+    // flag, and two bytes of padding
+    offsets.push_back(
+            get_offset(matching_variable_ids_ids.data() + matching_variable_ids_ids.size())
+            + sizeof(uint64_t)
+    );
+    reader.read_vector<std::array<uint8_t, 2 * sizeof(reg_id_t) + 4>>();
+    offsets.push_back(get_offset(reader.read_aligned_span<uint64_t>().data()));
+    offsets.push_back(get_offset(reader.read_aligned_span<uint32_t>().data()));
+    return offsets;
+}
+
+auto test_parallel_determinization(std::vector<string> const& var_schemas, size_t num_threads)
+        -> void {
+    auto const nfa{get_nfa(var_schemas)};
+    ByteDfa const dfa{nfa};
+    ByteDfa const parallel_dfa{nfa, {}, std::numeric_limits<size_t>::max(), num_threads};
+    REQUIRE(dfa.serialize() == parallel_dfa.serialize());
+    REQUIRE(dfa.get_tag_id_to_final_reg_id() == parallel_dfa.get_tag_id_to_final_reg_id());
+    REQUIRE(dfa.get_multi_valued_regs() == parallel_dfa.get_multi_valued_regs());
+    BinaryWriter writer;
+    dfa.serialize_binary(writer);
+    BinaryWriter parallel_writer;
+    parallel_dfa.serialize_binary(parallel_writer);
+    REQUIRE(writer.get_bytes() == parallel_writer.get_bytes());
+}
 }  // namespace
 
 /**
@@ -249,3 +733,373 @@ TEST_CASE("two_overlapping_vars", "[DFA]") {
     };
     test_dfa({var_schema1, var_schema2}, expected_serialized_dfa);
 }
+
+/**
+ * @ingroup unit_tests_dfa
+ * @brief Compile DFAs into their runtime form and compare their simulations.
+ */
+TEST_CASE("runtime_dfa", "[DFA]") {
+    test_runtime_dfa({"var:userID=123"}, {"userID=123", "userID=124", "user", "x"});
+    test_runtime_dfa(
+            {"capture:Z|(A(?<letter>((?<letter1>(a)|(b))|(?<letter2>(c)|(d))))B(?<"
+             "containerID>\\d+)C)"},
+            {"Z", "AaB123C", "AdB9C", "AcB", "AeB1C"}
+    );
+    test_runtime_dfa(
+            {R"(keyValuePair:[A]+=(?<val>[=AB]*A[=AB]*))", R"(hasA:[AB]*[A][=AB]*)"},
+            {"AA=BBA=A", "B=A", "BBBA", "A=", "=A"}
+    );
+}
+
+/**
+ * @ingroup unit_tests_dfa
+ * @brief Partition the bytes of a DFA into equivalence classes, with and without delimiters.
+ */
+TEST_CASE("byte_classes", "[DFA]") {
+    auto const nfa{get_nfa({"int:\\-{0,1}\\d+"})};
+
+    ByteDfa const dfa{nfa};
+    auto const& byte_class_map{dfa.get_byte_class_map()};
+    REQUIRE(3 == byte_class_map.get_num_classes());
+    REQUIRE(byte_class_map.get_class_id('0') == byte_class_map.get_class_id('9'));
+    REQUIRE(byte_class_map.get_class_id('0') != byte_class_map.get_class_id('-'));
+    REQUIRE(byte_class_map.get_class_id('a') == byte_class_map.get_class_id(' '));
+    REQUIRE('0' == byte_class_map.get_representative(byte_class_map.get_class_id('5')));
+    REQUIRE(3 == RuntimeDfa{dfa}.get_num_classes());
+
+    std::array<bool, log_surgeon::cSizeOfByte> is_delimiter{};
+    is_delimiter[' '] = true;
+    is_delimiter['5'] = true;
+    ByteDfa const dfa_with_delimiters{nfa, is_delimiter};
+    auto const& delimited_byte_class_map{dfa_with_delimiters.get_byte_class_map()};
+    REQUIRE(5 == delimited_byte_class_map.get_num_classes());
+    REQUIRE(delimited_byte_class_map.get_class_id('0')
+            == delimited_byte_class_map.get_class_id('9'));
+    REQUIRE(delimited_byte_class_map.get_class_id('0')
+            != delimited_byte_class_map.get_class_id('5'));
+    REQUIRE(delimited_byte_class_map.get_class_id('a')
+            != delimited_byte_class_map.get_class_id(' '));
+    REQUIRE(dfa.serialize() == dfa_with_delimiters.serialize());
+}
+
+/**
+ * @ingroup unit_tests_dfa
+ * @brief Accelerate the states of a DFA that loop back to themselves on most bytes.
+ */
+TEST_CASE("runtime_dfa_acceleration", "[DFA]") {
+    std::array<bool, log_surgeon::cSizeOfByte> stop_bytes{};
+    stop_bytes[' '] = true;
+    stop_bytes['\n'] = true;
+    auto const nfa{get_nfa({R"(hasNumber:[^ \n]*\d[^ \n]*)"})};
+    ByteDfa const dfa{nfa, stop_bytes};
+    RuntimeDfa runtime_dfa{dfa};
+    runtime_dfa.accelerate_states(stop_bytes);
+
+    // The root leaves on every byte except the stop bytes
+    auto const root{runtime_dfa.get_root()};
+    REQUIRE_FALSE(RuntimeDfa::is_accelerated(root));
+
+    // Before a digit is seen, only digits and stop bytes leave the state
+    auto const no_digit_state{runtime_dfa.get_next_state(root, 'a')};
+    REQUIRE(RuntimeDfa::is_accelerated(no_digit_state));
+    REQUIRE(no_digit_state == runtime_dfa.get_next_state(no_digit_state, 'b'));
+    auto const& no_digit_exit_bytes{runtime_dfa.get_exit_bytes(no_digit_state)};
+    REQUIRE(12 == no_digit_exit_bytes.size());
+    REQUIRE(no_digit_exit_bytes.contains('0'));
+    REQUIRE(no_digit_exit_bytes.contains(' '));
+    REQUIRE_FALSE(no_digit_exit_bytes.contains('a'));
+
+    // After a digit and a non-digit are seen, any non-digit loops back to the state
+    auto const digit_state{runtime_dfa.get_next_state(no_digit_state, '1')};
+    auto const after_digit_state{runtime_dfa.get_next_state(digit_state, 'b')};
+    REQUIRE(RuntimeDfa::is_accelerated(after_digit_state));
+    REQUIRE(RuntimeDfa::is_accepting(after_digit_state));
+    auto const& after_digit_exit_bytes{runtime_dfa.get_exit_bytes(after_digit_state)};
+    REQUIRE(after_digit_exit_bytes.contains('\n'));
+    REQUIRE_FALSE(after_digit_exit_bytes.contains('b'));
+}
+
+/**
+ * @ingroup unit_tests_dfa
+ * @brief Minimize DFAs, merging states only if their register operations are the same.
+ */
+TEST_CASE("dfa_minimization", "[DFA]") {
+    SECTION("Merge states reached through different alternatives") {
+        auto const stats{test_minimized_dfa({"var:(ab)|(cb)"}, {"ab", "cb", "a", "cc", "b"})};
+        REQUIRE(4 == stats.m_before.m_num_states);
+        REQUIRE(3 == stats.m_after.m_num_states);
+        REQUIRE(stats.m_after.m_num_bytes < stats.m_before.m_num_bytes);
+    }
+
+    SECTION("Keep states whose transitions have different register operations") {
+        auto const stats{test_minimized_dfa({"var:(a(?<x>b))|(cb)"}, {"ab", "cb", "a", "c"})};
+        REQUIRE(stats.m_before.m_num_states == stats.m_after.m_num_states);
+    }
+
+    SECTION("Merge states that loop into each other") {
+        auto const stats{test_minimized_dfa(
+                {R"(keyValuePair:[A]+=(?<val>[=AB]*A[=AB]*))", R"(hasA:[AB]*[A][=AB]*)"},
+                {"AA=BBA=A", "B=A", "BBBA", "BA=AB=", "A=", "=A"}
+        )};
+        REQUIRE(10 == stats.m_before.m_num_states);
+        REQUIRE(7 == stats.m_after.m_num_states);
+    }
+
+    SECTION("Leave minimal DFAs unchanged") {
+        auto const stats{test_minimized_dfa({"var:userID=123"}, {"userID=123", "user", "x"})};
+        REQUIRE(stats.m_before.m_num_states == stats.m_after.m_num_states);
+        REQUIRE(stats.m_before.m_num_bytes == stats.m_after.m_num_bytes);
+    }
+}
+
+/**
+ * @ingroup unit_tests_dfa
+ * @brief Determinize DFAs on demand and compare their simulations with fully built DFAs.
+ *
+ * `(a|b)*a(a|b){5}` needs a state for every combination of the last six bytes, so its cache fills
+ * up quickly on random inputs.
+ */
+TEST_CASE("lazy_dfa", "[DFA]") {
+    std::mt19937 generator{0};
+    std::uniform_int_distribution<int> bit_distribution{0, 1};
+    auto const get_random_input{[&](size_t const size) {
+        string input;
+        for (size_t i{0}; i < size; ++i) {
+            input += 0 == bit_distribution(generator) ? 'a' : 'b';
+        }
+        return input;
+    }};
+
+    SECTION("Cache every state") {
+        auto const [num_flushes, is_simulating_nfa]{test_lazy_dfa(
+                {R"(int:\-{0,1}\d+)",
+                 R"(keyValuePair:[A]+=[=AB]*A[=AB]*)",
+                 R"(hasA:[AB]*[A][=AB]*)"},
+                {"-123", "12a", "AA=BBA=A", "B=A", "BBBA", "A=", "=A", ""},
+                LazyDfa<ByteNfaState>::cDefaultMaxNumCachedStates
+        )};
+        REQUIRE(0 == num_flushes);
+        REQUIRE_FALSE(is_simulating_nfa);
+    }
+
+    SECTION("Flush a full cache") {
+        // Each input ends in a long run of one state, so every flush is productive
+        vector<string> inputs;
+        for (uint32_t i{0}; i < 10; ++i) {
+            inputs.emplace_back(get_random_input(12) + string(500, 'b'));
+        }
+        auto const [num_flushes, is_simulating_nfa]{
+                test_lazy_dfa({"var:(a|b)*a(a|b){5}"}, inputs, 16)
+        };
+        REQUIRE(0 < num_flushes);
+        REQUIRE_FALSE(is_simulating_nfa);
+    }
+
+    SECTION("Fall back to simulating the NFA") {
+        auto const [num_flushes, is_simulating_nfa]{test_lazy_dfa(
+                {"var:(a|b)*a(a|b){5}"},
+                {get_random_input(2000), get_random_input(100)},
+                16
+        )};
+        REQUIRE(LazyDfa<ByteNfaState>::cMaxNumUnproductiveFlushes <= num_flushes);
+        REQUIRE(is_simulating_nfa);
+    }
+}
+
+/**
+ * @ingroup unit_tests_dfa
+ * @brief Serialize DFAs in binary form and load them back without determinizing anything.
+ */
+TEST_CASE("dfa_binary_serialization", "[DFA]") {
+    SECTION("Without captures") {
+        test_binary_serialization(
+                {R"(int:\-{0,1}\d+)", R"(hasA:[AB]*[A][=AB]*)", "var:(a|b)*a(a|b){3}"}
+        );
+    }
+
+    SECTION("With captures") {
+        test_binary_serialization(
+                {R"(var:k=(?<c>[a-c]+)(;(?<e>[a-b]+))*)", R"(other:(?<d>[ab]+)c(?<f>[a-c]*))"}
+        );
+    }
+
+    SECTION("Reject truncated data") {
+        auto const bytes{test_binary_serialization({"capture:userID=(?<uID>123)"})};
+        for (auto const size : {size_t{0}, size_t{100}, bytes.size() - 1}) {
+            CAPTURE(size);
+            BinaryReader reader{std::span{bytes}.first(size)};
+            REQUIRE_THROWS_AS(ByteDfa::load_binary(reader), std::runtime_error);
+        }
+    }
+}
+
+/**
+ * @ingroup unit_tests_dfa
+ * @brief Write runtime DFAs to images, and reject images whose tables are inconsistent even though
+ * their sizes are.
+ */
+TEST_CASE("runtime_dfa_image", "[DFA]") {
+    std::vector<string> const var_schemas{
+            R"(hasNumber:[^ \n]*\d[^ \n]*)",
+            R"(var:k=(?<c>[a-c]+)(;(?<e>[a-b]+))*)"
+    };
+    auto const [image, num_regs]{test_runtime_dfa_image(var_schemas, true)};
+    auto const [unaccelerated_image, unaccelerated_num_regs]{
+            test_runtime_dfa_image(var_schemas, false)
+    };
+    REQUIRE(0 != num_regs);
+    // Images don't depend on anything but the table, e.g., on uninitialized padding
+    REQUIRE(image == test_runtime_dfa_image(var_schemas, true).first);
+
+    auto const offsets{get_runtime_dfa_image_offsets(image)};
+    auto const root_offset{offsets[0]};
+    auto const next_states_offset{offsets[1]};
+    auto const transition_reg_ops_ids_offset{offsets[2]};
+    auto const accepting_reg_ops_ids_offset{offsets[3]};
+    auto const matching_variable_ids_ids_offset{offsets[4]};
+    auto const reg_ops_offset{offsets[5]};
+    auto const reg_ops_offsets_offset{offsets[6]};
+    auto const exit_bytes_ids_offset{offsets[7]};
+
+    auto const read_value{[]<typename T>(vector<uint8_t> const& bytes, size_t offset, T) -> T {
+        T value;
+        std::memcpy(&value, bytes.data() + offset, sizeof(T));
+        return value;
+    }};
+    auto const require_rejected{
+            [&]<typename T>(vector<uint8_t> const& bytes, size_t regs, size_t offset, T value) {
+                CAPTURE(offset);
+                auto corrupted_bytes{bytes};
+                std::memcpy(corrupted_bytes.data() + offset, &value, sizeof(T));
+                BinaryReader reader{corrupted_bytes};
+                REQUIRE_THROWS_AS(RuntimeDfa::load_image(reader, regs), std::runtime_error);
+            }
+    };
+    auto const root{read_value(image, root_offset, RuntimeDfa::state_id_t{})};
+    auto const num_reg_ops_offsets{
+            read_value(image, reg_ops_offsets_offset - sizeof(uint64_t), uint64_t{})
+    };
+    REQUIRE(3 <= num_reg_ops_offsets);
+
+    SECTION("Out-of-range IDs") {
+        require_rejected(image, num_regs, next_states_offset, RuntimeDfa::state_id_t{1'000'000});
+        require_rejected(image, num_regs, transition_reg_ops_ids_offset, uint32_t{1'000'000});
+        require_rejected(image, num_regs, accepting_reg_ops_ids_offset, uint32_t{1'000'000});
+        require_rejected(image, num_regs, matching_variable_ids_ids_offset, uint32_t{1'000'000});
+        require_rejected(image, num_regs, exit_bytes_ids_offset, uint32_t{1'000'000});
+    }
+
+    SECTION("Register operations") {
+        // The register operation's destination register is its first member
+        require_rejected(image, num_regs, reg_ops_offset, static_cast<uint32_t>(num_regs));
+        // Followed by the source register, the type, whether there's a source register, and
+        // padding
+        auto const type_offset{reg_ops_offset + 2 * sizeof(reg_id_t)};
+        require_rejected(image, num_regs, type_offset, uint8_t{3});
+        require_rejected(
+                image,
+                num_regs,
+                type_offset + 1,
+                static_cast<uint8_t>(read_value(image, type_offset + 1, uint8_t{}) ^ 1U)
+        );
+        require_rejected(image, num_regs, type_offset + 1, uint8_t{2});
+        require_rejected(image, num_regs, type_offset + 2, uint8_t{1});
+
+        auto const last_offset{read_value(
+                image,
+                reg_ops_offsets_offset + (num_reg_ops_offsets - 1) * sizeof(uint64_t),
+                uint64_t{}
+        )};
+        require_rejected(
+                image,
+                num_regs,
+                reg_ops_offsets_offset + sizeof(uint64_t),
+                last_offset + 1
+        );
+    }
+
+    SECTION("State flags") {
+        require_rejected(image, num_regs, root_offset, root ^ RuntimeDfa::cAcceptingFlag);
+        require_rejected(
+                unaccelerated_image,
+                unaccelerated_num_regs,
+                root_offset,
+                root | RuntimeDfa::cAcceleratedFlag
+        );
+    }
+}
+
+/**
+ * @ingroup unit_tests_dfa
+ * @brief Optimize the registers of DFAs without changing the positions of any matched capture.
+ */
+TEST_CASE("register_optimization", "[DFA]") {
+    SECTION("Single-valued captures") {
+        auto const [before, after]{test_optimized_registers(
+                {"capture:Z|(A(?<letter>((?<letter1>(a)|(b))|(?<letter2>(c)|(d))))B(?<containerID>"
+                 "\\d+)C)"},
+                {"Z", "AaB12C", "AcB0C", "AdB123", "AB1C"}
+        )};
+        REQUIRE(after.m_num_regs < before.m_num_regs);
+        REQUIRE(after.m_num_reg_ops < before.m_num_reg_ops);
+    }
+
+    SECTION("Multi-valued captures") {
+        auto const [before, after]{test_optimized_registers(
+                {R"(var:k=(?<c>[a-c]+)(;(?<e>[a-b]+))*)", R"(other:(?<d>[ab]+)c(?<f>[a-c]*))"},
+                {"k=abc;ab;b;a", "k=a;;b", "abcab", "bacc", "k=c;a;bc"}
+        )};
+        REQUIRE(after.m_num_regs < before.m_num_regs);
+        REQUIRE(after.m_num_reg_ops < before.m_num_reg_ops);
+    }
+
+    SECTION("Capture in only one of two overlapping variables") {
+        auto const [before, after]{test_optimized_registers(
+                {R"(keyValuePair:[A]+=(?<val>[=AB]*A[=AB]*))", R"(hasA:[AB]*[A][=AB]*)"},
+                {"AA=BBA=A", "B=A", "BBBA", "BA=AB=", "A=", "=A"}
+        )};
+        REQUIRE(after.m_num_regs < before.m_num_regs);
+        REQUIRE(after.m_num_reg_ops < before.m_num_reg_ops);
+    }
+
+    SECTION("Longer capturing variable fails after a shorter one accepts") {
+        test_optimized_registers(
+                {R"(short:a(?<x>b+))",
+                 R"(long:a(?<y>b+)c(?<z>d+)(?<w>[ab]+)e)",
+                 R"(longer:a(?<u>b+)c(?<v>d+)[ab]*f)"},
+                {"abbcddabe", "abbcdd", "abbcdde", "abcdaaf", "abbcdab", "abb"}
+        );
+    }
+
+    SECTION("Leave DFAs without captures unchanged") {
+        auto const [before, after]{test_optimized_registers({"var:userID=123"}, {"userID=123"})};
+        REQUIRE(0 == after.m_num_regs);
+        REQUIRE(0 == after.m_num_reg_ops);
+    }
+}
+
+/**
+ * @ingroup unit_tests_dfa
+ * @brief Determinize DFAs on multiple threads into the same DFA as on a single thread.
+ */
+TEST_CASE("parallel_determinization", "[DFA]") {
+    SECTION("Without captures") {
+        test_parallel_determinization(
+                {R"(int:\-{0,1}\d+)", R"(hasA:[AB]*[A][=AB]*)", "var:(a|b)*a(a|b){3}"},
+                4
+        );
+    }
+
+    SECTION("With captures") {
+        for (size_t const num_threads : {2, 3, 8}) {
+            CAPTURE(num_threads);
+            test_parallel_determinization(
+                    {R"(var:k=(?<c>[a-c]+)(;(?<e>[a-b]+))*)",
+                     R"(other:(?<d>[ab]+)c(?<f>[a-c]*))",
+                     "capture:Z|(A(?<letter>((?<letter1>(a)|(b))|(?<letter2>(c)|(d))))B(?<"
+                     "containerID>\\d+)C)"},
+                    num_threads
+            );
+        }
+    }
+}
@@ -1,5 +1,9 @@
+#include <cstddef>
+#include <cstdint>
+#include <limits>
 #include <sstream>
 #include <string>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -38,6 +42,15 @@ namespace {
  */
 auto test_nfa(string const& var_schema, string const& expected_serialized_nfa) -> void;
 
+/**
+ * Generates an NFA for the given `var_schema` string, and checks that the number of states the
+ * rule's AST computes without building the NFA is the number of states the NFA was built with.
+ *
+ * @param var_schema Variable schema from which to construct the NFA.
+ * @return The number of NFA states of the rule's AST.
+ */
+auto test_num_nfa_states(string const& var_schema) -> uint64_t;
+
 auto test_nfa(string const& var_schema, string const& expected_serialized_nfa) -> void {
     Schema schema;
     schema.add_variable(var_schema, -1);
@@ -66,6 +79,22 @@ auto test_nfa(string const& var_schema, string const& expected_serialized_nfa) -
     getline(ss_expected, expected_line);
     REQUIRE(expected_line.empty());
 }
+
+auto test_num_nfa_states(string const& var_schema) -> uint64_t {
+    Schema schema;
+    schema.add_variable(var_schema, -1);
+
+    auto const schema_ast = schema.release_schema_ast_ptr();
+    auto& capture_rule_ast = dynamic_cast<SchemaVarAST&>(*schema_ast->m_schema_vars[0]);
+    vector<ByteLexicalRule> rules;
+    rules.emplace_back(0, std::move(capture_rule_ast.m_regex_ptr));
+    auto const num_nfa_states{rules[0].get_regex()->get_num_nfa_states_with_negative_captures()};
+    ByteNfa const nfa{rules};
+
+    // The NFA also has a root state and an accepting state
+    REQUIRE(num_nfa_states + 2 == nfa.get_num_states());
+    return num_nfa_states;
+}
 }  // namespace
 
 /**
@@ -218,3 +247,67 @@ TEST_CASE("kv_pair_var", "[NFA]") {
     };
     test_nfa(var_schema, expected_serialized_nfa);
 }
+
+/**
+ * @ingroup unit_tests_nfa
+ * @brief Tests that overlapping byte intervals are split into disjoint intervals that keep the
+ * destination states in the order they were added.
+ */
+TEST_CASE("overlapping_byte_intervals", "[NFA]") {
+    ByteNfaState state{0};
+    ByteNfaState dest_a{1};
+    ByteNfaState dest_b{2};
+    ByteNfaState dest_c{3};
+    state.add_byte_interval('c', 'f', &dest_a);
+    state.add_byte_interval('a', 'd', &dest_b);
+    state.add_byte_interval('f', 'f', &dest_c);
+    state.add_byte_interval('x', 'z', &dest_c);
+
+    vector<std::tuple<char, char, vector<ByteNfaState*>>> const expected_intervals{
+            {'a', 'b', {&dest_b}},
+            {'c', 'd', {&dest_a, &dest_b}},
+            {'e', 'e', {&dest_a}},
+            {'f', 'f', {&dest_a, &dest_c}},
+            {'x', 'z', {&dest_c}}
+    };
+    auto const& intervals{state.get_byte_transition_intervals()};
+    REQUIRE(expected_intervals.size() == intervals.size());
+    for (size_t i{0}; i < intervals.size(); ++i) {
+        auto const& [expected_first, expected_last, expected_dest_states]{expected_intervals[i]};
+        REQUIRE(static_cast<uint8_t>(expected_first) == intervals[i].m_first);
+        REQUIRE(static_cast<uint8_t>(expected_last) == intervals[i].m_last);
+        REQUIRE(expected_dest_states == intervals[i].m_dest_states);
+    }
+
+    REQUIRE(state.get_byte_transitions('`').empty());
+    REQUIRE(vector<ByteNfaState*>{&dest_a, &dest_b} == state.get_byte_transitions('d'));
+    REQUIRE(state.get_byte_transitions('g').empty());
+    REQUIRE(vector<ByteNfaState*>{&dest_c} == state.get_byte_transitions('z'));
+}
+
+/**
+ * @ingroup unit_tests_nfa
+ * @brief Count the NFA states of counted repetitions without building the NFA.
+ */
+TEST_CASE("counted_repetition_num_states", "[NFA]") {
+    // Repetitions without captures are chains with one operand copy per repetition
+    REQUIRE(31 == test_num_nfa_states("hex:[0-9a-f]{32}"));
+    REQUIRE(18 == test_num_nfa_states(R"(int:\d{1,19})"));
+    REQUIRE(35 == test_num_nfa_states(R"(id:(a\d{1,19})|([0-9a-f]{2,17}))"));
+    REQUIRE(5 == test_num_nfa_states("nested:(ab{0,2}){2}"));
+
+    // Repetitions with captures copy the operand twice per optional repetition, and every copy of
+    // the capture adds two states
+    REQUIRE(7 * 2 + 3 == test_num_nfa_states("capture:(?<x>a){1,4}"));
+    REQUIRE(test_num_nfa_states("capture:(?<x>a){0,2}") > 0);
+    REQUIRE(test_num_nfa_states("capture:(?<x>a)*") > 0);
+
+    // The count saturates instead of overflowing
+    auto const schema_ast{[] {
+        Schema schema;
+        schema.add_variable("huge:((((a{1,65535}){1,65535}){1,65535}){1,65535}){1,65535}", -1);
+        return schema.release_schema_ast_ptr();
+    }()};
+    auto const& rule_ast{dynamic_cast<SchemaVarAST&>(*schema_ast->m_schema_vars[0])};
+    REQUIRE(std::numeric_limits<uint64_t>::max() == rule_ast.m_regex_ptr->get_num_nfa_states());
+}
@@ -1,9 +1,13 @@
+#include <algorithm>
 #include <codecvt>
+#include <cstddef>
 #include <cstdint>
 #include <locale>
 #include <string>
 #include <string_view>
+#include <vector>
 
+#include <log_surgeon/Constants.hpp>
 #include <log_surgeon/finite_automata/RegexAST.hpp>
 #include <log_surgeon/Schema.hpp>
 #include <log_surgeon/SchemaParser.hpp>
@@ -17,12 +21,14 @@
  * These unit tests contain the `Regex` tag.
  */
 
+using log_surgeon::cSizeOfByte;
 using log_surgeon::Schema;
 using log_surgeon::SchemaVarAST;
 using std::codecvt_utf8;
 using std::string;
 using std::string_view;
 using std::u32string;
+using std::vector;
 using std::wstring_convert;
 
 namespace {
@@ -34,6 +40,14 @@ namespace {
  */
 auto test_regex_ast(string_view var_schema, u32string const& expected_serialized_ast) -> void;
 
+/**
+ * Generates an AST for the given `var_schema` string. Then compares its required byte sets with
+ * `expected_byte_sets`, ignoring their order.
+ * @param var_schema
+ * @param expected_byte_sets Each required byte set as a string of its members in ascending order.
+ */
+auto test_required_byte_sets(string_view var_schema, vector<string> expected_byte_sets) -> void;
+
 /**
  * Converts the characters in a 32-byte unicode string into 4 bytes to generate a 8-byte unicode
  * string.
@@ -57,6 +71,29 @@ auto test_regex_ast(string_view const var_schema, u32string const& expected_seri
     REQUIRE(actual_string == expected_string);
 }
 
+auto test_required_byte_sets(string_view const var_schema, vector<string> expected_byte_sets)
+        -> void {
+    Schema schema;
+    schema.add_variable(var_schema, -1);
+
+    auto const schema_ast = schema.release_schema_ast_ptr();
+    auto const* rule_ast = dynamic_cast<SchemaVarAST*>(schema_ast->m_schema_vars.at(0).get());
+    REQUIRE(rule_ast != nullptr);
+
+    vector<string> actual_byte_sets;
+    for (auto const& byte_set : rule_ast->m_regex_ptr->get_required_byte_sets()) {
+        auto& members{actual_byte_sets.emplace_back()};
+        for (size_t byte{0}; byte < cSizeOfByte; ++byte) {
+            if (byte_set[byte]) {
+                members.push_back(static_cast<char>(byte));
+            }
+        }
+    }
+    std::ranges::sort(actual_byte_sets);
+    std::ranges::sort(expected_byte_sets);
+    REQUIRE(actual_byte_sets == expected_byte_sets);
+}
+
 auto u32string_to_string(u32string const& u32_str) -> string {
     wstring_convert<codecvt_utf8<char32_t>, char32_t> converter;
     return converter.to_bytes(u32_str.data(), u32_str.data() + u32_str.size());
@@ -155,3 +192,24 @@ TEST_CASE("multi_valued_capture_1", "[Regex]") {
             // clang-format on
     );
 }
+
+/**
+ * @ingroup unit_tests_regex_ast
+ * @brief Computes the byte sets from which every string matched by a regex contains a byte.
+ *
+ * The test covers the following cases:
+ * - Literals, groups, and alternations.
+ * - Optional operands, which require nothing.
+ * - Supersets of another required set are dropped.
+ * - Groups containing non-ASCII characters require nothing.
+ */
+TEST_CASE("required_byte_sets", "[Regex]") {
+    test_required_byte_sets("literal:abca", {"a", "b", "c"});
+    test_required_byte_sets("group:[a-c]+", {"abc"});
+    test_required_byte_sets("alternation:(ab)|(cd)", {"ac", "ad", "bc", "bd"});
+    test_required_byte_sets("optional:a*b{0,1}", {});
+    test_required_byte_sets("int:\\-{0,1}\\d+", {"0123456789"});
+    test_required_byte_sets("hex:0x[0-9a-f]+", {"0", "x"});
+    test_required_byte_sets("capture:key=(?<val>[a-z]+)", {"k", "e", "y", "="});
+    test_required_byte_sets("negated:[^a]x", {"x"});
+}
@@ -1,9 +1,12 @@
+#include <array>
 #include <cstddef>
 #include <stdexcept>
 #include <vector>
 
 #include <log_surgeon/finite_automata/PrefixTree.hpp>
 #include <log_surgeon/finite_automata/RegisterHandler.hpp>
+#include <log_surgeon/finite_automata/RegisterSnapshots.hpp>
+#include <log_surgeon/types.hpp>
 
 #include <catch2/catch_test_macros.hpp>
 
@@ -14,7 +17,10 @@
  * These unit tests contain the `RegisterHandler` tag.
  */
 
+using log_surgeon::reg_id_t;
 using log_surgeon::finite_automata::RegisterHandler;
+using log_surgeon::finite_automata::RegisterSnapshot;
+using log_surgeon::finite_automata::RegisterSnapshots;
 using position_t = log_surgeon::finite_automata::PrefixTree::position_t;
 
 namespace {
@@ -40,6 +46,9 @@ auto handler_init(size_t const num_registers) -> RegisterHandler {
  * - Initial register is empty.
  * - Append and copy position.
  * - Handles negative position values.
+ * - Reset empties every register.
+ * - Snapshots keep the given registers' values after a reset, and only theirs.
+ * - Single-valued registers only keep their last position.
  */
 TEST_CASE("operations", "[RegisterHandler]") {
     constexpr position_t cInitialPos1{5};
@@ -93,4 +102,76 @@ TEST_CASE("operations", "[RegisterHandler]") {
         REQUIRE(std::vector<position_t>{cNegativePos2, cNegativePos1}
                 == handler.get_reversed_positions(cRegId3));
     }
+
+    SECTION("Reset empties every register") {
+        handler.append_position(cRegId1, cAppendPos1);
+        handler.append_position(cRegId1, cAppendPos2);
+        handler.copy_register(cRegId2, cRegId1);
+        handler.reset();
+        REQUIRE(cNumRegisters == handler.get_num_regs());
+        REQUIRE(handler.get_reversed_positions(cRegId1).empty());
+        REQUIRE(handler.get_reversed_positions(cRegId2).empty());
+
+        handler.append_position(cRegId1, cAppendPos3);
+        REQUIRE(std::vector<position_t>{cAppendPos3} == handler.get_reversed_positions(cRegId1));
+    }
+
+    SECTION("Snapshots keep the given registers' values after a reset") {
+        constexpr size_t cUnsavedRegId{2};
+
+        std::array<reg_id_t, 2> const saved_reg_ids{cRegId1, cRegId2};
+        RegisterSnapshots snapshots;
+        handler.append_position(cRegId1, cAppendPos1);
+        handler.append_position(cRegId1, cAppendPos2);
+        auto const first_snapshot{snapshots.save(handler, saved_reg_ids)};
+        handler.reset();
+        handler.append_position(cRegId2, cAppendPos3);
+        handler.append_position(cUnsavedRegId, cAppendPos1);
+        auto const second_snapshot{snapshots.save(handler, saved_reg_ids)};
+        handler.reset();
+
+        auto const first_positions{first_snapshot.get_reversed_positions(cRegId1)};
+        REQUIRE(std::vector<position_t>{cAppendPos2, cAppendPos1}
+                == std::vector<position_t>(first_positions.begin(), first_positions.end()));
+        REQUIRE(first_snapshot.get_reversed_positions(cRegId2).empty());
+        REQUIRE(second_snapshot.get_reversed_positions(cRegId1).empty());
+        auto const second_positions{second_snapshot.get_reversed_positions(cRegId2)};
+        REQUIRE(std::vector<position_t>{cAppendPos3}
+                == std::vector<position_t>(second_positions.begin(), second_positions.end()));
+        // Only the given registers are saved
+        REQUIRE_THROWS_AS(second_snapshot.get_reversed_positions(cUnsavedRegId), std::out_of_range);
+        REQUIRE_THROWS_AS(first_snapshot.get_reversed_positions(cNumRegisters), std::out_of_range);
+        REQUIRE_THROWS_AS(RegisterSnapshot{}.get_reversed_positions(cRegId1), std::out_of_range);
+    }
+
+    SECTION("Single-valued registers only keep their last position") {
+        constexpr position_t cNegativePos{-1};
+
+        auto const single_valued_reg_id{handler.add_register(false)};
+        REQUIRE(handler.is_multi_valued(cRegId1));
+        REQUIRE(false == handler.is_multi_valued(single_valued_reg_id));
+        REQUIRE(handler.get_reversed_positions(single_valued_reg_id).empty());
+
+        handler.append_position(single_valued_reg_id, cNegativePos);
+        REQUIRE(std::vector<position_t>{cNegativePos}
+                == handler.get_reversed_positions(single_valued_reg_id));
+        handler.append_position(single_valued_reg_id, cAppendPos1);
+        handler.append_position(single_valued_reg_id, cAppendPos2);
+        REQUIRE(std::vector<position_t>{cAppendPos2}
+                == handler.get_reversed_positions(single_valued_reg_id));
+
+        auto const copy_reg_id{handler.add_register(false)};
+        handler.copy_register(copy_reg_id, single_valued_reg_id);
+        REQUIRE(std::vector<position_t>{cAppendPos2}
+                == handler.get_reversed_positions(copy_reg_id));
+
+        RegisterSnapshots snapshots;
+        std::array<reg_id_t, 1> const saved_reg_ids{static_cast<reg_id_t>(single_valued_reg_id)};
+        auto const snapshot{snapshots.save(handler, saved_reg_ids)};
+        handler.reset();
+        REQUIRE(handler.get_reversed_positions(single_valued_reg_id).empty());
+        auto const positions{snapshot.get_reversed_positions(single_valued_reg_id)};
+        REQUIRE(std::vector<position_t>{cAppendPos2}
+                == std::vector<position_t>(positions.begin(), positions.end()));
+    }
 }
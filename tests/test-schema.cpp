@@ -1,3 +1,4 @@
+#include <cstddef>
 #include <string>
 #include <string_view>
 
@@ -157,3 +158,18 @@ TEST_CASE("add_invalid_var_priorities", "[Schema]") {
     REQUIRE_THROWS_AS(schema.add_variable(cVarString3, invalidPos1), std::invalid_argument);
     REQUIRE_THROWS_AS(schema.add_variable(cVarString3, invalidPos2), std::invalid_argument);
 }
+
+/**
+ * @ingroup unit_tests_schema
+ * @brief Create many schemas, checking that parsing them doesn't use up the parser's buffers.
+ */
+TEST_CASE("add_vars_repeatedly", "[Schema]") {
+    constexpr string_view cVarString{R"(float:\-{0,1}\d+\.\d+)"};
+    constexpr size_t cNumSchemas{300};
+
+    for (size_t i{0}; i < cNumSchemas; ++i) {
+        Schema schema;
+        schema.add_variable(cVarString, -1);
+        REQUIRE(1 == schema.release_schema_ast_ptr()->m_schema_vars.size());
+    }
+}